@@ -0,0 +1,684 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "mutf8.h"
+
+/*
+ * usage: ./bench_main [csv file]
+ *
+ * environment:
+ *   MUTF8_BENCH_MAX_SIZE - largest buffer in bytes( default 268435456)
+ *   MUTF8_BENCH_MIN_TIME - seconds to measure each case( default 0.1)
+ *   MUTF8_BENCH_FILTER   - run only the functions whose name contains this
+ *   MUTF8_BENCH_LABEL    - label of the csv rows, for example the version
+ *
+ * throughput is bytes of the utf8 corpus and characters of the corpus per second,
+ * for the encoders too( their input is the corpus converted beforehand).
+ */
+
+#define BENCH_DEFAULT_MAX_SIZE ((size_t)256 << 20)
+#define BENCH_SAMPLES_MAX 50
+
+struct corpus
+{
+    const char *name;
+    m_char8_t *str; /* null-terminated */
+    size_t size;    /* byte size( not include null-terminated string size) */
+    int64_t chars;  /* m_utf8_mem_display_count */
+    uint32_t *unicode;
+    size_t unicode_size;
+    uint16_t *utf16;
+    size_t utf16_size;
+};
+
+struct scratch
+{
+    m_char8_t *str; /* corpus size * 4 + 1 */
+    uint32_t *unicode;
+    uint16_t *utf16;
+};
+
+typedef int64_t (*bench_fn)(const struct corpus *corpus, struct scratch *scratch);
+
+static volatile int64_t bench_sink;
+
+static uint64_t rand_state = 0x9E3779B97F4A7C15ULL;
+
+static uint32_t bench_rand(void)
+{
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 7;
+    rand_state ^= rand_state << 17;
+    return (uint32_t)(rand_state >> 16);
+}
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* corpus generators, return a code point. */
+
+static uint32_t gen_ascii(void)
+{
+    uint32_t r = bench_rand() % 100;
+    if (r < 15)
+        return ' ';
+    if (r < 16)
+        return '\n';
+    return 'a' + bench_rand() % 26;
+}
+
+static uint32_t gen_latin1(void)
+{
+    if (bench_rand() % 10 < 4)
+        return 0xC0 + bench_rand() % 0x40;
+    return gen_ascii();
+}
+
+static uint32_t gen_cjk(void)
+{
+    uint32_t r = bench_rand() % 100;
+    if (r < 10)
+        return r < 5 ? 0x3001 : ' ';
+    if (r < 40)
+        return 0x3041 + bench_rand() % 0x56;
+    return 0x4E00 + bench_rand() % 0x5000;
+}
+
+static uint32_t gen_emoji(void)
+{
+    static const uint32_t extras[] = {0x200D, 0xFE0F, 0x1F3FB, 0x1F1EF, 0x1F1F5};
+    uint32_t r = bench_rand() % 100;
+    if (r < 15)
+        return ' ';
+    if (r < 30)
+        return extras[bench_rand() % 5];
+    return 0x1F300 + bench_rand() % 0x350;
+}
+
+static uint32_t gen_mixed(void)
+{
+    switch (bench_rand() % 4)
+    {
+    case 0:
+        return gen_ascii();
+    case 1:
+        return gen_latin1();
+    case 2:
+        return gen_cjk();
+    default:
+        return gen_emoji();
+    }
+}
+
+static void corpus_init(struct corpus *corpus, const char *name, uint32_t (*gen)(void), bool invalid, size_t size)
+{
+    m_char8_t *str = malloc(size + 1);
+    size_t str_size = 0;
+
+    while (str_size < size)
+    {
+        m_char8_t character[4];
+        uint8_t ch_byte_size = m_utf8_from_unicode(gen(), character);
+        if (invalid && bench_rand() % 100 == 0)
+        {
+            character[0] = (m_char8_t)(0x80 + bench_rand() % 0x80);
+            ch_byte_size = 1;
+        }
+        if (ch_byte_size == 0 || str_size + ch_byte_size > size)
+        {
+            str[str_size++] = 'a';
+            continue;
+        }
+        memcpy(str + str_size, character, ch_byte_size);
+        str_size += ch_byte_size;
+    }
+    str[size] = '\0';
+
+    corpus->name = name;
+    corpus->str = str;
+    corpus->size = size;
+    corpus->chars = m_utf8_mem_display_count(str, size);
+
+    /* encoder input is the valid prefix. */
+    m_utf8_conv_t conv;
+    corpus->unicode = malloc(sizeof(uint32_t) * (size + 1));
+    m_utf8_mem_to_unicode(str, size, corpus->unicode, size, &conv);
+    corpus->unicode_size = (size_t)conv.dst_written;
+    corpus->utf16 = malloc(sizeof(uint16_t) * (size + 1));
+    m_utf8_mem_to_utf16(str, size, corpus->utf16, size, &conv);
+    corpus->utf16_size = (size_t)conv.dst_written;
+}
+
+static void corpus_free(struct corpus *corpus)
+{
+    free(corpus->str);
+    free(corpus->unicode);
+    free(corpus->utf16);
+}
+
+/* benchmark cases, one or more per public function. */
+
+static int64_t bench_ch_walk(const struct corpus *c, struct scratch *s)
+{
+    (void)s;
+    int64_t sum = 0;
+    for (size_t i = 0; i < c->size;)
+    {
+        uint8_t size = m_utf8_ch_byte_size(c->str + i);
+        sum += m_utf8_ch_validate(c->str + i, size);
+        i += size;
+    }
+    return sum;
+}
+
+static int64_t bench_to_unicode(const struct corpus *c, struct scratch *s)
+{
+    (void)s;
+    int64_t sum = 0;
+    for (size_t i = 0; i < c->size; i += m_utf8_ch_byte_size(c->str + i))
+        sum += m_utf8_to_unicode(c->str + i);
+    return sum;
+}
+
+static int64_t bench_ch_decode(const struct corpus *c, struct scratch *s)
+{
+    (void)s;
+    int64_t sum = 0;
+    for (size_t i = 0; i < c->size;)
+    {
+        uint32_t unicode = 0;
+        uint8_t size = m_utf8_ch_decode(c->str + i, c->size - i, &unicode);
+        sum += unicode;
+        i += size ? size : 1;
+    }
+    return sum;
+}
+
+static int64_t bench_display_width(const struct corpus *c, struct scratch *s)
+{
+    (void)s;
+    int64_t sum = 0;
+    for (size_t i = 0; i < c->size; i += m_utf8_ch_byte_size(c->str + i))
+        sum += m_utf8_display_width(c->str + i);
+    return sum;
+}
+
+static int64_t bench_display_width_profile(const struct corpus *c, struct scratch *s)
+{
+    (void)s;
+    const m_utf8_width_profile_t *profile = m_utf8_width_profile(false, true);
+    int64_t sum = 0;
+    for (size_t i = 0; i < c->size; i += m_utf8_ch_byte_size(c->str + i))
+        sum += m_utf8_display_width_profile(c->str + i, profile);
+    return sum;
+}
+
+static int64_t bench_unicode_width(const struct corpus *c, struct scratch *s)
+{
+    (void)s;
+    int64_t sum = 0;
+    for (size_t i = 0; i < c->unicode_size; i++)
+        sum += m_utf8_unicode_width(c->unicode[i], NULL);
+    return sum;
+}
+
+static int64_t bench_str_byte_size(const struct corpus *c, struct scratch *s)
+{
+    (void)s;
+    return m_utf8_str_byte_size(c->str, c->size + 1);
+}
+
+static int64_t bench_str_validate(const struct corpus *c, struct scratch *s)
+{
+    (void)s;
+    return m_utf8_str_validate(c->str, c->size + 1);
+}
+
+static int64_t bench_str_display_count(const struct corpus *c, struct scratch *s)
+{
+    (void)s;
+    return m_utf8_str_display_count(c->str, c->size + 1);
+}
+
+static int64_t bench_str_stat(const struct corpus *c, struct scratch *s)
+{
+    (void)s;
+    m_utf8_stat_t stat;
+    m_utf8_str_stat(c->str, c->size + 1, NULL, &stat);
+    return stat.display_width;
+}
+
+static int64_t bench_mem_byte_size(const struct corpus *c, struct scratch *s)
+{
+    (void)s;
+    return m_utf8_mem_byte_size(c->str, c->size);
+}
+
+static int64_t bench_mem_validate(const struct corpus *c, struct scratch *s)
+{
+    (void)s;
+    return m_utf8_mem_validate(c->str, c->size);
+}
+
+static int64_t bench_mem_display_count(const struct corpus *c, struct scratch *s)
+{
+    (void)s;
+    return m_utf8_mem_display_count(c->str, c->size);
+}
+
+static int64_t bench_mem_stat(const struct corpus *c, struct scratch *s)
+{
+    (void)s;
+    m_utf8_stat_t stat;
+    m_utf8_mem_stat(c->str, c->size, NULL, &stat);
+    return stat.display_width;
+}
+
+static int64_t bench_mem_validate_parallel(const struct corpus *c, struct scratch *s)
+{
+    (void)s;
+    return m_utf8_mem_validate_parallel(c->str, c->size, 0);
+}
+
+static int64_t bench_mem_display_count_parallel(const struct corpus *c, struct scratch *s)
+{
+    (void)s;
+    return m_utf8_mem_display_count_parallel(c->str, c->size, 0);
+}
+
+static int64_t bench_mem_stat_parallel(const struct corpus *c, struct scratch *s)
+{
+    (void)s;
+    m_utf8_stat_t stat;
+    m_utf8_mem_stat_parallel(c->str, c->size, NULL, &stat, 0);
+    return stat.display_width;
+}
+
+static int64_t bench_str_validate_parallel(const struct corpus *c, struct scratch *s)
+{
+    (void)s;
+    return m_utf8_str_validate_parallel(c->str, c->size + 1, 0);
+}
+
+static int64_t bench_mem_to_unicode(const struct corpus *c, struct scratch *s)
+{
+    m_utf8_conv_t conv;
+    m_utf8_mem_to_unicode(c->str, c->size, s->unicode, c->size, &conv);
+    return conv.dst_written;
+}
+
+static int64_t bench_mem_utf16_size(const struct corpus *c, struct scratch *s)
+{
+    (void)s;
+    return m_utf8_mem_utf16_size(c->str, c->size);
+}
+
+static int64_t bench_mem_to_utf16(const struct corpus *c, struct scratch *s)
+{
+    m_utf8_conv_t conv;
+    m_utf8_mem_to_utf16(c->str, c->size, s->utf16, c->size, &conv);
+    return conv.dst_written;
+}
+
+static int64_t bench_from_unicode(const struct corpus *c, struct scratch *s)
+{
+    int64_t sum = 0;
+    for (size_t i = 0; i < c->unicode_size; i++)
+        sum += m_utf8_from_unicode(c->unicode[i], s->str);
+    return sum;
+}
+
+static int64_t bench_size_from_unicode(const struct corpus *c, struct scratch *s)
+{
+    (void)s;
+    return m_utf8_size_from_unicode(c->unicode, c->unicode_size);
+}
+
+static int64_t bench_mem_from_unicode(const struct corpus *c, struct scratch *s)
+{
+    m_utf8_conv_t conv;
+    m_utf8_mem_from_unicode(c->unicode, c->unicode_size, s->str, c->size * 4, &conv);
+    return conv.dst_written;
+}
+
+static int64_t bench_size_from_utf16(const struct corpus *c, struct scratch *s)
+{
+    (void)s;
+    return m_utf8_size_from_utf16(c->utf16, c->utf16_size);
+}
+
+static int64_t bench_mem_from_utf16(const struct corpus *c, struct scratch *s)
+{
+    m_utf8_conv_t conv;
+    m_utf8_mem_from_utf16(c->utf16, c->utf16_size, s->str, c->size * 4, &conv);
+    return conv.dst_written;
+}
+
+static int64_t bench_stream_feed(const struct corpus *c, struct scratch *s)
+{
+    (void)s;
+    m_utf8_stream_t stream;
+    m_utf8_stream_init(&stream);
+    /* 4 KiB chunks, same as reading a file. */
+    for (size_t i = 0; i < c->size; i += 4096)
+        m_utf8_stream_feed(&stream, c->str + i, c->size - i < 4096 ? c->size - i : 4096);
+    return m_utf8_stream_finish(&stream);
+}
+
+static int64_t bench_stream_decode(const struct corpus *c, struct scratch *s)
+{
+    m_utf8_stream_t stream;
+    m_utf8_conv_t conv;
+    int64_t sum = 0;
+    m_utf8_stream_init(&stream);
+    for (size_t i = 0; i < c->size; i += 4096)
+    {
+        m_utf8_stream_decode(&stream, c->str + i, c->size - i < 4096 ? c->size - i : 4096, s->unicode, 4096, &conv);
+        sum += conv.dst_written;
+    }
+    return sum + m_utf8_stream_finish(&stream);
+}
+
+static int64_t bench_str_cpy(const struct corpus *c, struct scratch *s)
+{
+    return m_utf8_str_cpy(s->str, c->size + 1, c->str, c->size + 1);
+}
+
+static int64_t bench_str_cpy_size(const struct corpus *c, struct scratch *s)
+{
+    return m_utf8_str_cpy_size(s->str, c->size / 2 + 1, c->str, c->size + 1);
+}
+
+static int64_t bench_str_cat(const struct corpus *c, struct scratch *s)
+{
+    /* 16 appends of 1/16 of the corpus. */
+    size_t part = c->size / 16;
+    s->str[0] = '\0';
+    for (size_t i = 0; i < 16 && part > 0; i++)
+    {
+        m_utf8_str_cat(s->str, c->size + 1, c->str + i * part, part);
+    }
+    return s->str[0];
+}
+
+static int64_t bench_mem_cpy(const struct corpus *c, struct scratch *s)
+{
+    return m_utf8_mem_cpy(s->str, c->size + 1, c->str, c->size);
+}
+
+static int64_t bench_mem_sanitize(const struct corpus *c, struct scratch *s)
+{
+    return m_utf8_mem_sanitize(s->str, c->size * 3, c->str, c->size, M_UTF8_SANITIZE_REPLACE, NULL);
+}
+
+static int64_t bench_mem_normalize(const struct corpus *c, struct scratch *s)
+{
+    m_utf8_conv_t conv;
+    m_utf8_mem_normalize(s->str, c->size * 3, c->str, c->size, M_UTF8_NORM_NFC, &conv);
+    return conv.dst_written;
+}
+
+static int64_t bench_mem_is_normalized(const struct corpus *c, struct scratch *s)
+{
+    (void)s;
+    return m_utf8_mem_is_normalized(c->str, c->size, M_UTF8_NORM_NFC);
+}
+
+/* not in the generated corpora, the whole buffer is searched. */
+#define BENCH_NEEDLE u8"Needle 針"
+
+static int64_t bench_mem_find(const struct corpus *c, struct scratch *s)
+{
+    (void)s;
+    return m_utf8_mem_find(c->str, c->size, BENCH_NEEDLE, strlen(BENCH_NEEDLE), M_UTF8_SEARCH_EXACT, NULL);
+}
+
+static int64_t bench_mem_find_ignore_case(const struct corpus *c, struct scratch *s)
+{
+    (void)s;
+    return m_utf8_mem_find(c->str, c->size, BENCH_NEEDLE, strlen(BENCH_NEEDLE), M_UTF8_SEARCH_IGNORE_CASE, NULL);
+}
+
+static int64_t bench_mem_count(const struct corpus *c, struct scratch *s)
+{
+    (void)s;
+    /* a character of each corpus, matched often. */
+    return m_utf8_mem_count(c->str, c->size, u8"e", 1, M_UTF8_SEARCH_IGNORE_CASE);
+}
+
+static int64_t bench_mem_fit_width(const struct corpus *c, struct scratch *s)
+{
+    m_utf8_stat_t stat;
+    /* one list view line per 64 bytes, cut to 40 columns. */
+    int64_t sum = 0;
+    for (size_t i = 0; i + 64 <= c->size; i += 64)
+    {
+        m_utf8_mem_fit_width(s->str, 128, c->str + i, 64, 40, M_UTF8_ALIGN_LEFT, NULL, NULL, &stat);
+        sum += stat.byte_size;
+    }
+    return sum;
+}
+
+static int64_t bench_mem_ellipsize_width(const struct corpus *c, struct scratch *s)
+{
+    m_utf8_stat_t stat;
+    m_utf8_mem_ellipsize_width(s->str, c->size + 4, c->str, c->size, (size_t)c->chars, NULL, NULL, &stat);
+    return stat.byte_size;
+}
+
+static int64_t bench_mem_grapheme_count(const struct corpus *c, struct scratch *s)
+{
+    (void)s;
+    return m_utf8_mem_grapheme_count(c->str, c->size);
+}
+
+static int64_t bench_str_grapheme_count(const struct corpus *c, struct scratch *s)
+{
+    (void)s;
+    return m_utf8_str_grapheme_count(c->str, c->size + 1);
+}
+
+static int64_t bench_grapheme_next(const struct corpus *c, struct scratch *s)
+{
+    (void)s;
+    int64_t count = 0;
+    for (size_t i = 0; i < c->size; i = (size_t)m_utf8_grapheme_next(c->str, c->size, i))
+        count++;
+    return count;
+}
+
+static int64_t bench_builder(const struct corpus *c, struct scratch *s)
+{
+    m_utf8_builder_t builder;
+    size_t part = c->size / 16;
+    m_utf8_builder_init(&builder, s->str, c->size * 4 + 1);
+    m_utf8_builder_track(&builder, NULL);
+    for (size_t i = 0; i < 16 && part > 0; i++)
+    {
+        m_utf8_builder_append(&builder, c->str + i * part, part);
+        m_utf8_builder_append_int(&builder, (int64_t)i);
+    }
+    return builder.display_width;
+}
+
+static const struct
+{
+    const char *name;
+    bench_fn fn;
+} bench_cases[] = {
+    {"m_utf8_ch_byte_size+m_utf8_ch_validate", bench_ch_walk},
+    {"m_utf8_to_unicode", bench_to_unicode},
+    {"m_utf8_ch_decode", bench_ch_decode},
+    {"m_utf8_display_width", bench_display_width},
+    {"m_utf8_display_width_profile", bench_display_width_profile},
+    {"m_utf8_unicode_width", bench_unicode_width},
+    {"m_utf8_str_byte_size", bench_str_byte_size},
+    {"m_utf8_str_validate", bench_str_validate},
+    {"m_utf8_str_display_count", bench_str_display_count},
+    {"m_utf8_str_stat", bench_str_stat},
+    {"m_utf8_mem_byte_size", bench_mem_byte_size},
+    {"m_utf8_mem_validate", bench_mem_validate},
+    {"m_utf8_mem_display_count", bench_mem_display_count},
+    {"m_utf8_mem_stat", bench_mem_stat},
+    {"m_utf8_mem_validate_parallel", bench_mem_validate_parallel},
+    {"m_utf8_mem_display_count_parallel", bench_mem_display_count_parallel},
+    {"m_utf8_mem_stat_parallel", bench_mem_stat_parallel},
+    {"m_utf8_str_validate_parallel", bench_str_validate_parallel},
+    {"m_utf8_mem_to_unicode", bench_mem_to_unicode},
+    {"m_utf8_mem_utf16_size", bench_mem_utf16_size},
+    {"m_utf8_mem_to_utf16", bench_mem_to_utf16},
+    {"m_utf8_from_unicode", bench_from_unicode},
+    {"m_utf8_size_from_unicode", bench_size_from_unicode},
+    {"m_utf8_mem_from_unicode", bench_mem_from_unicode},
+    {"m_utf8_size_from_utf16", bench_size_from_utf16},
+    {"m_utf8_mem_from_utf16", bench_mem_from_utf16},
+    {"m_utf8_stream_feed", bench_stream_feed},
+    {"m_utf8_stream_decode", bench_stream_decode},
+    {"m_utf8_str_cpy", bench_str_cpy},
+    {"m_utf8_str_cpy_size", bench_str_cpy_size},
+    {"m_utf8_str_cat", bench_str_cat},
+    {"m_utf8_mem_cpy", bench_mem_cpy},
+    {"m_utf8_mem_sanitize", bench_mem_sanitize},
+    {"m_utf8_mem_normalize", bench_mem_normalize},
+    {"m_utf8_mem_is_normalized", bench_mem_is_normalized},
+    {"m_utf8_mem_find", bench_mem_find},
+    {"m_utf8_mem_find_ignore_case", bench_mem_find_ignore_case},
+    {"m_utf8_mem_count", bench_mem_count},
+    {"m_utf8_mem_fit_width", bench_mem_fit_width},
+    {"m_utf8_mem_ellipsize_width", bench_mem_ellipsize_width},
+    {"m_utf8_mem_grapheme_count", bench_mem_grapheme_count},
+    {"m_utf8_str_grapheme_count", bench_str_grapheme_count},
+    {"m_utf8_grapheme_next", bench_grapheme_next},
+    {"m_utf8_builder_append", bench_builder},
+};
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * run fn in batches of calls, a batch is long enough for the clock.
+ * return the median seconds per call.
+ */
+static double bench_measure(bench_fn fn, const struct corpus *corpus, struct scratch *scratch, double min_time,
+                            int64_t *calls)
+{
+    double samples[BENCH_SAMPLES_MAX];
+    int64_t batch = 1;
+    double elapsed;
+
+    /* warmup and calibration. */
+    for (;;)
+    {
+        double start = bench_now();
+        for (int64_t i = 0; i < batch; i++)
+            bench_sink += fn(corpus, scratch);
+        elapsed = bench_now() - start;
+        if (elapsed >= 1e-3 || batch >= (1 << 24))
+            break;
+        batch *= 2;
+    }
+
+    int sample_count = (int)(min_time / elapsed);
+    if (sample_count < 3)
+        sample_count = 3;
+    if (sample_count > BENCH_SAMPLES_MAX)
+        sample_count = BENCH_SAMPLES_MAX;
+    for (int i = 0; i < sample_count; i++)
+    {
+        double start = bench_now();
+        for (int64_t j = 0; j < batch; j++)
+            bench_sink += fn(corpus, scratch);
+        samples[i] = (bench_now() - start) / (double)batch;
+    }
+    qsort(samples, (size_t)sample_count, sizeof(double), compare_double);
+
+    *calls = batch * sample_count;
+    return samples[sample_count / 2];
+}
+
+int main(int argc, char *argv[])
+{
+    static const struct
+    {
+        const char *name;
+        uint32_t (*gen)(void);
+        bool invalid;
+    } kinds[] = {
+        {"ascii", gen_ascii, false}, {"latin1", gen_latin1, false}, {"cjk", gen_cjk, false},
+        {"emoji", gen_emoji, false}, {"mixed", gen_mixed, false},   {"invalid", gen_mixed, true},
+    };
+    static const size_t sizes[] = {16, 256, 4 << 10, 64 << 10, 1 << 20, 16 << 20, 256 << 20};
+
+    const char *csv_path = argc > 1 ? argv[1] : "bench_output.txt";
+    const char *env = getenv("MUTF8_BENCH_MAX_SIZE");
+    size_t max_size = env ? (size_t)strtoull(env, NULL, 10) : BENCH_DEFAULT_MAX_SIZE;
+    env = getenv("MUTF8_BENCH_MIN_TIME");
+    double min_time = env ? atof(env) : 0.1;
+    const char *filter = getenv("MUTF8_BENCH_FILTER");
+    const char *label = getenv("MUTF8_BENCH_LABEL");
+
+    FILE *csv = fopen(csv_path, "w");
+    if (csv == NULL)
+    {
+        perror(csv_path);
+        return 1;
+    }
+    fprintf(csv, "label,function,corpus,bytes,chars,calls,ns_per_call,gb_per_s,mchars_per_s\n");
+    static const char *const simd_names[] = {"scalar", "sse2", "avx2", "avx512"};
+    printf("simd: %s\n", simd_names[m_utf8_simd_level()]);
+    printf("%-40s %-8s %10s %14s %10s %12s\n", "function", "corpus", "bytes", "ns/call", "GB/s", "Mchars/s");
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]) && sizes[s] <= max_size; s++)
+    {
+        struct scratch scratch;
+        scratch.str = malloc(sizes[s] * 4 + 1);
+        scratch.unicode = malloc(sizeof(uint32_t) * (sizes[s] + 4096));
+        scratch.utf16 = malloc(sizeof(uint16_t) * (sizes[s] + 1));
+        if (scratch.str == NULL || scratch.unicode == NULL || scratch.utf16 == NULL)
+        {
+            fprintf(stderr, "bench: %zu bytes buffer is not allocated\n", sizes[s]);
+            return 1;
+        }
+
+        for (size_t k = 0; k < sizeof(kinds) / sizeof(kinds[0]); k++)
+        {
+            struct corpus corpus;
+            corpus_init(&corpus, kinds[k].name, kinds[k].gen, kinds[k].invalid, sizes[s]);
+
+            for (size_t b = 0; b < sizeof(bench_cases) / sizeof(bench_cases[0]); b++)
+            {
+                if (filter != NULL && strstr(bench_cases[b].name, filter) == NULL)
+                    continue;
+
+                int64_t calls;
+                double seconds = bench_measure(bench_cases[b].fn, &corpus, &scratch, min_time, &calls);
+                double gb_per_s = (double)corpus.size / seconds / 1e9;
+                double mchars_per_s = (double)corpus.chars / seconds / 1e6;
+                printf("%-40s %-8s %10zu %14.1f %10.3f %12.1f\n", bench_cases[b].name, corpus.name, corpus.size,
+                       seconds * 1e9, gb_per_s, mchars_per_s);
+                fprintf(csv, "%s,%s,%s,%zu,%lld,%lld,%.1f,%.4f,%.2f\n", label ? label : "", bench_cases[b].name,
+                        corpus.name, corpus.size, (long long)corpus.chars, (long long)calls, seconds * 1e9, gb_per_s,
+                        mchars_per_s);
+                fflush(csv);
+            }
+            corpus_free(&corpus);
+        }
+        free(scratch.str);
+        free(scratch.unicode);
+        free(scratch.utf16);
+    }
+
+    fclose(csv);
+    return 0;
+}
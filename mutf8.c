@@ -1,452 +1,332 @@
 #include <stdio.h>
+#include <stdarg.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
-#include <locale.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#if defined(__GNUC__)
+#define M_UTF8_SIMD_DISPATCH
+#endif
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 #include "mutf8.h"
-
-/**
- * @private
- * @var uint8_t m_utf8_jump_table[256]
- * @author Atsushi Enomoto  <atsushi@ximian.com>
- * @sa https://github.com/corngood/mono/blob/master/eglib/src/gutf8.c
- * 
- * @note
- *  base var is "const guchar g_utf8_jump_table[256]".
- */
-/*
- * Index into the table below with the first byte of a UTF-8 sequence to get
- * the number of bytes that are supposed to follow it to complete the sequence.
- *
- * Note that *legal* UTF-8 values can't have 5-bytes or 6-bytes. The table is left
- * as-is for anyone who may want to do such conversion, which was allowed in
- * earlier algorithms.
-*/
-static const uint8_t m_utf8_jump_table[256] = {
-    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
-    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4, 5, 5, 5, 5, 6, 6, 1, 1};
+#include "mutf8_inline.h"
+#include "mutf8_stats.h"
 
 /**
  * @public
- * @fn uint8_t m_utf8_ch_byte_size(const m_char8_t *character)
- * @brief utf8 character byte size
- * @param[in] character - utf8 character
- * @return utf8 character byte size
+ * @fn int64_t m_utf8_str_byte_size(const m_char8_t *str, size_t max_str_bytesize)
+ * @brief utf8 string byte size
+ * @param[in] str - utf8 string
+ * @param[in] max_str_bytesize - utf8 string byte size( add null-terminated string size)
+ * @return string byte size( add null-terminated string size)
+ * @author FUNABARA Masao
  * @note
- *   do not use null-terminated string.
- *   that *legal* UTF-8 values can't have 5-bytes or 6-bytes.
+ *   add null-terminated string size.
  */
-uint8_t m_utf8_ch_byte_size(const m_char8_t *character)
+int64_t m_utf8_str_byte_size(const m_char8_t *str, size_t max_str_bytesize)
 {
-    return m_utf8_jump_table[(uint8_t)(*character)];
+    const int64_t max_size = (int64_t)max_str_bytesize;
+    int64_t str_size = 0;
+    uint8_t size = 0;
+
+    while (*str && str_size < max_size)
+    {
+        size = m_utf8_ch_byte_size(str);
+        str_size += size;
+        str += size;
+    }
+
+    if (str_size >= max_size)
+    {
+        str_size -= size;
+    }
+    if (max_size > 0)
+    {
+        str_size += 1;
+    }
+    return str_size;
 }
 
 /**
- * @public
- * @fn bool m_utf8_ch_validate(const m_char8_t *character, size_t character_bytesize)
- * @brief utf8 character validate
- * @param[in] character - utf8 character
- * @param[in] character_bytesize - utf8 character byte size
- * @return true valid, false invalid
- * @author Atsushi Enomoto  <atsushi@ximian.com>
- * @sa https://github.com/corngood/mono/blob/master/eglib/src/gutf8.c
+ * @private
+ * @fn static size_t m_utf8_valid_length_scalar(const uint8_t *str, size_t str_bytesize)
+ * @brief length of the valid utf8 prefix
+ * @param[in] str - utf8 string
+ * @param[in] str_bytesize - utf8 string byte size( not include null-terminated string size)
+ * @return byte offset of the first invalid character, str_bytesize when all valid.
  * @note
- *   do not use null-terminated string.
- *   base function is "static gboolean utf8_validate (const unsigned char *inptr, size_t len)".
+ *   a character truncated by str_bytesize is invalid.
  */
-bool m_utf8_ch_validate(const m_char8_t *character, size_t character_size)
+static size_t m_utf8_valid_length_scalar(const uint8_t *str, size_t str_bytesize)
 {
-    uint8_t *inptr = (uint8_t *)character;
-    const uint8_t *ptr = inptr + character_size;
-    uint8_t c;
+    size_t str_size = 0;
 
-    /* Everything falls through when TRUE... */
-    switch (character_size)
+    while (str_size < str_bytesize)
     {
-    default:
-        return false;
-    case 4:
-        if ((c = (*--ptr)) < 0x80 || c > 0xBF)
-            return false;
-
-        if ((c == 0xBF || c == 0xBE) && ptr[-1] == 0xBF)
+        if (str[str_size] < 0x80)
         {
-            if (ptr[-2] == 0x8F || ptr[-2] == 0x9F ||
-                ptr[-2] == 0xAF || ptr[-2] == 0xBF)
-                return false;
+            M_UTF8_STATS_CHAR(1);
+            str_size++;
+            continue;
         }
-        /* fall through */
-    case 3:
-        if ((c = (*--ptr)) < 0x80 || c > 0xBF)
-            return false;
-        /* fall through */
-    case 2:
-        if ((c = (*--ptr)) < 0x80 || c > 0xBF)
-            return false;
-
-        /* no fall-through in this inner switch */
-        switch (*inptr)
+        uint8_t ch_byte_size = m_utf8_jump_table[str[str_size]];
+        if (ch_byte_size > str_bytesize - str_size ||
+            m_utf8_ch_validate((const m_char8_t *)str + str_size, ch_byte_size) == false)
         {
-        case 0xE0:
-            if (c < 0xA0)
-                return false;
-            break;
-        case 0xED:
-            if (c > 0x9F)
-                return false;
-            break;
-        case 0xEF:
-            if (c == 0xB7 && (ptr[1] > 0x8F && ptr[1] < 0xB0))
-                return false;
-            if (c == 0xBF && (ptr[1] == 0xBE || ptr[1] == 0xBF))
-                return false;
-            break;
-        case 0xF0:
-            if (c < 0x90)
-                return false;
-            break;
-        case 0xF4:
-            if (c > 0x8F)
-                return false;
-            break;
-        default:
-            if (c < 0x80)
-                return false;
-            break;
+            return str_size;
         }
-    case 1:
-        if (*inptr >= 0x80 && *inptr < 0xC2)
-            return false;
+        M_UTF8_STATS_CHAR(ch_byte_size);
+        str_size += ch_byte_size;
     }
 
-    if (*inptr > 0xF4)
-        return false;
-
-    return true;
+    return str_size;
 }
 
+#if defined(M_UTF8_SIMD_DISPATCH)
 /**
- * @public
- * @fn uint32_t m_utf8_to_unicode(const m_char8_t *character)
- * @brief utf8 character convert to unicode
- * @param[in] character  - utf8 character
- * @return unicode, and convert to 0 when failed.
- * @author FUNABARA Masao
+ * @private
+ * @fn static size_t m_utf8_valid_length_resume(const uint8_t *str, size_t str_bytesize, size_t checked_size)
+ * @brief length of the valid utf8 prefix, continued from a vector loop
+ * @param[in] str - utf8 string
+ * @param[in] str_bytesize - utf8 string byte size( not include null-terminated string size)
+ * @param[in] checked_size - bytes already checked by a vector loop
+ * @return byte offset of the first invalid character, str_bytesize when all valid.
+ * @note
+ *   the vector loops check every byte pair inside [0, checked_size), but a lead byte
+ *   in the last 3 bytes is not checked against the bytes that follow it.
+ *   so step back to that lead byte and finish with the scalar loop.
  */
-uint32_t m_utf8_to_unicode(const m_char8_t *character)
+static size_t m_utf8_valid_length_resume(const uint8_t *str, size_t str_bytesize, size_t checked_size)
 {
-    uint8_t *inptr = (uint8_t *)character;
-    uint8_t character_size = m_utf8_ch_byte_size(character);
+    size_t start = checked_size;
 
-    bool result = m_utf8_ch_validate(character, character_size);
-    if (result == false)
+    for (size_t i = checked_size; i > 0 && i + 3 > checked_size; i--)
     {
-        return 0;
+        uint8_t c = str[i - 1];
+        if ((c & 0xC0) == 0x80)
+            continue;
+        if (c >= 0xC0)
+            start = i - 1;
+        break;
     }
 
-    uint8_t *ptr = inptr + (character_size - 1);
-    uint32_t unicode = 0;
-    uint32_t shift_size = 0;
-    uint8_t mask = 0x00;
-    switch (character_size)
-    {
-    default:
-        return 0;
-    case 4:
-        mask = 0x3F;
-        unicode = (*ptr & mask);
-        ptr--;
-        /* fall through */
-    case 3:
-        mask = 0x3F;
-        if (character_size == 4)
-            shift_size = 6;
-        if (character_size == 3)
-            shift_size = 0;
-        unicode += ((*ptr & mask) << shift_size);
-        ptr--;
-        /* fall through */
-    case 2:
-        mask = 0x3F;
-        if (character_size == 4)
-            shift_size = 12;
-        if (character_size == 3)
-            shift_size = 6;
-        if (character_size == 2)
-            shift_size = 0;
-        unicode += ((*ptr & mask) << shift_size);
-        ptr--;
-        /* fall through */
-    case 1:
-        if (character_size == 4)
-        {
-            mask = 0x0F;
-            shift_size = 18;
-        }
-        if (character_size == 3)
-        {
-            mask = 0x1F;
-            shift_size = 12;
-        }
-        if (character_size == 2)
-        {
-            mask = 0x3F;
-            shift_size = 6;
-        }
-        if (character_size == 1)
-        {
-            mask = 0xFF;
-            shift_size = 0;
-        }
-        unicode += ((*ptr & mask) << shift_size);
-    }
-    return unicode;
+    return start + m_utf8_valid_length_scalar(str + start, str_bytesize - start);
 }
 
+/* error flags of the lookup tables. */
+#define M_UTF8_TOO_SHORT (1 << 0)      /* 11______ 0_______, 11______ 11______ */
+#define M_UTF8_TOO_LONG (1 << 1)       /* 0_______ 10______ */
+#define M_UTF8_OVERLONG_3 (1 << 2)     /* 11100000 100_____ */
+#define M_UTF8_TOO_LARGE (1 << 3)      /* 11110100 1001____, 11110100 101_____, 11110101 1001____, ... */
+#define M_UTF8_SURROGATE (1 << 4)      /* 11101101 101_____ */
+#define M_UTF8_OVERLONG_2 (1 << 5)     /* 1100000_ 10______ */
+#define M_UTF8_TOO_LARGE_1000 (1 << 6) /* 11110101 1000____, ... */
+#define M_UTF8_OVERLONG_4 (1 << 6)     /* 11110000 1000____ */
+#define M_UTF8_TWO_CONTS (1 << 7)      /* 10______ 10______ */
+#define M_UTF8_CARRY (M_UTF8_TOO_SHORT | M_UTF8_TOO_LONG | M_UTF8_TWO_CONTS)
+
 /**
  * @private
- * @var te
- * @author cxxxr
- * @sa https://github.com/cxxxr/uemacs/blob/master/utf8.c
- * @note
- *   base struct is "struct te".
+ * @fn static inline __m256i m_utf8_prev_avx2(__m256i input, __m256i prev_input, int n)
+ * @brief shift input n bytes and fill with the end of prev_input
  */
-struct te
-{
-    uint32_t a;
-    uint32_t b;
-};
+#define m_utf8_prev_avx2(input, prev_input, n) \
+    _mm256_alignr_epi8((input), _mm256_permute2x128_si256((prev_input), (input), 0x21), 16 - (n))
+#endif
 
-// clang-format off
-/**
- * @private
- * @var static struct te eastasian_full[]
- * @author cxxxr
- * @sa https://github.com/cxxxr/uemacs/blob/master/utf8.c
- * @note
- *   base var is "te eastasian_full[]".
- */
-static struct te eastasian_full[] = {
-    {0x01100,0x0115f}, {0x02329,0x0232a}, {0x02e80,0x02e99}, {0x02e9b,0x02ef3},
-    {0x02f00,0x02fd5}, {0x02ff0,0x02ffb}, {0x03000,0x0303e}, {0x03041,0x03096},
-    {0x03099,0x030ff}, {0x03105,0x0312d}, {0x03131,0x0318e}, {0x03190,0x031ba},
-    {0x031c0,0x031e3}, {0x031f0,0x0321e}, {0x03220,0x03247}, {0x03250,0x032fe},
-    {0x03300,0x04dbf}, {0x04e00,0x0a48c}, {0x0a490,0x0a4c6}, {0x0a960,0x0a97c},
-    {0x0ac00,0x0d7a3}, {0x0f900,0x0faff}, {0x0fe10,0x0fe19}, {0x0fe30,0x0fe52},
-    {0x0fe54,0x0fe66}, {0x0fe68,0x0fe6b}, {0x0ff01,0x0ff60}, {0x0ffe0,0x0ffe6},
-    {0x1b000,0x1b001}, {0x1f200,0x1f202}, {0x1f210,0x1f23a}, {0x1f240,0x1f248},
-    {0x1f250,0x1f251}, {0x20000,0x2fffd}, {0x30000,0x3fffd}
-};
+#define M_UTF8_KERNEL_LEVEL 0
+#include "mutf8_kernels.h"
+#if defined(M_UTF8_SIMD_DISPATCH)
+#define M_UTF8_KERNEL_LEVEL 1
+#include "mutf8_kernels.h"
+#define M_UTF8_KERNEL_LEVEL 2
+#include "mutf8_kernels.h"
+#define M_UTF8_KERNEL_LEVEL 3
+#include "mutf8_kernels.h"
+#endif
 
 /**
  * @private
- * @var struct te eastasian_ambiguous[]
- * @author cxxxr
- * @sa https://github.com/cxxxr/uemacs/blob/master/utf8.c
- * @note
- *   base var is "te eastasian_ambiguous[]".
- */
-static struct te eastasian_ambiguous[] = {
-    {0x000a1,0x000a1}, {0x000a4,0x000a4}, {0x000a7,0x000a8}, {0x000aa,0x000aa},
-    {0x000ad,0x000ae}, {0x000b0,0x000b4}, {0x000b6,0x000ba}, {0x000bc,0x000bf},
-    {0x000c6,0x000c6}, {0x000d0,0x000d0}, {0x000d7,0x000d8}, {0x000de,0x000e1},
-    {0x000e6,0x000e6}, {0x000e8,0x000ea}, {0x000ec,0x000ed}, {0x000f0,0x000f0},
-    {0x000f2,0x000f3}, {0x000f7,0x000fa}, {0x000fc,0x000fc}, {0x000fe,0x000fe},
-    {0x00101,0x00101}, {0x00111,0x00111}, {0x00113,0x00113}, {0x0011b,0x0011b},
-    {0x00126,0x00127}, {0x0012b,0x0012b}, {0x00131,0x00133}, {0x00138,0x00138},
-    {0x0013f,0x00142}, {0x00144,0x00144}, {0x00148,0x0014b}, {0x0014d,0x0014d},
-    {0x00152,0x00153}, {0x00166,0x00167}, {0x0016b,0x0016b}, {0x001ce,0x001ce},
-    {0x001d0,0x001d0}, {0x001d2,0x001d2}, {0x001d4,0x001d4}, {0x001d6,0x001d6},
-    {0x001d8,0x001d8}, {0x001da,0x001da}, {0x001dc,0x001dc}, {0x00251,0x00251},
-    {0x00261,0x00261}, {0x002c4,0x002c4}, {0x002c7,0x002c7}, {0x002c9,0x002cb},
-    {0x002cd,0x002cd}, {0x002d0,0x002d0}, {0x002d8,0x002db}, {0x002dd,0x002dd},
-    {0x002df,0x002df}, {0x00300,0x0036f}, {0x00391,0x003a1}, {0x003a3,0x003a9},
-    {0x003b1,0x003c1}, {0x003c3,0x003c9}, {0x00401,0x00401}, {0x00410,0x0044f},
-    {0x00451,0x00451}, {0x02010,0x02010}, {0x02013,0x02016}, {0x02018,0x02019},
-    {0x0201c,0x0201d}, {0x02020,0x02022}, {0x02024,0x02027}, {0x02030,0x02030},
-    {0x02032,0x02033}, {0x02035,0x02035}, {0x0203b,0x0203b}, {0x0203e,0x0203e},
-    {0x02074,0x02074}, {0x0207f,0x0207f}, {0x02081,0x02084}, {0x020ac,0x020ac},
-    {0x02103,0x02103}, {0x02105,0x02105}, {0x02109,0x02109}, {0x02113,0x02113},
-    {0x02116,0x02116}, {0x02121,0x02122}, {0x02126,0x02126}, {0x0212b,0x0212b},
-    {0x02153,0x02154}, {0x0215b,0x0215e}, {0x02160,0x0216b}, {0x02170,0x02179},
-    {0x02189,0x02189}, {0x02190,0x02199}, {0x021b8,0x021b9}, {0x021d2,0x021d2},
-    {0x021d4,0x021d4}, {0x021e7,0x021e7}, {0x02200,0x02200}, {0x02202,0x02203},
-    {0x02207,0x02208}, {0x0220b,0x0220b}, {0x0220f,0x0220f}, {0x02211,0x02211},
-    {0x02215,0x02215}, {0x0221a,0x0221a}, {0x0221d,0x02220}, {0x02223,0x02223},
-    {0x02225,0x02225}, {0x02227,0x0222c}, {0x0222e,0x0222e}, {0x02234,0x02237},
-    {0x0223c,0x0223d}, {0x02248,0x02248}, {0x0224c,0x0224c}, {0x02252,0x02252},
-    {0x02260,0x02261}, {0x02264,0x02267}, {0x0226a,0x0226b}, {0x0226e,0x0226f},
-    {0x02282,0x02283}, {0x02286,0x02287}, {0x02295,0x02295}, {0x02299,0x02299},
-    {0x022a5,0x022a5}, {0x022bf,0x022bf}, {0x02312,0x02312}, {0x02460,0x024e9},
-    {0x024eb,0x0254b}, {0x02550,0x02573}, {0x02580,0x0258f}, {0x02592,0x02595},
-    {0x025a0,0x025a1}, {0x025a3,0x025a9}, {0x025b2,0x025b3}, {0x025b6,0x025b7},
-    {0x025bc,0x025bd}, {0x025c0,0x025c1}, {0x025c6,0x025c8}, {0x025cb,0x025cb},
-    {0x025ce,0x025d1}, {0x025e2,0x025e5}, {0x025ef,0x025ef}, {0x02605,0x02606},
-    {0x02609,0x02609}, {0x0260e,0x0260f}, {0x02614,0x02615}, {0x0261c,0x0261c},
-    {0x0261e,0x0261e}, {0x02640,0x02640}, {0x02642,0x02642}, {0x02660,0x02661},
-    {0x02663,0x02665}, {0x02667,0x0266a}, {0x0266c,0x0266d}, {0x0266f,0x0266f},
-    {0x0269e,0x0269f}, {0x026be,0x026bf}, {0x026c4,0x026cd}, {0x026cf,0x026e1},
-    {0x026e3,0x026e3}, {0x026e8,0x026ff}, {0x0273d,0x0273d}, {0x02757,0x02757},
-    {0x02776,0x0277f}, {0x02b55,0x02b59}, {0x03248,0x0324f}, {0x0e000,0x0f8ff},
-    {0x0fe00,0x0fe0f}, {0x0fffd,0x0fffd}, {0x1f100,0x1f10a}, {0x1f110,0x1f12d},
-    {0x1f130,0x1f169}, {0x1f170,0x1f19a}, {0xe0100,0xe01ef}, {0xf0000,0xffffd},
-    {0x100000,0x10fffd}
+ * @struct m_utf8_kernels
+ * @brief kernels of a SIMD level, see mutf8_kernels.h
+ */
+struct m_utf8_kernels
+{
+    size_t (*valid_length)(const uint8_t *str, size_t str_bytesize);
+    void (*stat_scan)(const uint8_t *str, size_t str_bytesize, bool truncated, const m_utf8_width_profile_t *profile,
+                      m_utf8_stat_t *stat);
+    int64_t (*count_scan)(const uint8_t *str, size_t str_bytesize);
+    void (*to_unicode_scan)(const uint8_t *str, size_t str_bytesize, uint32_t *dst, size_t dst_size,
+                            m_utf8_conv_t *conv);
+    void (*to_utf16_scan)(const uint8_t *str, size_t str_bytesize, uint16_t *dst, size_t dst_size,
+                          m_utf8_conv_t *conv);
 };
 
+#define M_UTF8_KERNELS(level)                                                                                  \
+    {                                                                                                          \
+        m_utf8_valid_length_##level, m_utf8_stat_scan_##level, m_utf8_count_scan_##level,                      \
+            m_utf8_to_unicode_scan_##level, m_utf8_to_utf16_scan_##level                                       \
+    }
+
 /**
  * @private
- * @var static struct te emoji_cjk[]
- * @author FUNABARA Masao
- * @sa http://unicode.org/emoji/charts/emoji-list.html
- */
-static struct te emoji_cjk[] = {
-    {0x1f004,0x1f004}, {0x1f0cf,0x1f0cf}, {0x1f170,0x1f171}, {0x1f17e,0x1f17e},
-    {0x1f17f,0x1f17f}, {0x1f18e,0x1f18e}, {0x1f191,0x1f19a}, {0x1f201,0x1f202},
-    {0x1f21a,0x1f21a}, {0x1f22f,0x1f22f}, {0x1f232,0x1f23a}, {0x1f250,0x1f251},
-    {0x1f300,0x1f320}, {0x1f321,0x1f321}, {0x1f324,0x1f32c}, {0x1f32d,0x1f32f},
-    {0x1f330,0x1f335}, {0x1f336,0x1f336}, {0x1f337,0x1f37c}, {0x1f37d,0x1f37d},
-    {0x1f37e,0x1f37f}, {0x1f380,0x1f393}, {0x1f396,0x1f397}, {0x1f399,0x1f39b},
-    {0x1f39e,0x1f39f}, {0x1f3a0,0x1f3c4}, {0x1f3c5,0x1f3c5}, {0x1f3c6,0x1f3ca},
-    {0x1f3cb,0x1f3ce}, {0x1f3cf,0x1f3d3}, {0x1f3d4,0x1f3df}, {0x1f3e0,0x1f3f0},
-    {0x1f3f3,0x1f3f5}, {0x1f3f7,0x1f3f7}, {0x1f3f8,0x1f3ff}, {0x1f400,0x1f43e},
-    {0x1f43f,0x1f43f}, {0x1f440,0x1f440}, {0x1f441,0x1f441}, {0x1f442,0x1f4f7},
-    {0x1f4f8,0x1f4f8}, {0x1f4f9,0x1f4fc}, {0x1f4fd,0x1f4fd}, {0x1f4ff,0x1f4ff},
-    {0x1f500,0x1f53d}, {0x1f549,0x1f54a}, {0x1f54b,0x1f54e}, {0x1f550,0x1f567},
-    {0x1f56f,0x1f570}, {0x1f573,0x1f579}, {0x1f57a,0x1f57a}, {0x1f587,0x1f587},
-    {0x1f58a,0x1f58d}, {0x1f590,0x1f590}, {0x1f595,0x1f596}, {0x1f5a4,0x1f5a4},
-    {0x1f5a5,0x1f5a5}, {0x1f5a8,0x1f5a8}, {0x1f5b1,0x1f5b2}, {0x1f5bc,0x1f5bc},
-    {0x1f5c2,0x1f5c4}, {0x1f5d1,0x1f5d3}, {0x1f5dc,0x1f5de}, {0x1f5e1,0x1f5e1},
-    {0x1f5e3,0x1f5e3}, {0x1f5e8,0x1f5e8}, {0x1f5ef,0x1f5ef}, {0x1f5f3,0x1f5f3},
-    {0x1f5fa,0x1f5fa}, {0x1f5fb,0x1f5ff}, {0x1f600,0x1f600}, {0x1f601,0x1f610},
-    {0x1f611,0x1f611}, {0x1f612,0x1f614}, {0x1f615,0x1f615}, {0x1f616,0x1f616},
-    {0x1f617,0x1f617}, {0x1f618,0x1f618}, {0x1f619,0x1f619}, {0x1f61a,0x1f61a},
-    {0x1f61b,0x1f61b}, {0x1f61c,0x1f61e}, {0x1f61f,0x1f61f}, {0x1f620,0x1f625},
-    {0x1f626,0x1f627}, {0x1f628,0x1f62b}, {0x1f62c,0x1f62c}, {0x1f62d,0x1f62d},
-    {0x1f62e,0x1f62f}, {0x1f630,0x1f633}, {0x1f634,0x1f634}, {0x1f635,0x1f640},
-    {0x1f641,0x1f642}, {0x1f643,0x1f644}, {0x1f645,0x1f64f}, {0x1f680,0x1f6c5},
-    {0x1f6cb,0x1f6cf}, {0x1f6d0,0x1f6d0}, {0x1f6d1,0x1f6d2}, {0x1f6e0,0x1f6e5},
-    {0x1f6e9,0x1f6e9}, {0x1f6eb,0x1f6ec}, {0x1f6f0,0x1f6f0}, {0x1f6f3,0x1f6f3},
-    {0x1f6f4,0x1f6f6}, {0x1f6f7,0x1f6f7}, {0x1f6f9,0x1f6f9}, {0x1f910,0x1f918},
-    {0x1f919,0x1f91e}, {0x1f91f,0x1f91f}, {0x1f920,0x1f927}, {0x1f928,0x1f92f},
-    {0x1f930,0x1f930}, {0x1f931,0x1f932}, {0x1f933,0x1f93a}, {0x1f93c,0x1f93e},
-    {0x1f940,0x1f945}, {0x1f947,0x1f94b}, {0x1f94c,0x1f94c}, {0x1f94d,0x1f94f},
-    {0x1f950,0x1f95e}, {0x1f95f,0x1f96b}, {0x1f96c,0x1f970}, {0x1f973,0x1f976},
-    {0x1f97a,0x1f97a}, {0x1f97c,0x1f97f}, {0x1f980,0x1f984}, {0x1f985,0x1f991},
-    {0x1f992,0x1f997}, {0x1f998,0x1f9a2}, {0x1f9b0,0x1f9b9}, {0x1f9c0,0x1f9c0},
-    {0x1f9c1,0x1f9c2}, {0x1f9d0,0x1f9e6}, {0x1f9e7,0x1f9ff}
+ * @var m_utf8_kernel_table
+ * @brief kernels indexed by m_utf8_simd_t
+ */
+static const struct m_utf8_kernels m_utf8_kernel_table[] = {
+    M_UTF8_KERNELS(scalar),
+#if defined(M_UTF8_SIMD_DISPATCH)
+    M_UTF8_KERNELS(sse2),
+    M_UTF8_KERNELS(avx2),
+    M_UTF8_KERNELS(avx512),
+#endif
 };
-// clang-format on
 
+/* the level the compiler options already guarantee, used until the CPU is detected. */
+#if defined(M_UTF8_SIMD_DISPATCH) && defined(__AVX512BW__)
+#define M_UTF8_SIMD_BASELINE M_UTF8_SIMD_AVX512
+#elif defined(M_UTF8_SIMD_DISPATCH) && defined(__AVX2__)
+#define M_UTF8_SIMD_BASELINE M_UTF8_SIMD_AVX2
+#elif defined(M_UTF8_SIMD_DISPATCH) && defined(__SSE2__)
+#define M_UTF8_SIMD_BASELINE M_UTF8_SIMD_SSE2
+#else
+#define M_UTF8_SIMD_BASELINE M_UTF8_SIMD_SCALAR
+#endif
+
+static m_utf8_simd_t m_utf8_simd_max = M_UTF8_SIMD_BASELINE;
+static const struct m_utf8_kernels *m_utf8_kernels = &m_utf8_kernel_table[M_UTF8_SIMD_BASELINE];
+
+#if defined(M_UTF8_SIMD_DISPATCH)
 /**
  * @private
- * @fn static int comp_te(const void *key, const void *elt)
- * @author cxxxr
- * @sa https://github.com/cxxxr/uemacs/blob/master/utf8.c
+ * @fn static void m_utf8_simd_init(void)
+ * @brief select the kernels of the best level the CPU supports, once at load time
  * @note
- *   base function is "static int comp_te(const void *key, const void *elt)".
+ *   environment variable MUTF8_SIMD=scalar|sse2|avx2|avx512 selects a lower level.
  */
-static int comp_te(const void *key, const void *elt)
+__attribute__((constructor)) static void m_utf8_simd_init(void)
 {
-    struct te *te = (struct te *)elt;
-    uint32_t *c = (uint32_t *)key;
-    if (*c < te->a)
-        return -1;
-    if (te->a <= *c && *c <= te->b)
-        return 0;
-    return 1;
+    static const char *const names[] = {"scalar", "sse2", "avx2", "avx512"};
+    m_utf8_simd_t level = M_UTF8_SIMD_SCALAR;
+
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2"))
+        level = M_UTF8_SIMD_SSE2;
+    if (level == M_UTF8_SIMD_SSE2 && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+        level = M_UTF8_SIMD_AVX2;
+    if (level == M_UTF8_SIMD_AVX2 && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+        level = M_UTF8_SIMD_AVX512;
+    if (level < m_utf8_simd_max)
+        level = m_utf8_simd_max;
+    m_utf8_simd_max = level;
+
+    const char *env = getenv("MUTF8_SIMD");
+    if (env != NULL)
+    {
+        for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+        {
+            if (strcmp(env, names[i]) == 0 && (m_utf8_simd_t)i < level)
+                level = (m_utf8_simd_t)i;
+        }
+    }
+    m_utf8_kernels = &m_utf8_kernel_table[level];
 }
+#endif
 
 /**
- * @private
- * @fn static int search_table(struct te *table, int size, uint32_t c)
- * @author cxxxr
- * @sa https://github.com/cxxxr/uemacs/blob/master/utf8.c
- * @note
- *   base function is "static int search_table(struct te *table, int size, unicode_t c)".
+ * @public
+ * @fn m_utf8_simd_t m_utf8_simd_supported(void)
+ * @brief the best SIMD level of this CPU and build
+ * @return SIMD level
+ */
+m_utf8_simd_t m_utf8_simd_supported(void)
+{
+    return m_utf8_simd_max;
+}
+
+/**
+ * @public
+ * @fn m_utf8_simd_t m_utf8_simd_level(void)
+ * @brief SIMD level of the kernels in use
+ * @return SIMD level
  */
-static int search_table(struct te *table, int size, uint32_t c)
+m_utf8_simd_t m_utf8_simd_level(void)
 {
-    struct te *res;
-    res = bsearch(&c, table, size, sizeof(struct te), comp_te);
-    return res != NULL;
+    return (m_utf8_simd_t)(m_utf8_kernels - m_utf8_kernel_table);
 }
 
 /**
  * @public
- * @fn size_t m_utf8_display_width(const m_char8_t *character)
- * @author cxxxr
- * @sa https://github.com/cxxxr/uemacs/blob/master/utf8.c
+ * @fn m_utf8_simd_t m_utf8_set_simd_level(m_utf8_simd_t level)
+ * @brief force the SIMD level of the kernels, for testing and benchmarking
+ * @param[in] level - SIMD level, a level over m_utf8_simd_supported is lowered
+ * @return SIMD level in use
  * @note
- *   base function is "int unicode_width(unicode_t c)".
+ *   every level returns same result.
+ *   call before other threads use this library, the kernels are not switched atomically.
  */
-size_t m_utf8_display_width(const m_char8_t *character)
+m_utf8_simd_t m_utf8_set_simd_level(m_utf8_simd_t level)
 {
-    uint32_t c = m_utf8_to_unicode(character);
-    if (search_table(eastasian_full,
-                     sizeof(eastasian_full) / sizeof(struct te),
-                     c))
-        return 2;
-    if (search_table(eastasian_ambiguous,
-                     sizeof(eastasian_ambiguous) / sizeof(struct te),
-                     c))
-        return 2;
-    if (search_table(emoji_cjk,
-                     sizeof(emoji_cjk) / sizeof(struct te),
-                     c))
+    if (level > m_utf8_simd_max)
     {
-        return 2;
-        // if (strcmp(locale, "ja_JP.UTF-8") == 0)
-        // {
-        //     return 2;
-        // }
-        // else
-        // {
-        //     return 2;
-        // }
+        level = m_utf8_simd_max;
     }
-    return 1;
+    m_utf8_kernels = &m_utf8_kernel_table[level];
+    return level;
 }
 
 /**
- * @public
- * @fn int64_t m_utf8_str_byte_size(const m_char8_t *str, size_t max_str_bytesize)
- * @brief utf8 string byte size
+ * @private
+ * @fn static size_t m_utf8_valid_length(const uint8_t *str, size_t str_bytesize)
+ * @brief length of the valid utf8 prefix
  * @param[in] str - utf8 string
- * @param[in] max_str_bytesize - utf8 string byte size( add null-terminated string size)
- * @return string byte size( add null-terminated string size)
- * @author FUNABARA Masao
+ * @param[in] str_bytesize - utf8 string byte size( not include null-terminated string size)
+ * @return byte offset of the first invalid character, str_bytesize when all valid.
  * @note
- *   add null-terminated string size.
+ *   same result as m_utf8_ch_validate for each character.
  */
-int64_t m_utf8_str_byte_size(const m_char8_t *str, size_t max_str_bytesize)
+static inline size_t m_utf8_valid_length(const uint8_t *str, size_t str_bytesize)
 {
-    const int64_t max_size = (int64_t)max_str_bytesize;
-    int64_t str_size = 0;
-    uint8_t size = 0;
+    size_t valid_size = m_utf8_kernels->valid_length(str, str_bytesize);
 
-    while (*str && str_size < max_size)
-    {
-        size = m_utf8_ch_byte_size(str);
-        str_size += size;
-        str += size;
-    }
+    if (valid_size < str_bytesize)
+        M_UTF8_STATS_ADD(invalid_count, 1);
+    return valid_size;
+}
 
-    if (str_size >= max_size)
-    {
-        str_size -= size;
-    }
-    if (max_size > 0)
-    {
-        str_size += 1;
-    }
-    return str_size;
+/**
+ * @private
+ * @fn static void m_utf8_stat_scan(const uint8_t *str, size_t str_bytesize, bool truncated, const m_utf8_width_profile_t *profile, m_utf8_stat_t *stat)
+ * @brief scan utf8 string once, and count characters and display width
+ * @param[in] str - utf8 string
+ * @param[in] str_bytesize - utf8 string byte size( not include null-terminated string size)
+ * @param[in] truncated - true when str_bytesize cut the string, the last character is not counted.
+ * @param[in] profile - width profile
+ * @param[out] stat - result. byte_size is the scanned byte size.
+ * @note
+ *   an invalid character is counted as display width 1( same as m_utf8_display_width).
+ */
+static inline void m_utf8_stat_scan(const uint8_t *str, size_t str_bytesize, bool truncated,
+                                    const m_utf8_width_profile_t *profile, m_utf8_stat_t *stat)
+{
+    m_utf8_kernels->stat_scan(str, str_bytesize, truncated, profile, stat);
+}
+
+/**
+ * @private
+ * @fn static int64_t m_utf8_count_scan(const uint8_t *str, size_t str_bytesize)
+ * @brief utf8 character count
+ * @param[in] str - utf8 string
+ * @param[in] str_bytesize - utf8 string byte size
+ * @return character count, a character truncated by str_bytesize is counted.
+ */
+static inline int64_t m_utf8_count_scan(const uint8_t *str, size_t str_bytesize)
+{
+    return m_utf8_kernels->count_scan(str, str_bytesize);
 }
 
 /**
@@ -462,17 +342,31 @@ int64_t m_utf8_str_byte_size(const m_char8_t *str, size_t max_str_bytesize)
  */
 bool m_utf8_str_validate(const m_char8_t *str, size_t max_str_bytesize)
 {
+#if defined(__SSE2__)
+    const m_char8_t *end = memchr(str, '\0', max_str_bytesize);
+    if (end == NULL)
+    {
+        return false;
+    }
+    size_t str_bytesize = (size_t)(end - str);
+
+    M_UTF8_STATS_API(M_UTF8_STATS_VALIDATE, str_bytesize);
+    return m_utf8_valid_length((const uint8_t *)str, str_bytesize) == str_bytesize;
+#else
     int64_t max_size = m_utf8_str_byte_size(str, max_str_bytesize);
     int64_t str_size = 0;
 
+    M_UTF8_STATS_API(M_UTF8_STATS_VALIDATE, max_size);
     while (*str && str_size < max_size)
     {
         uint8_t ch_byte_size = m_utf8_ch_byte_size(str);
         bool result = m_utf8_ch_validate(str, ch_byte_size);
         if (result == false)
         {
+            M_UTF8_STATS_ADD(invalid_count, 1);
             return false;
         }
+        M_UTF8_STATS_CHAR(ch_byte_size);
         str_size += ch_byte_size;
         str += ch_byte_size;
     }
@@ -483,6 +377,7 @@ bool m_utf8_str_validate(const m_char8_t *str, size_t max_str_bytesize)
     }
 
     return true;
+#endif
 }
 
 /**
@@ -495,7 +390,7 @@ bool m_utf8_str_validate(const m_char8_t *str, size_t max_str_bytesize)
  * @author FUNABARA Masao
  * @note
  *   add null-terminated string size.
- *   Don't correspond Emoji and Combine Strings.
+ *   Don't correspond Emoji and Combine Strings, see m_utf8_str_grapheme_count.
  */
 int64_t m_utf8_str_display_count(const m_char8_t *str, size_t max_str_bytesize)
 {
@@ -503,9 +398,11 @@ int64_t m_utf8_str_display_count(const m_char8_t *str, size_t max_str_bytesize)
     int64_t str_size = 0;
     int64_t display_count = 0;
 
+    M_UTF8_STATS_API(M_UTF8_STATS_COUNT, max_size);
     while (*str && str_size < max_size)
     {
         uint8_t ch_byte_size = m_utf8_ch_byte_size(str);
+        M_UTF8_STATS_CHAR(ch_byte_size);
         str_size += ch_byte_size;
         str += ch_byte_size;
         display_count++;
@@ -521,62 +418,1491 @@ int64_t m_utf8_str_display_count(const m_char8_t *str, size_t max_str_bytesize)
 
 /**
  * @public
- * @fn bool m_utf8_str_cpy(m_char8_t *dst, size_t dst_array_size, const m_char8_t *src, size_t src_size)
- * @param[out] dst - array to save string
- * @param[in] dst_array_size - array size
- * @param[in] src - source string
- * @param[in] src_size - source string size
- * @return always true
+ * @fn bool m_utf8_str_stat(const m_char8_t *str, size_t max_str_bytesize, const m_utf8_width_profile_t *profile, m_utf8_stat_t *stat)
+ * @brief utf8 string byte size, character count, display width and first error at once
+ * @param[in] str - utf8 string
+ * @param[in] max_str_bytesize - utf8 string byte size( add null-terminated string size)
+ * @param[in] profile - width profile, NULL is same as m_utf8_display_width
+ * @param[out] stat - byte_size is same as m_utf8_str_byte_size,
+ *                    char_count is character count,
+ *                    display_width is sum of m_utf8_display_width_profile,
+ *                    error_offset is byte offset of the first invalid character( -1 when none).
+ * @return same as m_utf8_str_validate
+ * @note
+ *   add null-terminated string size.
+ *   read the string only once.
  */
-bool m_utf8_str_cpy(m_char8_t *dst, const size_t dst_array_size, const m_char8_t *src, size_t src_size)
+bool m_utf8_str_stat(const m_char8_t *str, size_t max_str_bytesize, const m_utf8_width_profile_t *profile,
+                     m_utf8_stat_t *stat)
 {
-    int64_t src_byte_size = m_utf8_str_byte_size(src, src_size);
-    uint8_t str_size = 0;
+    const m_char8_t *end = memchr(str, '\0', max_str_bytesize);
+    size_t str_bytesize = end ? (size_t)(end - str) : max_str_bytesize;
 
-    size_t i = 0;
-    while (i < dst_array_size)
+    if (end == NULL && max_str_bytesize > 0)
     {
-        uint8_t size = m_utf8_ch_byte_size(src);
-        if (str_size + size >= dst_array_size)
-        {
-            *dst = '\0';
-            break;
-        }
-        if (str_size + size >= src_byte_size)
-        {
-            *dst = '\0';
-            break;
-        }
-        for (int j = 0; j < size; j++)
-        {
-            *dst = *src;
-            dst++;
-            src++;
-            i++;
-            str_size++;
-        }
+        str_bytesize--;
+    }
+    if (profile == NULL)
+    {
+        profile = M_UTF8_WIDTH_PROFILE_DEFAULT;
+    }
+    M_UTF8_STATS_API(M_UTF8_STATS_STAT, str_bytesize);
+    m_utf8_stat_scan((const uint8_t *)str, str_bytesize, end == NULL, profile, stat);
+    if (max_str_bytesize > 0)
+    {
+        stat->byte_size += 1;
     }
 
-    return true;
+    return end != NULL && stat->error_offset < 0;
 }
 
 /**
  * @public
- * @fn bool m_utf8_str_cat(m_char8_t *dst, const size_t dst_array_size, const m_char8_t *src, size_t src_size)
- * @param[out] dst - array to save string
- * @param[in] dst_array_size - array size
- * @param[in] src - source string
- * @param[in] src_size - source string size
- * @return always true
+ * @fn bool m_utf8_mem_to_unicode(const m_char8_t *src, size_t src_bytesize, uint32_t *dst, size_t dst_size, m_utf8_conv_t *conv)
+ * @brief utf8 buffer convert to unicode array
+ * @param[in] src - utf8 buffer( null-terminated string is not needed)
+ * @param[in] src_bytesize - utf8 buffer byte size
+ * @param[out] dst - unicode array
+ * @param[in] dst_size - unicode array size
+ * @param[out] conv - read bytes, written unicode count and byte offset of the first invalid character( NULL is ok)
+ * @return true when all of src is converted
+ * @note
+ *   stop at the first invalid character, or when dst is full.
+ *   dst after dst_written may be overwritten.
  */
-bool m_utf8_str_cat(m_char8_t *dst, const size_t dst_array_size, const m_char8_t *src, size_t src_size)
+bool m_utf8_mem_to_unicode(const m_char8_t *src, size_t src_bytesize, uint32_t *dst, size_t dst_size,
+                           m_utf8_conv_t *conv)
 {
-    int64_t dst_byte_size = m_utf8_str_byte_size(dst, dst_array_size) - 1;
-    m_char8_t *inptr = dst;
-    int64_t inptr_size = dst_array_size - dst_byte_size;
-    inptr += dst_byte_size;
+    m_utf8_conv_t result;
 
-    m_utf8_str_cpy(inptr, inptr_size, src, src_size);
+    M_UTF8_STATS_API(M_UTF8_STATS_CONVERT, src_bytesize);
+    m_utf8_kernels->to_unicode_scan((const uint8_t *)src, src_bytesize, dst, dst_size, &result);
+    if (result.error_offset >= 0)
+        M_UTF8_STATS_ADD(invalid_count, 1);
+    if (conv != NULL)
+    {
+        *conv = result;
+    }
+    return result.src_read == (int64_t)src_bytesize;
+}
 
-    return true;
-}
\ No newline at end of file
+/**
+ * @public
+ * @fn int64_t m_utf8_mem_utf16_size(const m_char8_t *src, size_t src_bytesize)
+ * @brief utf16 code unit count of utf8 buffer
+ * @param[in] src - utf8 buffer( null-terminated string is not needed)
+ * @param[in] src_bytesize - utf8 buffer byte size
+ * @return utf16 code unit count
+ * @note
+ *   do not validate, exact for valid utf8, and not less than the output of m_utf8_mem_to_utf16.
+ *   count of the bytes which are not continuation bytes, and 1 more for 4 bytes characters.
+ */
+int64_t m_utf8_mem_utf16_size(const m_char8_t *src, size_t src_bytesize)
+{
+    const uint8_t *str = (const uint8_t *)src;
+    size_t str_size = 0;
+    int64_t utf16_size = 0;
+
+#if defined(__SSE2__)
+    const __m128i continuation_max = _mm_set1_epi8((char)0xBF);
+    const __m128i four_bytes_min = _mm_set1_epi8((char)0xF0);
+    while (str_size + 16 <= src_bytesize)
+    {
+        __m128i input = _mm_loadu_si128((const __m128i *)(str + str_size));
+        /* signed 0x80..0xBF is -128..-65. */
+        int not_continuation = _mm_movemask_epi8(_mm_cmpgt_epi8(input, continuation_max));
+        int four_bytes = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(input, four_bytes_min), input));
+        utf16_size += __builtin_popcount(not_continuation) + __builtin_popcount(four_bytes);
+        str_size += 16;
+    }
+#endif
+    for (; str_size < src_bytesize; str_size++)
+    {
+        utf16_size += (str[str_size] & 0xC0) != 0x80;
+        utf16_size += str[str_size] >= 0xF0;
+    }
+
+    return utf16_size;
+}
+
+/**
+ * @public
+ * @fn bool m_utf8_mem_to_utf16(const m_char8_t *src, size_t src_bytesize, uint16_t *dst, size_t dst_size, m_utf8_conv_t *conv)
+ * @brief utf8 buffer convert to utf16 array
+ * @param[in] src - utf8 buffer( null-terminated string is not needed)
+ * @param[in] src_bytesize - utf8 buffer byte size
+ * @param[out] dst - utf16 array( native endian, same as jchar)
+ * @param[in] dst_size - utf16 array size, see m_utf8_mem_utf16_size
+ * @param[out] conv - read bytes, written utf16 code unit count and byte offset of the first invalid character( NULL is ok)
+ * @return true when all of src is converted
+ * @note
+ *   same validation as m_utf8_mem_validate, stop at the first invalid character, or when dst is full.
+ *   a character over U+FFFF is written as a surrogate pair.
+ *   dst after dst_written may be overwritten.
+ */
+bool m_utf8_mem_to_utf16(const m_char8_t *src, size_t src_bytesize, uint16_t *dst, size_t dst_size,
+                         m_utf8_conv_t *conv)
+{
+    m_utf8_conv_t result;
+
+    M_UTF8_STATS_API(M_UTF8_STATS_CONVERT, src_bytesize);
+    m_utf8_kernels->to_utf16_scan((const uint8_t *)src, src_bytesize, dst, dst_size, &result);
+    if (result.error_offset >= 0)
+        M_UTF8_STATS_ADD(invalid_count, 1);
+    if (conv != NULL)
+    {
+        *conv = result;
+    }
+    return result.src_read == (int64_t)src_bytesize;
+}
+
+/**
+ * @private
+ * @fn static uint8_t m_utf8_encode_unicode(uint32_t unicode, uint8_t *character)
+ * @brief unicode convert to utf8 character
+ * @param[in] unicode - unicode
+ * @param[out] character - utf8 character( 4 bytes or more)
+ * @return utf8 character byte size, 0 when unicode is not valid for m_utf8_ch_validate.
+ */
+static uint8_t m_utf8_encode_unicode(uint32_t unicode, uint8_t *character)
+{
+    if (unicode < 0x80)
+    {
+        character[0] = (uint8_t)unicode;
+        return 1;
+    }
+    if (unicode < 0x800)
+    {
+        character[0] = (uint8_t)(0xC0 | (unicode >> 6));
+        character[1] = (uint8_t)(0x80 | (unicode & 0x3F));
+        return 2;
+    }
+    if (unicode > 0x10FFFF || (unicode >= 0xD800 && unicode <= 0xDFFF) ||
+        (unicode >= 0xFDD0 && unicode <= 0xFDEF) || (unicode & 0xFFFE) == 0xFFFE)
+    {
+        return 0;
+    }
+    if (unicode < 0x10000)
+    {
+        character[0] = (uint8_t)(0xE0 | (unicode >> 12));
+        character[1] = (uint8_t)(0x80 | ((unicode >> 6) & 0x3F));
+        character[2] = (uint8_t)(0x80 | (unicode & 0x3F));
+        return 3;
+    }
+    character[0] = (uint8_t)(0xF0 | (unicode >> 18));
+    character[1] = (uint8_t)(0x80 | ((unicode >> 12) & 0x3F));
+    character[2] = (uint8_t)(0x80 | ((unicode >> 6) & 0x3F));
+    character[3] = (uint8_t)(0x80 | (unicode & 0x3F));
+    return 4;
+}
+
+/**
+ * @public
+ * @fn uint8_t m_utf8_from_unicode(uint32_t unicode, m_char8_t *character)
+ * @brief unicode convert to utf8 character
+ * @param[in] unicode - unicode
+ * @param[out] character - utf8 character( 4 bytes or more, null-terminated string is not added)
+ * @return utf8 character byte size, 0 when unicode is surrogate, noncharacter or over U+10FFFF.
+ * @note
+ *   inverse of m_utf8_to_unicode, the character is valid for m_utf8_ch_validate.
+ */
+uint8_t m_utf8_from_unicode(uint32_t unicode, m_char8_t *character)
+{
+    return m_utf8_encode_unicode(unicode, (uint8_t *)character);
+}
+
+/**
+ * @public
+ * @fn int64_t m_utf8_size_from_unicode(const uint32_t *src, size_t src_size)
+ * @brief utf8 byte size of unicode array
+ * @param[in] src - unicode array
+ * @param[in] src_size - unicode array size
+ * @return utf8 byte size( not include null-terminated string size)
+ * @note
+ *   do not validate, exact for valid unicode, and not less than the output of m_utf8_mem_from_unicode.
+ */
+int64_t m_utf8_size_from_unicode(const uint32_t *src, size_t src_size)
+{
+    size_t src_index = 0;
+    int64_t str_size = 0;
+
+#if defined(__SSE2__)
+    /* unsigned compare by flipping the sign bit. */
+    const __m128i bias = _mm_set1_epi32((int)0x80000000);
+    const __m128i two_bytes = _mm_set1_epi32((int)(0x80000000 + 0x7F));
+    const __m128i three_bytes = _mm_set1_epi32((int)(0x80000000 + 0x7FF));
+    const __m128i four_bytes = _mm_set1_epi32((int)(0x80000000 + 0xFFFF));
+    while (src_index + 4 <= src_size)
+    {
+        __m128i input = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(src + src_index)), bias);
+        __m128i extra = _mm_add_epi32(_mm_cmpgt_epi32(input, two_bytes), _mm_cmpgt_epi32(input, three_bytes));
+        extra = _mm_add_epi32(extra, _mm_cmpgt_epi32(input, four_bytes));
+        /* extra is -( byte size - 1) of each lane. */
+        extra = _mm_add_epi32(extra, _mm_shuffle_epi32(extra, _MM_SHUFFLE(1, 0, 3, 2)));
+        extra = _mm_add_epi32(extra, _mm_shuffle_epi32(extra, _MM_SHUFFLE(2, 3, 0, 1)));
+        str_size += 4 - _mm_cvtsi128_si32(extra);
+        src_index += 4;
+    }
+#endif
+    for (; src_index < src_size; src_index++)
+    {
+        uint32_t unicode = src[src_index];
+        str_size += 1 + (unicode >= 0x80) + (unicode >= 0x800) + (unicode >= 0x10000);
+    }
+
+    return str_size;
+}
+
+/**
+ * @public
+ * @fn bool m_utf8_mem_from_unicode(const uint32_t *src, size_t src_size, m_char8_t *dst, size_t dst_bytesize, m_utf8_conv_t *conv)
+ * @brief unicode array convert to utf8 buffer
+ * @param[in] src - unicode array
+ * @param[in] src_size - unicode array size
+ * @param[out] dst - utf8 buffer( null-terminated string is not added)
+ * @param[in] dst_bytesize - utf8 buffer byte size, see m_utf8_size_from_unicode
+ * @param[out] conv - read unicode count, written bytes and index of the first invalid unicode( NULL is ok)
+ * @return true when all of src is converted
+ * @note
+ *   stop at the first invalid unicode( same as m_utf8_from_unicode), or when dst is full.
+ */
+bool m_utf8_mem_from_unicode(const uint32_t *src, size_t src_size, m_char8_t *dst, size_t dst_bytesize,
+                             m_utf8_conv_t *conv)
+{
+    uint8_t *str = (uint8_t *)dst;
+    size_t src_index = 0;
+    size_t str_size = 0;
+    int64_t error_offset = -1;
+
+    while (src_index < src_size)
+    {
+#if defined(__SSE2__)
+        /* ASCII block is 16 unicode narrowed to 16 bytes. */
+        while (src_index + 16 <= src_size && str_size + 16 <= dst_bytesize)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i *)(src + src_index));
+            __m128i b = _mm_loadu_si128((const __m128i *)(src + src_index + 4));
+            __m128i c = _mm_loadu_si128((const __m128i *)(src + src_index + 8));
+            __m128i d = _mm_loadu_si128((const __m128i *)(src + src_index + 12));
+            __m128i any = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(any, _mm_set1_epi32(~0x7F)), _mm_setzero_si128())) !=
+                0xFFFF)
+                break;
+            __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+            _mm_storeu_si128((__m128i *)(str + str_size), bytes);
+            src_index += 16;
+            str_size += 16;
+        }
+        if (src_index >= src_size)
+            break;
+#endif
+        uint8_t character[4];
+        uint8_t ch_byte_size = m_utf8_encode_unicode(src[src_index], character);
+        if (ch_byte_size == 0)
+        {
+            error_offset = (int64_t)src_index;
+            break;
+        }
+        if (str_size + ch_byte_size > dst_bytesize)
+        {
+            break;
+        }
+        memcpy(str + str_size, character, ch_byte_size);
+        str_size += ch_byte_size;
+        src_index++;
+    }
+
+    if (conv != NULL)
+    {
+        conv->src_read = (int64_t)src_index;
+        conv->dst_written = (int64_t)str_size;
+        conv->error_offset = error_offset;
+    }
+    return src_index == src_size;
+}
+
+/**
+ * @public
+ * @fn int64_t m_utf8_size_from_utf16(const uint16_t *src, size_t src_size)
+ * @brief utf8 byte size of utf16 array
+ * @param[in] src - utf16 array( native endian, same as jchar)
+ * @param[in] src_size - utf16 array size
+ * @return utf8 byte size( not include null-terminated string size)
+ * @note
+ *   do not validate, exact for valid utf16, and not less than the output of m_utf8_mem_from_utf16.
+ *   each surrogate is counted as 2 bytes, so a surrogate pair is 4 bytes.
+ */
+int64_t m_utf8_size_from_utf16(const uint16_t *src, size_t src_size)
+{
+    size_t src_index = 0;
+    int64_t str_size = 0;
+
+#if defined(__SSE2__)
+    /* unsigned compare by flipping the sign bit. */
+    const __m128i bias = _mm_set1_epi16((short)0x8000);
+    const __m128i two_bytes = _mm_set1_epi16((short)(0x8000 + 0x7F));
+    const __m128i three_bytes = _mm_set1_epi16((short)(0x8000 + 0x7FF));
+    const __m128i surrogate_mask = _mm_set1_epi16((short)0xF800);
+    const __m128i surrogate = _mm_set1_epi16((short)0xD800);
+    while (src_index + 8 <= src_size)
+    {
+        __m128i input = _mm_loadu_si128((const __m128i *)(src + src_index));
+        __m128i biased = _mm_xor_si128(input, bias);
+        int two = _mm_movemask_epi8(_mm_cmpgt_epi16(biased, two_bytes));
+        int three = _mm_movemask_epi8(_mm_cmpgt_epi16(biased, three_bytes));
+        int pair = _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(input, surrogate_mask), surrogate));
+        /* each mask has 2 bits for a code unit. */
+        str_size += 8 + (__builtin_popcount(two) + __builtin_popcount(three) - __builtin_popcount(pair)) / 2;
+        src_index += 8;
+    }
+#endif
+    for (; src_index < src_size; src_index++)
+    {
+        uint16_t unit = src[src_index];
+        str_size += 1 + (unit >= 0x80) + (unit >= 0x800) - ((unit & 0xF800) == 0xD800);
+    }
+
+    return str_size;
+}
+
+/**
+ * @public
+ * @fn bool m_utf8_mem_from_utf16(const uint16_t *src, size_t src_size, m_char8_t *dst, size_t dst_bytesize, m_utf8_conv_t *conv)
+ * @brief utf16 array convert to utf8 buffer
+ * @param[in] src - utf16 array( native endian, same as jchar)
+ * @param[in] src_size - utf16 array size
+ * @param[out] dst - utf8 buffer( null-terminated string is not added)
+ * @param[in] dst_bytesize - utf8 buffer byte size, see m_utf8_size_from_utf16
+ * @param[out] conv - read code unit count, written bytes and index of the first invalid code unit( NULL is ok)
+ * @return true when all of src is converted
+ * @note
+ *   a lone surrogate and a noncharacter are invalid, stop at the first one, or when dst is full.
+ */
+bool m_utf8_mem_from_utf16(const uint16_t *src, size_t src_size, m_char8_t *dst, size_t dst_bytesize,
+                           m_utf8_conv_t *conv)
+{
+    uint8_t *str = (uint8_t *)dst;
+    size_t src_index = 0;
+    size_t str_size = 0;
+    int64_t error_offset = -1;
+
+    while (src_index < src_size)
+    {
+#if defined(__SSE2__)
+        /* ASCII block is 16 code units narrowed to 16 bytes. */
+        while (src_index + 16 <= src_size && str_size + 16 <= dst_bytesize)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i *)(src + src_index));
+            __m128i b = _mm_loadu_si128((const __m128i *)(src + src_index + 8));
+            __m128i any = _mm_and_si128(_mm_or_si128(a, b), _mm_set1_epi16((short)0xFF80));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi16(any, _mm_setzero_si128())) != 0xFFFF)
+                break;
+            _mm_storeu_si128((__m128i *)(str + str_size), _mm_packus_epi16(a, b));
+            src_index += 16;
+            str_size += 16;
+        }
+        if (src_index >= src_size)
+            break;
+#endif
+        uint32_t unicode = src[src_index];
+        size_t unit_size = 1;
+        if ((unicode & 0xFC00) == 0xD800 && src_index + 1 < src_size && (src[src_index + 1] & 0xFC00) == 0xDC00)
+        {
+            unicode = 0x10000 + ((unicode & 0x3FF) << 10) + (src[src_index + 1] & 0x3FF);
+            unit_size = 2;
+        }
+
+        uint8_t character[4];
+        uint8_t ch_byte_size = m_utf8_encode_unicode(unicode, character);
+        if (ch_byte_size == 0)
+        {
+            error_offset = (int64_t)src_index;
+            break;
+        }
+        if (str_size + ch_byte_size > dst_bytesize)
+        {
+            break;
+        }
+        memcpy(str + str_size, character, ch_byte_size);
+        str_size += ch_byte_size;
+        src_index += unit_size;
+    }
+
+    if (conv != NULL)
+    {
+        conv->src_read = (int64_t)src_index;
+        conv->dst_written = (int64_t)str_size;
+        conv->error_offset = error_offset;
+    }
+    return src_index == src_size;
+}
+
+/**
+ * @private
+ * @fn static inline void m_utf8_stream_step(m_utf8_stream_t *stream, uint8_t byte)
+ * @brief feed one byte to the decoder DFA of the stream
+ */
+static inline void m_utf8_stream_step(m_utf8_stream_t *stream, uint8_t byte)
+{
+    uint8_t byte_class = m_utf8_dfa_class_table[byte];
+
+    if (stream->state == M_UTF8_DFA_ACCEPT)
+        stream->unicode = byte & m_utf8_dfa_lead_mask[byte_class];
+    else
+        stream->unicode = (stream->unicode << 6) | (byte & 0x3F);
+    stream->state = m_utf8_dfa_transition[stream->state][byte_class];
+}
+
+/**
+ * @private
+ * @fn static size_t m_utf8_stream_suspend(m_utf8_stream_t *stream, const uint8_t *chunk, size_t chunk_bytesize, size_t str_size)
+ * @brief keep the last character of the chunk for the next chunk
+ * @param[in,out] stream - utf8 stream
+ * @param[in] chunk - chunk
+ * @param[in] chunk_bytesize - chunk byte size
+ * @param[in] str_size - chunk offset of the invalid or incomplete character
+ * @return read byte size of the chunk
+ * @note
+ *   set error_offset when the character is invalid.
+ */
+static size_t m_utf8_stream_suspend(m_utf8_stream_t *stream, const uint8_t *chunk, size_t chunk_bytesize,
+                                    size_t str_size)
+{
+    stream->char_offset = stream->offset + (int64_t)str_size;
+    stream->state = M_UTF8_DFA_ACCEPT;
+
+    size_t i = str_size;
+    while (i < chunk_bytesize)
+    {
+        m_utf8_stream_step(stream, chunk[i++]);
+        if (stream->state <= M_UTF8_DFA_ACCEPT)
+            break;
+    }
+    if (stream->state == M_UTF8_DFA_REJECT || stream->state == M_UTF8_DFA_ACCEPT)
+    {
+        stream->error_offset = stream->char_offset;
+        return str_size;
+    }
+
+    return i;
+}
+
+/**
+ * @public
+ * @fn void m_utf8_stream_init(m_utf8_stream_t *stream)
+ * @brief initialize utf8 stream
+ * @param[out] stream - utf8 stream
+ */
+void m_utf8_stream_init(m_utf8_stream_t *stream)
+{
+    stream->offset = 0;
+    stream->char_offset = 0;
+    stream->error_offset = -1;
+    stream->unicode = 0;
+    stream->state = M_UTF8_DFA_ACCEPT;
+}
+
+/**
+ * @public
+ * @fn bool m_utf8_stream_feed(m_utf8_stream_t *stream, const m_char8_t *chunk, size_t chunk_bytesize)
+ * @brief validate next chunk of utf8 stream
+ * @param[in,out] stream - utf8 stream
+ * @param[in] chunk - chunk( null-terminated string is not needed)
+ * @param[in] chunk_bytesize - chunk byte size
+ * @return false when the stream has an invalid character
+ * @note
+ *   a character may be split into two chunks.
+ *   call m_utf8_stream_finish after the last chunk.
+ */
+bool m_utf8_stream_feed(m_utf8_stream_t *stream, const m_char8_t *chunk, size_t chunk_bytesize)
+{
+    const uint8_t *str = (const uint8_t *)chunk;
+    size_t str_size = 0;
+
+    if (stream->error_offset >= 0)
+        return false;
+
+    /* finish the character split by the last chunk. */
+    while (stream->state > M_UTF8_DFA_ACCEPT && str_size < chunk_bytesize)
+        m_utf8_stream_step(stream, str[str_size++]);
+    if (stream->state == M_UTF8_DFA_REJECT)
+    {
+        stream->error_offset = stream->char_offset;
+        return false;
+    }
+
+    if (stream->state == M_UTF8_DFA_ACCEPT)
+    {
+        str_size += m_utf8_valid_length(str + str_size, chunk_bytesize - str_size);
+        if (str_size < chunk_bytesize)
+        {
+            str_size = m_utf8_stream_suspend(stream, str, chunk_bytesize, str_size);
+        }
+    }
+    stream->offset += (int64_t)str_size;
+
+    return stream->error_offset < 0;
+}
+
+/**
+ * @public
+ * @fn bool m_utf8_stream_decode(m_utf8_stream_t *stream, const m_char8_t *chunk, size_t chunk_bytesize, uint32_t *dst, size_t dst_size, m_utf8_conv_t *conv)
+ * @brief convert next chunk of utf8 stream to unicode array
+ * @param[in,out] stream - utf8 stream
+ * @param[in] chunk - chunk( null-terminated string is not needed)
+ * @param[in] chunk_bytesize - chunk byte size
+ * @param[out] dst - unicode array
+ * @param[in] dst_size - unicode array size
+ * @param[out] conv - read bytes of the chunk, written unicode count and
+ *                    stream offset of the first invalid character( NULL is ok)
+ * @return true when all of chunk is read
+ * @note
+ *   when dst is full, feed the rest of chunk( after src_read) again.
+ */
+bool m_utf8_stream_decode(m_utf8_stream_t *stream, const m_char8_t *chunk, size_t chunk_bytesize, uint32_t *dst,
+                          size_t dst_size, m_utf8_conv_t *conv)
+{
+    const uint8_t *str = (const uint8_t *)chunk;
+    size_t str_size = 0;
+    size_t written = 0;
+
+    if (stream->error_offset < 0 && dst_size > 0)
+    {
+        /* finish the character split by the last chunk. */
+        while (stream->state > M_UTF8_DFA_ACCEPT && str_size < chunk_bytesize)
+            m_utf8_stream_step(stream, str[str_size++]);
+        if (stream->state == M_UTF8_DFA_REJECT)
+        {
+            stream->error_offset = stream->char_offset;
+            str_size = 0;
+        }
+        else if (stream->state == M_UTF8_DFA_ACCEPT)
+        {
+            if (str_size > 0)
+                dst[written++] = stream->unicode;
+
+            m_utf8_conv_t bulk;
+            m_utf8_mem_to_unicode(chunk + str_size, chunk_bytesize - str_size, dst + written, dst_size - written,
+                                  &bulk);
+            str_size += (size_t)bulk.src_read;
+            written += (size_t)bulk.dst_written;
+            if (bulk.error_offset >= 0)
+            {
+                str_size = m_utf8_stream_suspend(stream, str, chunk_bytesize, str_size);
+            }
+        }
+        stream->offset += (int64_t)str_size;
+    }
+
+    if (conv != NULL)
+    {
+        conv->src_read = (int64_t)str_size;
+        conv->dst_written = (int64_t)written;
+        conv->error_offset = stream->error_offset;
+    }
+    return stream->error_offset < 0 && str_size == chunk_bytesize;
+}
+
+/**
+ * @public
+ * @fn bool m_utf8_stream_finish(m_utf8_stream_t *stream)
+ * @brief end of utf8 stream
+ * @param[in,out] stream - utf8 stream
+ * @return true when all of the stream is valid
+ * @note
+ *   a character cut by the end of the stream is invalid.
+ */
+bool m_utf8_stream_finish(m_utf8_stream_t *stream)
+{
+    if (stream->error_offset < 0 && stream->state != M_UTF8_DFA_ACCEPT)
+    {
+        stream->error_offset = stream->char_offset;
+    }
+    return stream->error_offset < 0;
+}
+
+/**
+ * @private
+ * @fn static size_t m_utf8_char_boundary(const uint8_t *str, size_t limit)
+ * @brief last character boundary at or before limit
+ * @param[in] str - utf8 string
+ * @param[in] limit - byte offset( readable bytes are [0, limit))
+ * @return limit, or the offset of the character which crosses limit
+ * @note
+ *   step back at most 3 bytes, do not scan from the start.
+ */
+static size_t m_utf8_char_boundary(const uint8_t *str, size_t limit)
+{
+    for (size_t i = limit; i > 0 && i + 3 > limit; i--)
+    {
+        uint8_t c = str[i - 1];
+        if ((c & 0xC0) == 0x80)
+            continue;
+        if (i - 1 + m_utf8_jump_table[c] > limit)
+            return i - 1;
+        break;
+    }
+    return limit;
+}
+
+/**
+ * @public
+ * @fn bool m_utf8_str_cpy(m_char8_t *dst, size_t dst_array_size, const m_char8_t *src, size_t src_size)
+ * @param[out] dst - array to save string
+ * @param[in] dst_array_size - array size
+ * @param[in] src - source string
+ * @param[in] src_size - source string size
+ * @return always true
+ * @note
+ *   same as m_utf8_str_cpy_size.
+ */
+bool m_utf8_str_cpy(m_char8_t *dst, const size_t dst_array_size, const m_char8_t *src, size_t src_size)
+{
+    m_utf8_str_cpy_size(dst, dst_array_size, src, src_size);
+
+    return true;
+}
+
+/**
+ * @public
+ * @fn int64_t m_utf8_str_cpy_size(m_char8_t *dst, size_t dst_array_size, const m_char8_t *src, size_t src_size)
+ * @brief copy utf8 string, truncate at the character boundary
+ * @param[out] dst - array to save string
+ * @param[in] dst_array_size - array size( add null-terminated string size)
+ * @param[in] src - source string
+ * @param[in] src_size - source string size( add null-terminated string size)
+ * @return written byte size( not include null-terminated string size)
+ * @note
+ *   read src only up to the copy size, and copy with one memcpy.
+ *   a character cut by dst_array_size is dropped by stepping back at most 3 bytes.
+ */
+int64_t m_utf8_str_cpy_size(m_char8_t *dst, size_t dst_array_size, const m_char8_t *src, size_t src_size)
+{
+    if (dst_array_size == 0)
+    {
+        return 0;
+    }
+
+    size_t limit = dst_array_size - 1;
+    if (src_size == 0)
+    {
+        limit = 0;
+    }
+    else if (src_size - 1 < limit)
+    {
+        limit = src_size - 1;
+    }
+
+    const m_char8_t *end = memchr(src, '\0', limit);
+    if (end != NULL)
+    {
+        limit = (size_t)(end - src);
+    }
+    size_t str_size = m_utf8_char_boundary((const uint8_t *)src, limit);
+    memcpy(dst, src, str_size);
+    dst[str_size] = '\0';
+
+    return (int64_t)str_size;
+}
+
+/**
+ * @public
+ * @fn bool m_utf8_str_cat(m_char8_t *dst, const size_t dst_array_size, const m_char8_t *src, size_t src_size)
+ * @param[out] dst - array to save string
+ * @param[in] dst_array_size - array size
+ * @param[in] src - source string
+ * @param[in] src_size - source string size
+ * @return always true
+ * @note
+ *   dst is scanned on every call, use m_utf8_builder for repeated appends.
+ */
+bool m_utf8_str_cat(m_char8_t *dst, const size_t dst_array_size, const m_char8_t *src, size_t src_size)
+{
+    int64_t dst_byte_size = m_utf8_str_byte_size(dst, dst_array_size) - 1;
+    m_char8_t *inptr = dst;
+    int64_t inptr_size = dst_array_size - dst_byte_size;
+    inptr += dst_byte_size;
+
+    m_utf8_str_cpy(inptr, inptr_size, src, src_size);
+
+    return true;
+}
+/**
+ * @public
+ * @fn int64_t m_utf8_mem_byte_size(const m_char8_t *str, size_t str_bytesize)
+ * @brief utf8 buffer byte size of the whole characters
+ * @param[in] str - utf8 buffer( null-terminated string is not needed)
+ * @param[in] str_bytesize - utf8 buffer byte size
+ * @return str_bytesize, or smaller when the last character is truncated.
+ * @note
+ *   do not read after str_bytesize.
+ */
+int64_t m_utf8_mem_byte_size(const m_char8_t *str, size_t str_bytesize)
+{
+    return (int64_t)m_utf8_char_boundary((const uint8_t *)str, str_bytesize);
+}
+
+/**
+ * @public
+ * @fn bool m_utf8_mem_validate(const m_char8_t *str, size_t str_bytesize)
+ * @brief utf8 buffer validate
+ * @param[in] str - utf8 buffer( null-terminated string is not needed)
+ * @param[in] str_bytesize - utf8 buffer byte size
+ * @return true valid, false invalid
+ * @note
+ *   do not read after str_bytesize.
+ *   '\0' is a valid character, a character truncated by str_bytesize is invalid.
+ */
+bool m_utf8_mem_validate(const m_char8_t *str, size_t str_bytesize)
+{
+    M_UTF8_STATS_API(M_UTF8_STATS_VALIDATE, str_bytesize);
+    return m_utf8_valid_length((const uint8_t *)str, str_bytesize) == str_bytesize;
+}
+
+/**
+ * @public
+ * @fn int64_t m_utf8_mem_valid_length(const m_char8_t *str, size_t str_bytesize)
+ * @brief byte size of the valid prefix of utf8 buffer
+ * @param[in] str - utf8 buffer( null-terminated string is not needed)
+ * @param[in] str_bytesize - utf8 buffer byte size
+ * @return byte offset of the first invalid character, str_bytesize when all valid.
+ * @note
+ *   do not read after str_bytesize.
+ *   same validation as m_utf8_mem_validate.
+ */
+int64_t m_utf8_mem_valid_length(const m_char8_t *str, size_t str_bytesize)
+{
+    M_UTF8_STATS_API(M_UTF8_STATS_VALIDATE, str_bytesize);
+    return (int64_t)m_utf8_valid_length((const uint8_t *)str, str_bytesize);
+}
+
+/**
+ * @public
+ * @fn int64_t m_utf8_mem_display_count(const m_char8_t *str, size_t str_bytesize)
+ * @brief utf8 buffer display character count
+ * @param[in] str - utf8 buffer( null-terminated string is not needed)
+ * @param[in] str_bytesize - utf8 buffer byte size
+ * @return count size
+ * @note
+ *   do not read after str_bytesize.
+ *   '\0' is a character, a character truncated by str_bytesize is counted.
+ *   Don't correspond Emoji and Combine Strings, see m_utf8_mem_grapheme_count.
+ */
+int64_t m_utf8_mem_display_count(const m_char8_t *str, size_t str_bytesize)
+{
+    M_UTF8_STATS_API(M_UTF8_STATS_COUNT, str_bytesize);
+    return m_utf8_count_scan((const uint8_t *)str, str_bytesize);
+}
+
+/**
+ * @public
+ * @fn bool m_utf8_mem_stat(const m_char8_t *str, size_t str_bytesize, const m_utf8_width_profile_t *profile, m_utf8_stat_t *stat)
+ * @brief utf8 buffer byte size, character count, display width and first error at once
+ * @param[in] str - utf8 buffer( null-terminated string is not needed)
+ * @param[in] str_bytesize - utf8 buffer byte size
+ * @param[in] profile - width profile, NULL is same as m_utf8_display_width
+ * @param[out] stat - same as m_utf8_str_stat, byte_size is str_bytesize.
+ * @return same as m_utf8_mem_validate
+ * @note
+ *   do not read after str_bytesize.
+ */
+bool m_utf8_mem_stat(const m_char8_t *str, size_t str_bytesize, const m_utf8_width_profile_t *profile,
+                     m_utf8_stat_t *stat)
+{
+    if (profile == NULL)
+    {
+        profile = M_UTF8_WIDTH_PROFILE_DEFAULT;
+    }
+    M_UTF8_STATS_API(M_UTF8_STATS_STAT, str_bytesize);
+    m_utf8_stat_scan((const uint8_t *)str, str_bytesize, false, profile, stat);
+
+    return stat->error_offset < 0;
+}
+
+/**
+ * @public
+ * @fn int64_t m_utf8_mem_cpy(m_char8_t *dst, size_t dst_array_size, const m_char8_t *src, size_t src_bytesize)
+ * @brief copy utf8 buffer to null-terminated string
+ * @param[out] dst - array to save string
+ * @param[in] dst_array_size - array size( add null-terminated string size)
+ * @param[in] src - utf8 buffer( null-terminated string is not needed)
+ * @param[in] src_bytesize - utf8 buffer byte size
+ * @return written byte size( not include null-terminated string size)
+ * @note
+ *   do not read after src_bytesize.
+ *   copy only the whole characters which fit in dst.
+ */
+int64_t m_utf8_mem_cpy(m_char8_t *dst, size_t dst_array_size, const m_char8_t *src, size_t src_bytesize)
+{
+    if (dst_array_size == 0)
+    {
+        return 0;
+    }
+
+    size_t limit = src_bytesize < dst_array_size - 1 ? src_bytesize : dst_array_size - 1;
+    size_t str_size = m_utf8_char_boundary((const uint8_t *)src, limit);
+    memcpy(dst, src, str_size);
+    dst[str_size] = '\0';
+
+    return (int64_t)str_size;
+}
+
+#ifndef M_UTF8_SANITIZE_BLOCK
+#define M_UTF8_SANITIZE_BLOCK 16384
+#endif
+
+/**
+ * @private
+ * @fn static size_t m_utf8_invalid_subpart(const uint8_t *str, size_t str_bytesize)
+ * @brief byte size of the maximal invalid subpart at str
+ * @param[in] str - utf8 string, starting with an invalid character
+ * @param[in] str_bytesize - utf8 string byte size( 1 or more)
+ * @return 1 or more
+ * @note
+ *   the longest prefix of a well-formed character( Unicode 3.9, substitution of maximal subparts).
+ *   a noncharacter is well-formed, so the whole character is one subpart.
+ */
+static size_t m_utf8_invalid_subpart(const uint8_t *str, size_t str_bytesize)
+{
+    uint8_t state = m_utf8_dfa_transition[M_UTF8_DFA_ACCEPT][m_utf8_dfa_class_table[str[0]]];
+    size_t i = 1;
+
+    while (state > M_UTF8_DFA_ACCEPT && i < str_bytesize)
+    {
+        uint8_t next = m_utf8_dfa_transition[state][m_utf8_dfa_class_table[str[i]]];
+        if (next == M_UTF8_DFA_REJECT)
+        {
+            if ((state == M_UTF8_DFA_EFB7 || state == M_UTF8_DFA_EFBF || state == M_UTF8_DFA_PLANE_END4) &&
+                (str[i] & 0xC0) == 0x80)
+                i++;
+            break;
+        }
+        state = next;
+        i++;
+    }
+    return i;
+}
+
+/**
+ * @public
+ * @fn int64_t m_utf8_mem_sanitize(m_char8_t *dst, size_t dst_bytesize, const m_char8_t *src, size_t src_bytesize, m_utf8_sanitize_t mode, m_utf8_conv_t *conv)
+ * @brief copy utf8 buffer, and replace or drop the invalid characters
+ * @param[out] dst - utf8 buffer( null-terminated string is not added)
+ * @param[in] dst_bytesize - utf8 buffer byte size, src_bytesize * 3 is always enough( src_bytesize for M_UTF8_SANITIZE_DROP)
+ * @param[in] src - utf8 buffer( null-terminated string is not needed)
+ * @param[in] src_bytesize - utf8 buffer byte size
+ * @param[in] mode - M_UTF8_SANITIZE_REPLACE or M_UTF8_SANITIZE_DROP
+ * @param[out] conv - read bytes, written bytes and byte offset of the first invalid character( NULL is ok)
+ * @return count of the replaced( or dropped) subparts, -1 when dst is full before the end of src.
+ * @note
+ *   each maximal invalid subpart is one U+FFFD, same as the WHATWG encoding standard.
+ *   the valid spans are found by the SIMD validation and copied with memcpy, in one pass.
+ *   dst and src must not overlap.
+ */
+int64_t m_utf8_mem_sanitize(m_char8_t *dst, size_t dst_bytesize, const m_char8_t *src, size_t src_bytesize,
+                            m_utf8_sanitize_t mode, m_utf8_conv_t *conv)
+{
+    static const uint8_t replacement[3] = {0xEF, 0xBF, 0xBD};
+    const uint8_t *str = (const uint8_t *)src;
+    size_t str_size = 0;
+    size_t dst_size = 0;
+    int64_t replaced = 0;
+    int64_t error_offset = -1;
+    bool full = false;
+
+    M_UTF8_STATS_API(M_UTF8_STATS_SANITIZE, src_bytesize);
+    while (str_size < src_bytesize)
+    {
+        /* validate a block and copy it while it is in the cache. */
+        size_t limit = src_bytesize - str_size;
+        if (limit > M_UTF8_SANITIZE_BLOCK)
+            limit = m_utf8_char_boundary(str + str_size, M_UTF8_SANITIZE_BLOCK);
+        size_t valid_size = m_utf8_valid_length(str + str_size, limit);
+        if (valid_size > dst_bytesize - dst_size)
+        {
+            valid_size = m_utf8_char_boundary(str + str_size, dst_bytesize - dst_size);
+            full = true;
+        }
+        memcpy(dst + dst_size, str + str_size, valid_size);
+        dst_size += valid_size;
+        str_size += valid_size;
+        if (full || str_size == src_bytesize)
+            break;
+        if (valid_size == limit)
+            continue;
+
+        if (mode == M_UTF8_SANITIZE_REPLACE)
+        {
+            if (dst_bytesize - dst_size < sizeof(replacement))
+            {
+                full = true;
+                break;
+            }
+            memcpy(dst + dst_size, replacement, sizeof(replacement));
+            dst_size += sizeof(replacement);
+        }
+        if (error_offset < 0)
+            error_offset = (int64_t)str_size;
+        str_size += m_utf8_invalid_subpart(str + str_size, src_bytesize - str_size);
+        replaced++;
+    }
+
+    if (conv != NULL)
+    {
+        conv->src_read = (int64_t)str_size;
+        conv->dst_written = (int64_t)dst_size;
+        conv->error_offset = error_offset;
+    }
+    return full ? -1 : replaced;
+}
+
+/**
+ * @private
+ * @fn static bool m_utf8_fit_columns(m_char8_t *dst, size_t dst_array_size, const uint8_t *src, size_t src_bytesize, size_t columns, m_utf8_align_t align, const m_char8_t *ellipsis, const m_utf8_width_profile_t *profile, m_utf8_stat_t *stat)
+ * @brief copy src cut to columns, and add ellipsis and padding in one pass
+ * @note
+ *   src is read until the display width is over columns.
+ *   the ellipsis cut point is kept while reading, so src is not read again.
+ */
+static bool m_utf8_fit_columns(m_char8_t *dst, size_t dst_array_size, const uint8_t *src, size_t src_bytesize,
+                               size_t columns, m_utf8_align_t align, const m_char8_t *ellipsis,
+                               const m_utf8_width_profile_t *profile, m_utf8_stat_t *stat)
+{
+    size_t pad = align != M_UTF8_ALIGN_NONE ? 1 : 0;
+    size_t ellipsis_bytesize = 0;
+    size_t ellipsis_width = 0;
+    int64_t ellipsis_count = 0;
+
+    M_UTF8_STATS_API(M_UTF8_STATS_WIDTH, src_bytesize);
+    stat->byte_size = 0;
+    stat->char_count = 0;
+    stat->display_width = 0;
+    stat->error_offset = -1;
+    if (dst_array_size == 0)
+    {
+        return false;
+    }
+
+    size_t byte_limit = dst_array_size - 1;
+    if (ellipsis != NULL)
+    {
+        m_utf8_stat_t ellipsis_stat;
+        ellipsis_bytesize = strlen(ellipsis);
+        m_utf8_stat_scan((const uint8_t *)ellipsis, ellipsis_bytesize, false, profile, &ellipsis_stat);
+        ellipsis_width = (size_t)ellipsis_stat.display_width;
+        ellipsis_count = ellipsis_stat.char_count;
+        if (ellipsis_width > columns || ellipsis_bytesize > byte_limit)
+        {
+            ellipsis_bytesize = 0;
+            ellipsis_width = 0;
+            ellipsis_count = 0;
+        }
+    }
+
+    /* (str_size, width, char_count) is the fitting prefix, (cut_*) is the prefix before the ellipsis. */
+    size_t str_size = 0;
+    size_t width = 0;
+    int64_t char_count = 0;
+    size_t cut_size = 0;
+    size_t cut_width = 0;
+    int64_t cut_count = 0;
+    bool cut_found = false;
+    bool fits = true;
+
+    while (str_size < src_bytesize)
+    {
+#if defined(__SSE2__)
+        /* ASCII block is 16 bytes and 16 columns. */
+        while (!cut_found && str_size + 16 <= src_bytesize && width + 16 + ellipsis_width <= columns &&
+               str_size + 16 + ellipsis_bytesize <= byte_limit &&
+               _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(src + str_size))) == 0)
+        {
+            M_UTF8_STATS_ADD(fast_blocks, 1);
+            M_UTF8_STATS_ADD(char_count[0], 16);
+            str_size += 16;
+            width += 16;
+            char_count += 16;
+        }
+        if (str_size >= src_bytesize)
+            break;
+#endif
+        size_t ch_byte_size = 1;
+        size_t ch_width = 1;
+        if (src[str_size] >= 0x80)
+        {
+            uint32_t unicode;
+            ch_byte_size = m_utf8_jump_table[src[str_size]];
+            if (ch_byte_size > src_bytesize - str_size)
+            {
+                ch_byte_size = src_bytesize - str_size;
+                M_UTF8_STATS_ADD(invalid_count, 1);
+                if (stat->error_offset < 0)
+                    stat->error_offset = (int64_t)str_size;
+            }
+            else if (m_utf8_dfa_decode(src + str_size, ch_byte_size, &unicode) == 0)
+            {
+                M_UTF8_STATS_ADD(invalid_count, 1);
+                if (stat->error_offset < 0)
+                    stat->error_offset = (int64_t)str_size;
+            }
+            else
+            {
+                ch_width = profile->width_of_class[m_utf8_width_class(unicode)];
+            }
+        }
+
+        /* only the text and the ellipsis are charged to byte_limit, the padding is cut after them. */
+        if (!cut_found &&
+            (width + ch_width + ellipsis_width > columns || str_size + ch_byte_size + ellipsis_bytesize > byte_limit))
+        {
+            cut_size = str_size;
+            cut_width = width;
+            cut_count = char_count;
+            cut_found = true;
+        }
+        if (width + ch_width > columns || str_size + ch_byte_size > byte_limit)
+        {
+            fits = false;
+            break;
+        }
+        M_UTF8_STATS_CHAR(ch_byte_size);
+        str_size += ch_byte_size;
+        width += ch_width;
+        char_count++;
+    }
+
+    if (fits || ellipsis_bytesize == 0)
+    {
+        ellipsis_bytesize = 0;
+        ellipsis_width = 0;
+        ellipsis_count = 0;
+    }
+    else
+    {
+        str_size = cut_size;
+        width = cut_width;
+        char_count = cut_count;
+    }
+    if (stat->error_offset >= (int64_t)str_size)
+    {
+        stat->error_offset = -1;
+    }
+
+    size_t pad_width = 0;
+    if (pad)
+    {
+        pad_width = columns - width - ellipsis_width;
+        if (pad_width > byte_limit - str_size - ellipsis_bytesize)
+            pad_width = byte_limit - str_size - ellipsis_bytesize;
+    }
+    size_t left_width = align == M_UTF8_ALIGN_RIGHT ? pad_width : align == M_UTF8_ALIGN_CENTER ? pad_width / 2 : 0;
+
+    m_char8_t *ptr = dst;
+    memset(ptr, ' ', left_width);
+    ptr += left_width;
+    memcpy(ptr, src, str_size);
+    ptr += str_size;
+    if (ellipsis_bytesize > 0)
+    {
+        memcpy(ptr, ellipsis, ellipsis_bytesize);
+        ptr += ellipsis_bytesize;
+    }
+    memset(ptr, ' ', pad_width - left_width);
+    ptr += pad_width - left_width;
+    *ptr = '\0';
+
+    stat->byte_size = (int64_t)(ptr - dst);
+    stat->char_count = char_count + ellipsis_count + (int64_t)pad_width;
+    stat->display_width = (int64_t)(width + ellipsis_width + pad_width);
+
+    return fits;
+}
+
+/**
+ * @public
+ * @fn bool m_utf8_mem_fit_width(m_char8_t *dst, size_t dst_array_size, const m_char8_t *src, size_t src_bytesize, size_t columns, m_utf8_align_t align, const m_char8_t *ellipsis, const m_utf8_width_profile_t *profile, m_utf8_stat_t *stat)
+ * @brief fit utf8 buffer to display width
+ * @param[out] dst - array to save string( null-terminated)
+ * @param[in] dst_array_size - array size( add null-terminated string size)
+ * @param[in] src - utf8 buffer( null-terminated string is not needed)
+ * @param[in] src_bytesize - utf8 buffer byte size
+ * @param[in] columns - display width of the result
+ * @param[in] align - M_UTF8_ALIGN_NONE is not padding, others pad with spaces up to columns
+ * @param[in] ellipsis - utf8 string added when src is cut( null-terminated), NULL is not added
+ * @param[in] profile - width profile, NULL is same as m_utf8_display_width
+ * @param[out] stat - byte_size is dst byte size( not include null-terminated string size),
+ *                    char_count and display_width are of dst,
+ *                    error_offset is byte offset of the first invalid character in the copied src( -1 when none).
+ * @return true when src is not cut
+ * @note
+ *   a multibyte or wide character which does not fit is not copied, padding fills the column.
+ *   src is read only once and only up to columns.
+ *   when dst_array_size is too small, src is cut at the character boundary that fits,
+ *   and the padding is cut to the rest of dst( the return value is of src only).
+ *   enough dst_array_size is src_bytesize + ellipsis byte size + columns + 1.
+ */
+bool m_utf8_mem_fit_width(m_char8_t *dst, size_t dst_array_size, const m_char8_t *src, size_t src_bytesize,
+                          size_t columns, m_utf8_align_t align, const m_char8_t *ellipsis,
+                          const m_utf8_width_profile_t *profile, m_utf8_stat_t *stat)
+{
+    if (profile == NULL)
+    {
+        profile = M_UTF8_WIDTH_PROFILE_DEFAULT;
+    }
+
+    return m_utf8_fit_columns(dst, dst_array_size, (const uint8_t *)src, src_bytesize, columns, align, ellipsis,
+                              profile, stat);
+}
+
+/**
+ * @public
+ * @fn bool m_utf8_mem_truncate_width(m_char8_t *dst, size_t dst_array_size, const m_char8_t *src, size_t src_bytesize, size_t columns, const m_utf8_width_profile_t *profile, m_utf8_stat_t *stat)
+ * @brief copy utf8 buffer cut to display width
+ * @return true when src is not cut
+ * @note
+ *   same as m_utf8_mem_fit_width( align is M_UTF8_ALIGN_NONE, ellipsis is NULL).
+ */
+bool m_utf8_mem_truncate_width(m_char8_t *dst, size_t dst_array_size, const m_char8_t *src, size_t src_bytesize,
+                               size_t columns, const m_utf8_width_profile_t *profile, m_utf8_stat_t *stat)
+{
+    return m_utf8_mem_fit_width(dst, dst_array_size, src, src_bytesize, columns, M_UTF8_ALIGN_NONE, NULL, profile,
+                                stat);
+}
+
+/**
+ * @public
+ * @fn bool m_utf8_mem_pad_width(m_char8_t *dst, size_t dst_array_size, const m_char8_t *src, size_t src_bytesize, size_t columns, m_utf8_align_t align, const m_utf8_width_profile_t *profile, m_utf8_stat_t *stat)
+ * @brief copy utf8 buffer cut and padded to display width
+ * @return true when src is not cut
+ * @note
+ *   same as m_utf8_mem_fit_width( ellipsis is NULL).
+ */
+bool m_utf8_mem_pad_width(m_char8_t *dst, size_t dst_array_size, const m_char8_t *src, size_t src_bytesize,
+                          size_t columns, m_utf8_align_t align, const m_utf8_width_profile_t *profile,
+                          m_utf8_stat_t *stat)
+{
+    return m_utf8_mem_fit_width(dst, dst_array_size, src, src_bytesize, columns, align, NULL, profile, stat);
+}
+
+/**
+ * @public
+ * @fn bool m_utf8_mem_ellipsize_width(m_char8_t *dst, size_t dst_array_size, const m_char8_t *src, size_t src_bytesize, size_t columns, const m_char8_t *ellipsis, const m_utf8_width_profile_t *profile, m_utf8_stat_t *stat)
+ * @brief copy utf8 buffer cut to display width with ellipsis
+ * @param[in] ellipsis - utf8 string( null-terminated), NULL is "…"
+ * @return true when src is not cut
+ * @note
+ *   same as m_utf8_mem_fit_width( align is M_UTF8_ALIGN_NONE).
+ */
+bool m_utf8_mem_ellipsize_width(m_char8_t *dst, size_t dst_array_size, const m_char8_t *src, size_t src_bytesize,
+                                size_t columns, const m_char8_t *ellipsis, const m_utf8_width_profile_t *profile,
+                                m_utf8_stat_t *stat)
+{
+    if (ellipsis == NULL)
+    {
+        ellipsis = u8"…";
+    }
+
+    return m_utf8_mem_fit_width(dst, dst_array_size, src, src_bytesize, columns, M_UTF8_ALIGN_NONE, ellipsis,
+                                profile, stat);
+}
+
+/**
+ * @public
+ * @fn void m_utf8_builder_init(m_utf8_builder_t *builder, m_char8_t *buf, size_t buf_array_size)
+ * @brief initialize utf8 string builder with a fixed array
+ * @param[out] builder - utf8 string builder
+ * @param[in] buf - array to save string
+ * @param[in] buf_array_size - array size( add null-terminated string size)
+ * @note
+ *   appends which do not fit are truncated at the character boundary.
+ */
+void m_utf8_builder_init(m_utf8_builder_t *builder, m_char8_t *buf, size_t buf_array_size)
+{
+    builder->buf = buf;
+    builder->byte_size = 0;
+    builder->capacity = buf_array_size;
+    builder->char_count = -1;
+    builder->display_width = -1;
+    builder->profile = NULL;
+    builder->growable = false;
+    builder->truncated = false;
+    if (buf_array_size > 0)
+    {
+        buf[0] = '\0';
+    }
+}
+
+/**
+ * @public
+ * @fn bool m_utf8_builder_init_alloc(m_utf8_builder_t *builder, size_t buf_array_size)
+ * @brief initialize utf8 string builder with a growing array
+ * @param[out] builder - utf8 string builder
+ * @param[in] buf_array_size - initial array size
+ * @return false when allocation failed
+ * @note
+ *   release with m_utf8_builder_free.
+ */
+bool m_utf8_builder_init_alloc(m_utf8_builder_t *builder, size_t buf_array_size)
+{
+    if (buf_array_size < 16)
+    {
+        buf_array_size = 16;
+    }
+    m_char8_t *buf = malloc(buf_array_size);
+    m_utf8_builder_init(builder, buf, buf ? buf_array_size : 0);
+    builder->growable = buf != NULL;
+
+    return buf != NULL;
+}
+
+/**
+ * @public
+ * @fn void m_utf8_builder_free(m_utf8_builder_t *builder)
+ * @brief release the array of m_utf8_builder_init_alloc
+ * @param[in,out] builder - utf8 string builder
+ */
+void m_utf8_builder_free(m_utf8_builder_t *builder)
+{
+    if (builder->growable)
+    {
+        free(builder->buf);
+    }
+    m_utf8_builder_init(builder, NULL, 0);
+}
+
+/**
+ * @public
+ * @fn void m_utf8_builder_track(m_utf8_builder_t *builder, const m_utf8_width_profile_t *profile)
+ * @brief count characters and display width of the string while appending
+ * @param[in,out] builder - utf8 string builder
+ * @param[in] profile - width profile, NULL is same as m_utf8_display_width
+ * @note
+ *   char_count and display_width are -1 when not tracked.
+ *   append whole characters, a character split into two appends is counted twice.
+ */
+void m_utf8_builder_track(m_utf8_builder_t *builder, const m_utf8_width_profile_t *profile)
+{
+    m_utf8_stat_t stat;
+
+    builder->profile = profile ? profile : M_UTF8_WIDTH_PROFILE_DEFAULT;
+    m_utf8_stat_scan((const uint8_t *)builder->buf, builder->byte_size, false, builder->profile, &stat);
+    builder->char_count = stat.char_count;
+    builder->display_width = stat.display_width;
+}
+
+/**
+ * @private
+ * @fn static size_t m_utf8_builder_reserve(m_utf8_builder_t *builder, size_t str_bytesize)
+ * @brief make room for str_bytesize bytes
+ * @return room byte size( may be smaller than str_bytesize when not allocated)
+ */
+static size_t m_utf8_builder_reserve(m_utf8_builder_t *builder, size_t str_bytesize)
+{
+    if (builder->capacity == 0)
+    {
+        return 0;
+    }
+    /* the capacity is not grown past SIZE_MAX, the append is truncated instead. */
+    if (builder->growable && builder->capacity - 1 - builder->byte_size < str_bytesize &&
+        str_bytesize <= SIZE_MAX - 1 - builder->byte_size)
+    {
+        size_t need = builder->byte_size + 1 + str_bytesize;
+        size_t capacity = builder->capacity;
+        while (capacity < need && capacity <= SIZE_MAX / 2)
+        {
+            capacity *= 2;
+        }
+        if (capacity < need)
+        {
+            capacity = need;
+        }
+        m_char8_t *buf = realloc(builder->buf, capacity);
+        if (buf != NULL)
+        {
+            builder->buf = buf;
+            builder->capacity = capacity;
+        }
+    }
+
+    return builder->capacity - 1 - builder->byte_size;
+}
+
+/**
+ * @private
+ * @fn static void m_utf8_builder_commit(m_utf8_builder_t *builder, size_t str_bytesize)
+ * @brief add str_bytesize bytes written after the string
+ */
+static void m_utf8_builder_commit(m_utf8_builder_t *builder, size_t str_bytesize)
+{
+    if (builder->profile != NULL)
+    {
+        m_utf8_stat_t stat;
+        m_utf8_stat_scan((const uint8_t *)builder->buf + builder->byte_size, str_bytesize, false, builder->profile,
+                         &stat);
+        builder->char_count += stat.char_count;
+        builder->display_width += stat.display_width;
+    }
+    builder->byte_size += str_bytesize;
+    builder->buf[builder->byte_size] = '\0';
+}
+
+/**
+ * @public
+ * @fn bool m_utf8_builder_append(m_utf8_builder_t *builder, const m_char8_t *str, size_t str_bytesize)
+ * @brief append utf8 buffer
+ * @param[in,out] builder - utf8 string builder
+ * @param[in] str - utf8 buffer( null-terminated string is not needed)
+ * @param[in] str_bytesize - utf8 buffer byte size
+ * @return false when truncated
+ * @note
+ *   O(str_bytesize), the string is not scanned again.
+ */
+bool m_utf8_builder_append(m_utf8_builder_t *builder, const m_char8_t *str, size_t str_bytesize)
+{
+    size_t room = m_utf8_builder_reserve(builder, str_bytesize);
+    size_t copy_size = str_bytesize;
+
+    if (room < str_bytesize)
+    {
+        copy_size = m_utf8_char_boundary((const uint8_t *)str, room);
+        builder->truncated = true;
+    }
+    if (builder->capacity > 0)
+    {
+        memcpy(builder->buf + builder->byte_size, str, copy_size);
+        m_utf8_builder_commit(builder, copy_size);
+    }
+
+    return copy_size == str_bytesize;
+}
+
+/**
+ * @public
+ * @fn bool m_utf8_builder_append_str(m_utf8_builder_t *builder, const m_char8_t *str)
+ * @brief append utf8 string
+ * @param[in,out] builder - utf8 string builder
+ * @param[in] str - utf8 string( null-terminated)
+ * @return false when truncated
+ */
+bool m_utf8_builder_append_str(m_utf8_builder_t *builder, const m_char8_t *str)
+{
+    return m_utf8_builder_append(builder, str, strlen(str));
+}
+
+/**
+ * @public
+ * @fn bool m_utf8_builder_append_unicode(m_utf8_builder_t *builder, uint32_t unicode)
+ * @brief append unicode
+ * @param[in,out] builder - utf8 string builder
+ * @param[in] unicode - unicode
+ * @return false when truncated or unicode is invalid
+ */
+bool m_utf8_builder_append_unicode(m_utf8_builder_t *builder, uint32_t unicode)
+{
+    uint8_t character[4];
+    uint8_t character_size = m_utf8_encode_unicode(unicode, character);
+
+    if (character_size == 0)
+    {
+        return false;
+    }
+    return m_utf8_builder_append(builder, (const m_char8_t *)character, character_size);
+}
+
+/**
+ * @public
+ * @fn bool m_utf8_builder_append_int(m_utf8_builder_t *builder, int64_t value)
+ * @brief append decimal number
+ * @param[in,out] builder - utf8 string builder
+ * @param[in] value - number
+ * @return false when truncated
+ */
+bool m_utf8_builder_append_int(m_utf8_builder_t *builder, int64_t value)
+{
+    m_char8_t number[24];
+    m_char8_t *ptr = number + sizeof(number);
+    uint64_t abs_value = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+
+    do
+    {
+        *--ptr = (m_char8_t)('0' + abs_value % 10);
+        abs_value /= 10;
+    } while (abs_value > 0);
+    if (value < 0)
+    {
+        *--ptr = '-';
+    }
+
+    return m_utf8_builder_append(builder, ptr, (size_t)(number + sizeof(number) - ptr));
+}
+
+/**
+ * @public
+ * @fn bool m_utf8_builder_append_format(m_utf8_builder_t *builder, const char *format, ...)
+ * @brief append printf formatted string
+ * @param[in,out] builder - utf8 string builder
+ * @param[in] format - printf format
+ * @return false when truncated or format failed
+ */
+bool m_utf8_builder_append_format(m_utf8_builder_t *builder, const char *format, ...)
+{
+    va_list args;
+
+    if (builder->capacity == 0)
+    {
+        builder->truncated = true;
+        return false;
+    }
+
+    va_start(args, format);
+    size_t room = builder->capacity - builder->byte_size;
+    int str_bytesize = vsnprintf(builder->buf + builder->byte_size, room, format, args);
+    va_end(args);
+    if (str_bytesize < 0)
+    {
+        builder->buf[builder->byte_size] = '\0';
+        return false;
+    }
+
+    if ((size_t)str_bytesize >= room && m_utf8_builder_reserve(builder, (size_t)str_bytesize) >= (size_t)str_bytesize)
+    {
+        va_start(args, format);
+        vsnprintf(builder->buf + builder->byte_size, (size_t)str_bytesize + 1, format, args);
+        va_end(args);
+        room = (size_t)str_bytesize + 1;
+    }
+
+    size_t copy_size = (size_t)str_bytesize;
+    if (copy_size >= room)
+    {
+        copy_size = m_utf8_char_boundary((const uint8_t *)builder->buf + builder->byte_size, room - 1);
+        builder->truncated = true;
+    }
+    m_utf8_builder_commit(builder, copy_size);
+
+    return copy_size == (size_t)str_bytesize;
+}
+
+/**
+ * @public
+ * @fn void m_utf8_builder_truncate(m_utf8_builder_t *builder, size_t byte_size)
+ * @brief shorten the string
+ * @param[in,out] builder - utf8 string builder
+ * @param[in] byte_size - new byte size( not include null-terminated string size)
+ * @note
+ *   a character cut by byte_size is dropped.
+ */
+void m_utf8_builder_truncate(m_utf8_builder_t *builder, size_t byte_size)
+{
+    if (byte_size >= builder->byte_size)
+    {
+        return;
+    }
+
+    builder->byte_size = m_utf8_char_boundary((const uint8_t *)builder->buf, byte_size);
+    builder->buf[builder->byte_size] = '\0';
+    if (builder->profile != NULL)
+    {
+        m_utf8_builder_track(builder, builder->profile);
+    }
+}
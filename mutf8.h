@@ -1,15 +1,304 @@
 #ifndef MUTF8_H
 #define MUTF8_H
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+#if defined(M_UTF8_INLINE)
+#error "M_UTF8_INLINE is for C, include mutf8.hpp for compile-time functions in C++"
+#endif
+extern "C"
+{
+#endif
+
 typedef char m_char8_t;
-extern uint8_t m_utf8_ch_byte_size(const m_char8_t *character);
-extern bool m_utf8_ch_validate(const m_char8_t *character, size_t character_bytesize);
-extern uint32_t m_utf8_to_unicode(const m_char8_t *character);
-extern size_t m_utf8_display_width(const m_char8_t *character);
+
+/* U+FFFD, unicode of an invalid character */
+#define M_UTF8_REPLACEMENT_CHARACTER 0xFFFD
+
+/**
+ * @struct m_utf8_width_profile_t
+ * @brief display width profile, see m_utf8_width_profile
+ */
+typedef struct m_utf8_width_profile m_utf8_width_profile_t;
+
+/**
+ * @struct m_utf8_stat_t
+ * @brief result of m_utf8_str_stat
+ */
+typedef struct m_utf8_stat
+{
+    int64_t byte_size;     /* string byte size */
+    int64_t char_count;    /* character count */
+    int64_t display_width; /* display width */
+    int64_t error_offset;  /* byte offset of the first invalid character, -1 when none */
+} m_utf8_stat_t;
+
+/**
+ * @struct m_utf8_conv_t
+ * @brief result of the buffer conversion functions
+ */
+typedef struct m_utf8_conv
+{
+    int64_t src_read;     /* read source size */
+    int64_t dst_written;  /* written destination size */
+    int64_t error_offset; /* source offset of the first invalid character, -1 when none */
+} m_utf8_conv_t;
+
+/**
+ * @struct m_utf8_stream_t
+ * @brief state of chunked utf8 input, see m_utf8_stream_init
+ */
+typedef struct m_utf8_stream
+{
+    int64_t offset;       /* read byte size */
+    int64_t char_offset;  /* byte offset of the character split by the chunk */
+    int64_t error_offset; /* byte offset of the first invalid character, -1 when none */
+    uint32_t unicode;     /* decoded bits of the character split by the chunk */
+    uint8_t state;        /* decoder state */
+} m_utf8_stream_t;
+
+/**
+ * @enum m_utf8_align_t
+ * @brief padding side of m_utf8_mem_fit_width
+ */
+typedef enum m_utf8_align
+{
+    M_UTF8_ALIGN_NONE,   /* not padding */
+    M_UTF8_ALIGN_LEFT,   /* pad right side */
+    M_UTF8_ALIGN_RIGHT,  /* pad left side */
+    M_UTF8_ALIGN_CENTER, /* pad both sides */
+} m_utf8_align_t;
+
+/**
+ * @enum m_utf8_sanitize_t
+ * @brief invalid character handling of m_utf8_mem_sanitize
+ */
+typedef enum m_utf8_sanitize
+{
+    M_UTF8_SANITIZE_REPLACE, /* replace each maximal invalid subpart with U+FFFD */
+    M_UTF8_SANITIZE_DROP,    /* drop the invalid subparts */
+} m_utf8_sanitize_t;
+
+/**
+ * @enum m_utf8_norm_t
+ * @brief normalization form of m_utf8_mem_normalize
+ */
+typedef enum m_utf8_norm
+{
+    M_UTF8_NORM_NFC, /* canonical decomposition, then canonical composition */
+    M_UTF8_NORM_NFD, /* canonical decomposition */
+} m_utf8_norm_t;
+
+/**
+ * @enum m_utf8_search_t
+ * @brief match of m_utf8_mem_find, m_utf8_mem_find_all and m_utf8_mem_count
+ */
+typedef enum m_utf8_search
+{
+    M_UTF8_SEARCH_EXACT,       /* same bytes */
+    M_UTF8_SEARCH_IGNORE_CASE, /* same code points after the simple case folding( CaseFolding.txt C and S) */
+} m_utf8_search_t;
+
+/**
+ * @struct m_utf8_builder_t
+ * @brief utf8 string builder, see m_utf8_builder_init
+ */
+typedef struct m_utf8_builder
+{
+    m_char8_t *buf;                        /* null-terminated string */
+    size_t byte_size;                      /* string byte size( not include null-terminated string size) */
+    size_t capacity;                       /* array size of buf */
+    int64_t char_count;                    /* character count, see m_utf8_builder_track */
+    int64_t display_width;                 /* display width, see m_utf8_builder_track */
+    const m_utf8_width_profile_t *profile; /* width profile, NULL when not tracked */
+    bool growable;                         /* buf is allocated by m_utf8_builder_init_alloc */
+    bool truncated;                        /* some appends did not fit */
+} m_utf8_builder_t;
+
+/**
+ * @struct m_utf8_index_t
+ * @brief character index of utf8 buffer, see m_utf8_index_build
+ */
+typedef struct m_utf8_index
+{
+    struct m_utf8_index_point *points; /* checkpoints, sorted by byte offset */
+    size_t point_count;                /* checkpoint count */
+    size_t point_capacity;             /* array size of points */
+    size_t interval;                   /* characters between checkpoints */
+    int64_t byte_size;                 /* indexed buffer byte size */
+    int64_t char_count;                /* indexed buffer character count */
+    int64_t display_width;             /* indexed buffer display width, see m_utf8_index_build_width */
+    const m_utf8_width_profile_t *profile; /* width profile, NULL when the width is not tracked */
+} m_utf8_index_t;
+
+/**
+ * @enum m_utf8_simd_t
+ * @brief SIMD level of the accelerated kernels, see m_utf8_set_simd_level
+ */
+typedef enum m_utf8_simd
+{
+    M_UTF8_SIMD_SCALAR, /* no SIMD */
+    M_UTF8_SIMD_SSE2,   /* x86 SSE2 */
+    M_UTF8_SIMD_AVX2,   /* x86 AVX2 */
+    M_UTF8_SIMD_AVX512, /* x86 AVX-512 F and BW */
+} m_utf8_simd_t;
+
+/**
+ * @enum m_utf8_stats_api_t
+ * @brief API group of the counters, see m_utf8_stats_t
+ */
+typedef enum m_utf8_stats_api
+{
+    M_UTF8_STATS_VALIDATE,  /* m_utf8_str_validate, m_utf8_mem_validate, m_utf8_mem_valid_length */
+    M_UTF8_STATS_COUNT,     /* m_utf8_str_display_count, m_utf8_mem_display_count */
+    M_UTF8_STATS_STAT,      /* m_utf8_str_stat, m_utf8_mem_stat */
+    M_UTF8_STATS_CONVERT,   /* m_utf8_mem_to_unicode, m_utf8_mem_to_utf16 */
+    M_UTF8_STATS_SANITIZE,  /* m_utf8_mem_sanitize */
+    M_UTF8_STATS_WIDTH,     /* m_utf8_mem_fit_width and the other width functions */
+    M_UTF8_STATS_GRAPHEME,  /* m_utf8_mem_grapheme_count, m_utf8_str_grapheme_count */
+    M_UTF8_STATS_NORMALIZE, /* m_utf8_mem_norm_quick_check, m_utf8_mem_is_normalized, m_utf8_mem_normalize */
+    M_UTF8_STATS_SEARCH,    /* m_utf8_mem_find, m_utf8_mem_find_all, m_utf8_mem_count */
+    M_UTF8_STATS_API_SIZE,
+} m_utf8_stats_api_t;
+
+/**
+ * @struct m_utf8_stats_t
+ * @brief counters of the library built with M_UTF8_STATS, see m_utf8_stats_snapshot
+ * @note
+ *   every member is uint64_t.
+ *   an API called by another API is counted too, m_utf8_mem_normalize counts m_utf8_mem_valid_length.
+ */
+typedef struct m_utf8_stats
+{
+    uint64_t api_calls[M_UTF8_STATS_API_SIZE]; /* calls of each API group */
+    uint64_t api_bytes[M_UTF8_STATS_API_SIZE]; /* input byte size of each API group */
+    uint64_t char_count[4];    /* characters walked by the scan loops, by byte size( 1 to 4) */
+    uint64_t width_lookups[4]; /* width table lookups, by class( narrow, full, ambiguous, emoji) */
+    uint64_t invalid_count;    /* invalid characters found */
+    uint64_t fast_blocks;      /* SIMD blocks of ASCII only */
+    uint64_t slow_blocks;      /* SIMD blocks with other characters, checked fully or by the scan loop */
+} m_utf8_stats_t;
+
+/*
+ * the character primitives are static inline when M_UTF8_INLINE is defined, see mutf8_inline.h.
+ */
+#if defined(M_UTF8_INLINE)
+#define M_UTF8_INLINE_API static inline
+#else
+#define M_UTF8_INLINE_API extern
+#endif
+
+M_UTF8_INLINE_API uint8_t m_utf8_ch_byte_size(const m_char8_t *character);
+M_UTF8_INLINE_API bool m_utf8_ch_validate(const m_char8_t *character, size_t character_bytesize);
+M_UTF8_INLINE_API uint32_t m_utf8_to_unicode(const m_char8_t *character);
+M_UTF8_INLINE_API uint8_t m_utf8_ch_decode(const m_char8_t *character, size_t max_bytesize, uint32_t *unicode);
+M_UTF8_INLINE_API uint8_t m_utf8_ch_next(const m_char8_t *character, size_t max_bytesize, uint32_t *unicode,
+                                         bool *valid);
+M_UTF8_INLINE_API size_t m_utf8_ch_prev(const m_char8_t *str, size_t offset);
+M_UTF8_INLINE_API size_t m_utf8_display_width(const m_char8_t *character);
+M_UTF8_INLINE_API const m_utf8_width_profile_t *m_utf8_width_profile(bool ambiguous_wide, bool emoji_wide);
+M_UTF8_INLINE_API size_t m_utf8_unicode_width(uint32_t unicode, const m_utf8_width_profile_t *profile);
+M_UTF8_INLINE_API size_t m_utf8_display_width_profile(const m_char8_t *character, const m_utf8_width_profile_t *profile);
 extern int64_t m_utf8_str_byte_size(const m_char8_t *str, size_t max_str_bytesize);
 extern bool m_utf8_str_validate(const m_char8_t *str, size_t max_str_bytesize);
 extern int64_t m_utf8_str_display_count(const m_char8_t *str, size_t max_str_bytesize);
+extern bool m_utf8_str_stat(const m_char8_t *str, size_t max_str_bytesize, const m_utf8_width_profile_t *profile,
+                            m_utf8_stat_t *stat);
+extern bool m_utf8_mem_to_unicode(const m_char8_t *src, size_t src_bytesize, uint32_t *dst, size_t dst_size,
+                                  m_utf8_conv_t *conv);
+extern int64_t m_utf8_mem_utf16_size(const m_char8_t *src, size_t src_bytesize);
+extern bool m_utf8_mem_to_utf16(const m_char8_t *src, size_t src_bytesize, uint16_t *dst, size_t dst_size,
+                                m_utf8_conv_t *conv);
+extern uint8_t m_utf8_from_unicode(uint32_t unicode, m_char8_t *character);
+extern int64_t m_utf8_size_from_unicode(const uint32_t *src, size_t src_size);
+extern bool m_utf8_mem_from_unicode(const uint32_t *src, size_t src_size, m_char8_t *dst, size_t dst_bytesize,
+                                    m_utf8_conv_t *conv);
+extern int64_t m_utf8_size_from_utf16(const uint16_t *src, size_t src_size);
+extern bool m_utf8_mem_from_utf16(const uint16_t *src, size_t src_size, m_char8_t *dst, size_t dst_bytesize,
+                                  m_utf8_conv_t *conv);
+extern void m_utf8_stream_init(m_utf8_stream_t *stream);
+extern bool m_utf8_stream_feed(m_utf8_stream_t *stream, const m_char8_t *chunk, size_t chunk_bytesize);
+extern bool m_utf8_stream_decode(m_utf8_stream_t *stream, const m_char8_t *chunk, size_t chunk_bytesize, uint32_t *dst,
+                                 size_t dst_size, m_utf8_conv_t *conv);
+extern bool m_utf8_stream_finish(m_utf8_stream_t *stream);
 extern bool m_utf8_str_cpy(m_char8_t *dst, const size_t dst_array_size, const m_char8_t *src, size_t src_size);
+extern int64_t m_utf8_str_cpy_size(m_char8_t *dst, size_t dst_array_size, const m_char8_t *src, size_t src_size);
 extern bool m_utf8_str_cat(m_char8_t *dst, const size_t dst_array_size, const m_char8_t *src, size_t src_size);
+extern int64_t m_utf8_mem_byte_size(const m_char8_t *str, size_t str_bytesize);
+extern bool m_utf8_mem_validate(const m_char8_t *str, size_t str_bytesize);
+extern int64_t m_utf8_mem_valid_length(const m_char8_t *str, size_t str_bytesize);
+extern int64_t m_utf8_mem_display_count(const m_char8_t *str, size_t str_bytesize);
+extern bool m_utf8_mem_stat(const m_char8_t *str, size_t str_bytesize, const m_utf8_width_profile_t *profile,
+                            m_utf8_stat_t *stat);
+extern int64_t m_utf8_mem_cpy(m_char8_t *dst, size_t dst_array_size, const m_char8_t *src, size_t src_bytesize);
+extern int64_t m_utf8_mem_sanitize(m_char8_t *dst, size_t dst_bytesize, const m_char8_t *src, size_t src_bytesize,
+                                   m_utf8_sanitize_t mode, m_utf8_conv_t *conv);
+extern bool m_utf8_mem_fit_width(m_char8_t *dst, size_t dst_array_size, const m_char8_t *src, size_t src_bytesize,
+                                 size_t columns, m_utf8_align_t align, const m_char8_t *ellipsis,
+                                 const m_utf8_width_profile_t *profile, m_utf8_stat_t *stat);
+extern bool m_utf8_mem_truncate_width(m_char8_t *dst, size_t dst_array_size, const m_char8_t *src, size_t src_bytesize,
+                                      size_t columns, const m_utf8_width_profile_t *profile, m_utf8_stat_t *stat);
+extern bool m_utf8_mem_pad_width(m_char8_t *dst, size_t dst_array_size, const m_char8_t *src, size_t src_bytesize,
+                                 size_t columns, m_utf8_align_t align, const m_utf8_width_profile_t *profile,
+                                 m_utf8_stat_t *stat);
+extern bool m_utf8_mem_ellipsize_width(m_char8_t *dst, size_t dst_array_size, const m_char8_t *src,
+                                       size_t src_bytesize, size_t columns, const m_char8_t *ellipsis,
+                                       const m_utf8_width_profile_t *profile, m_utf8_stat_t *stat);
+extern bool m_utf8_mem_validate_parallel(const m_char8_t *str, size_t str_bytesize, unsigned int threads);
+extern int64_t m_utf8_mem_display_count_parallel(const m_char8_t *str, size_t str_bytesize, unsigned int threads);
+extern bool m_utf8_mem_stat_parallel(const m_char8_t *str, size_t str_bytesize, const m_utf8_width_profile_t *profile,
+                                     m_utf8_stat_t *stat, unsigned int threads);
+extern bool m_utf8_str_validate_parallel(const m_char8_t *str, size_t max_str_bytesize, unsigned int threads);
+extern int64_t m_utf8_mem_norm_quick_check(const m_char8_t *str, size_t str_bytesize, m_utf8_norm_t form);
+extern bool m_utf8_mem_is_normalized(const m_char8_t *str, size_t str_bytesize, m_utf8_norm_t form);
+extern bool m_utf8_mem_normalize(m_char8_t *dst, size_t dst_bytesize, const m_char8_t *src, size_t src_bytesize,
+                                 m_utf8_norm_t form, m_utf8_conv_t *conv);
+extern int64_t m_utf8_mem_find(const m_char8_t *str, size_t str_bytesize, const m_char8_t *pattern,
+                               size_t pattern_bytesize, m_utf8_search_t search, size_t *match_bytesize);
+extern int64_t m_utf8_mem_find_all(const m_char8_t *str, size_t str_bytesize, const m_char8_t *pattern,
+                                   size_t pattern_bytesize, m_utf8_search_t search, int64_t *offsets,
+                                   size_t offsets_size);
+extern int64_t m_utf8_mem_count(const m_char8_t *str, size_t str_bytesize, const m_char8_t *pattern,
+                                size_t pattern_bytesize, m_utf8_search_t search);
+extern uint32_t m_utf8_unicode_fold(uint32_t unicode);
+extern int64_t m_utf8_grapheme_next(const m_char8_t *str, size_t str_bytesize, size_t offset);
+extern int64_t m_utf8_mem_grapheme_count(const m_char8_t *str, size_t str_bytesize);
+extern int64_t m_utf8_str_grapheme_count(const m_char8_t *str, size_t max_str_bytesize);
+extern void m_utf8_builder_init(m_utf8_builder_t *builder, m_char8_t *buf, size_t buf_array_size);
+extern bool m_utf8_builder_init_alloc(m_utf8_builder_t *builder, size_t buf_array_size);
+extern void m_utf8_builder_free(m_utf8_builder_t *builder);
+extern void m_utf8_builder_track(m_utf8_builder_t *builder, const m_utf8_width_profile_t *profile);
+extern bool m_utf8_builder_append(m_utf8_builder_t *builder, const m_char8_t *str, size_t str_bytesize);
+extern bool m_utf8_builder_append_str(m_utf8_builder_t *builder, const m_char8_t *str);
+extern bool m_utf8_builder_append_unicode(m_utf8_builder_t *builder, uint32_t unicode);
+extern bool m_utf8_builder_append_int(m_utf8_builder_t *builder, int64_t value);
+extern bool m_utf8_builder_append_format(m_utf8_builder_t *builder, const char *format, ...);
+extern void m_utf8_builder_truncate(m_utf8_builder_t *builder, size_t byte_size);
+extern m_utf8_simd_t m_utf8_simd_supported(void);
+extern m_utf8_simd_t m_utf8_simd_level(void);
+extern m_utf8_simd_t m_utf8_set_simd_level(m_utf8_simd_t level);
+extern bool m_utf8_stats_snapshot(m_utf8_stats_t *stats);
+extern void m_utf8_stats_reset(void);
+extern bool m_utf8_index_build(m_utf8_index_t *index, const m_char8_t *str, size_t str_bytesize, size_t interval);
+extern bool m_utf8_index_build_width(m_utf8_index_t *index, const m_char8_t *str, size_t str_bytesize, size_t interval,
+                                     const m_utf8_width_profile_t *profile);
+extern void m_utf8_index_free(m_utf8_index_t *index);
+extern bool m_utf8_index_update(m_utf8_index_t *index, const m_char8_t *str, size_t str_bytesize, size_t edit_offset,
+                                size_t removed_bytesize, size_t inserted_bytesize);
+extern int64_t m_utf8_index_byte_offset(const m_utf8_index_t *index, const m_char8_t *str, int64_t char_index);
+extern int64_t m_utf8_index_char_index(const m_utf8_index_t *index, const m_char8_t *str, int64_t byte_offset);
+extern int64_t m_utf8_index_column(const m_utf8_index_t *index, const m_char8_t *str, int64_t byte_offset);
+extern int64_t m_utf8_index_column_offset(const m_utf8_index_t *index, const m_char8_t *str, int64_t column);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#if defined(M_UTF8_INLINE)
+#include "mutf8_inline.h"
+#endif
 
 #endif /* end MUTF_8 */
@@ -0,0 +1,547 @@
+#ifndef MUTF8_HPP
+#define MUTF8_HPP
+
+/*
+ * compile-time utf8 validation, length and display width( C++17).
+ *
+ * every function is constexpr and returns same result as the C function of mutf8.h,
+ * so string literals and UI constants are checked and measured by the compiler.
+ *
+ *   static_assert(mutf8::validate(u8"メニュー"));
+ *   constexpr auto menu_width = mutf8::display_width(u8"メニュー"); // 8
+ *   constexpr mutf8::literal title = u8"タイトル";                   // compile error when invalid
+ *
+ *   for (char32_t c : mutf8::utf8_view(line)) // decode once per step, no allocation
+ */
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string_view>
+#if __cplusplus >= 202002L && __has_include(<ranges>)
+#include <ranges>
+#endif
+
+#include "mutf8_decode_table.h"
+#include "mutf8_width_table.h"
+
+namespace mutf8
+{
+/* U+FFFD, unicode of an invalid character( same as M_UTF8_REPLACEMENT_CHARACTER) */
+inline constexpr char32_t replacement_character = 0xFFFD;
+
+namespace detail
+{
+/**
+ * @private
+ * @fn constexpr std::size_t ch_byte_size(unsigned char lead)
+ * @brief same as m_utf8_ch_byte_size
+ */
+constexpr std::size_t ch_byte_size(unsigned char lead)
+{
+    return m_utf8_jump_table[lead];
+}
+
+/**
+ * @private
+ * @fn constexpr std::size_t decode(const CharT *character, std::size_t max_bytesize, char32_t &unicode)
+ * @brief same as m_utf8_ch_decode, the DFA of mutf8_decode_table.h
+ * @return utf8 character byte size, 0 when invalid or truncated by max_bytesize.
+ */
+template <typename CharT>
+constexpr std::size_t decode(const CharT *character, std::size_t max_bytesize, char32_t &unicode)
+{
+    if (max_bytesize == 0)
+        return 0;
+
+    const auto lead = static_cast<unsigned char>(character[0]);
+    const auto byte_class = m_utf8_dfa_class_table[lead];
+    auto state = m_utf8_dfa_transition[M_UTF8_DFA_ACCEPT][byte_class];
+    char32_t c = lead & m_utf8_dfa_lead_mask[byte_class];
+    std::size_t i = 1;
+
+    while (state > M_UTF8_DFA_ACCEPT && i < max_bytesize)
+    {
+        const auto byte = static_cast<unsigned char>(character[i++]);
+        c = (c << 6) | (byte & 0x3F);
+        state = m_utf8_dfa_transition[state][m_utf8_dfa_class_table[byte]];
+    }
+
+    if (state != M_UTF8_DFA_ACCEPT)
+        return 0;
+    unicode = c;
+    return i;
+}
+
+template <typename CharT>
+constexpr std::size_t valid_length(const CharT *str, std::size_t str_bytesize)
+{
+    std::size_t str_size = 0;
+    char32_t unicode = 0;
+
+    while (str_size < str_bytesize)
+    {
+        std::size_t size = decode(str + str_size, str_bytesize - str_size, unicode);
+        if (size == 0)
+            break;
+        str_size += size;
+    }
+    return str_size;
+}
+
+template <typename CharT>
+constexpr std::int64_t length(const CharT *str, std::size_t str_bytesize)
+{
+    std::size_t str_size = 0;
+    std::int64_t char_count = 0;
+
+    while (str_size < str_bytesize)
+    {
+        str_size += ch_byte_size(static_cast<unsigned char>(str[str_size]));
+        char_count++;
+    }
+    return char_count;
+}
+
+/**
+ * @private
+ * @fn constexpr std::size_t next(const CharT *str, std::size_t max_bytesize, char32_t &unicode, bool &valid)
+ * @brief same as m_utf8_ch_next
+ */
+template <typename CharT>
+constexpr std::size_t next(const CharT *str, std::size_t max_bytesize, char32_t &unicode, bool &valid)
+{
+    if (max_bytesize == 0)
+        return 0;
+
+    const auto lead = static_cast<unsigned char>(str[0]);
+    valid = true;
+    if (lead < 0x80)
+    {
+        unicode = lead;
+        return 1;
+    }
+
+    std::size_t size = ch_byte_size(lead);
+    if (size > max_bytesize)
+        size = max_bytesize;
+    if (decode(str, size, unicode) == size)
+        return size;
+
+    std::size_t limit = size < 4 ? size : 4;
+    std::size_t i = 1;
+    while (i < limit && (static_cast<unsigned char>(str[i]) & 0xC0) == 0x80)
+        i++;
+    unicode = replacement_character;
+    valid = false;
+    return i;
+}
+
+/**
+ * @private
+ * @fn constexpr std::size_t prev(const CharT *str, std::size_t offset)
+ * @brief same as m_utf8_ch_prev
+ */
+template <typename CharT>
+constexpr std::size_t prev(const CharT *str, std::size_t offset)
+{
+    char32_t unicode = 0;
+    bool valid = false;
+
+    if (offset == 0)
+        return 0;
+    std::size_t lead = offset - 1;
+    while (lead > 0 && offset - lead < 4 && (static_cast<unsigned char>(str[lead]) & 0xC0) == 0x80)
+        lead--;
+    if (lead + next(str + lead, offset - lead, unicode, valid) == offset)
+        return lead;
+    return offset - 1;
+}
+
+template <typename CharT>
+constexpr std::int64_t display_width(const CharT *str, std::size_t str_bytesize, bool ambiguous_wide,
+                                     bool emoji_wide);
+} // namespace detail
+
+/**
+ * @public
+ * @fn constexpr std::size_t unicode_width(char32_t unicode, bool ambiguous_wide = true, bool emoji_wide = true)
+ * @brief same as m_utf8_unicode_width with m_utf8_width_profile(ambiguous_wide, emoji_wide)
+ * @return display width( 1 or 2)
+ */
+constexpr std::size_t unicode_width(char32_t unicode, bool ambiguous_wide = true, bool emoji_wide = true)
+{
+    if (unicode > 0x10FFFF)
+        unicode = 0;
+
+    std::uint32_t block = m_utf8_width_stage1[unicode >> M_UTF8_WIDTH_SHIFT];
+    switch (m_utf8_width_stage2[(block << M_UTF8_WIDTH_SHIFT) | (unicode & M_UTF8_WIDTH_MASK)])
+    {
+    case M_UTF8_WIDTH_FULL:
+        return 2;
+    case M_UTF8_WIDTH_AMBIGUOUS:
+        return ambiguous_wide ? 2 : 1;
+    case M_UTF8_WIDTH_EMOJI:
+        return emoji_wide ? 2 : 1;
+    default:
+        return 1;
+    }
+}
+
+template <typename CharT>
+constexpr std::int64_t detail::display_width(const CharT *str, std::size_t str_bytesize, bool ambiguous_wide,
+                                             bool emoji_wide)
+{
+    std::size_t str_size = 0;
+    std::int64_t width = 0;
+    char32_t unicode = 0;
+
+    while (str_size < str_bytesize)
+    {
+        std::size_t size = ch_byte_size(static_cast<unsigned char>(str[str_size]));
+        if (size > str_bytesize - str_size)
+        {
+            width++;
+            break;
+        }
+        if (decode(str + str_size, size, unicode) == 0)
+            width++;
+        else
+            width += static_cast<std::int64_t>(unicode_width(unicode, ambiguous_wide, emoji_wide));
+        str_size += size;
+    }
+    return width;
+}
+
+/**
+ * @public
+ * @fn constexpr std::size_t valid_length(std::string_view str)
+ * @brief byte offset of the first invalid character, str.size() when all valid
+ */
+constexpr std::size_t valid_length(std::string_view str)
+{
+    return detail::valid_length(str.data(), str.size());
+}
+
+/**
+ * @public
+ * @fn constexpr bool validate(std::string_view str)
+ * @brief same as m_utf8_mem_validate
+ */
+constexpr bool validate(std::string_view str)
+{
+    return valid_length(str) == str.size();
+}
+
+/**
+ * @public
+ * @fn constexpr std::int64_t length(std::string_view str)
+ * @brief character count, same as m_utf8_mem_display_count
+ */
+constexpr std::int64_t length(std::string_view str)
+{
+    return detail::length(str.data(), str.size());
+}
+
+/**
+ * @public
+ * @fn constexpr std::int64_t display_width(std::string_view str, bool ambiguous_wide = true, bool emoji_wide = true)
+ * @brief display width, same as display_width of m_utf8_mem_stat
+ */
+constexpr std::int64_t display_width(std::string_view str, bool ambiguous_wide = true, bool emoji_wide = true)
+{
+    return detail::display_width(str.data(), str.size(), ambiguous_wide, emoji_wide);
+}
+
+#if defined(__cpp_char8_t)
+constexpr std::size_t valid_length(std::u8string_view str)
+{
+    return detail::valid_length(str.data(), str.size());
+}
+
+constexpr bool validate(std::u8string_view str)
+{
+    return valid_length(str) == str.size();
+}
+
+constexpr std::int64_t length(std::u8string_view str)
+{
+    return detail::length(str.data(), str.size());
+}
+
+constexpr std::int64_t display_width(std::u8string_view str, bool ambiguous_wide = true, bool emoji_wide = true)
+{
+    return detail::display_width(str.data(), str.size(), ambiguous_wide, emoji_wide);
+}
+#endif
+
+/*
+ * string literal, the terminating null is not a part of the string.
+ */
+template <typename CharT, std::size_t N>
+constexpr std::size_t valid_length(const CharT (&str)[N])
+{
+    return detail::valid_length(str, N - 1);
+}
+
+template <typename CharT, std::size_t N>
+constexpr bool validate(const CharT (&str)[N])
+{
+    return detail::valid_length(str, N - 1) == N - 1;
+}
+
+template <typename CharT, std::size_t N>
+constexpr std::int64_t length(const CharT (&str)[N])
+{
+    return detail::length(str, N - 1);
+}
+
+template <typename CharT, std::size_t N>
+constexpr std::int64_t display_width(const CharT (&str)[N], bool ambiguous_wide = true, bool emoji_wide = true)
+{
+    return detail::display_width(str, N - 1, ambiguous_wide, emoji_wide);
+}
+
+/**
+ * @public
+ * @class literal
+ * @brief string literal validated and measured at compile time
+ * @note
+ *   a constexpr literal of invalid utf8 is a compile error.
+ */
+template <typename CharT, std::size_t N>
+class literal
+{
+  public:
+    constexpr literal(const CharT (&str)[N])
+        : str_(str), length_(mutf8::length(str)), display_width_(mutf8::display_width(str))
+    {
+        if (!mutf8::validate(str))
+            throw "mutf8::literal: invalid utf8";
+    }
+
+    constexpr std::basic_string_view<CharT> view() const
+    {
+        return std::basic_string_view<CharT>(str_, N - 1);
+    }
+    constexpr const CharT *c_str() const
+    {
+        return str_;
+    }
+    constexpr std::size_t byte_size() const
+    {
+        return N - 1;
+    }
+    constexpr std::int64_t length() const
+    {
+        return length_;
+    }
+    constexpr std::int64_t display_width() const
+    {
+        return display_width_;
+    }
+
+  private:
+    const CharT *str_;
+    std::int64_t length_;
+    std::int64_t display_width_;
+};
+
+/**
+ * @public
+ * @class basic_utf8_view
+ * @brief code points of a utf8 string, without copy
+ * @note
+ *   the iterator is bidirectional and decodes once per step( same step as m_utf8_ch_next).
+ *   an invalid character is replacement_character, see iterator::valid.
+ *   the string must outlive the view.
+ */
+template <typename CharT>
+class basic_utf8_view
+{
+  public:
+    class iterator
+    {
+      public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = char32_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = char32_t;
+
+        constexpr iterator() = default;
+
+        constexpr char32_t operator*() const
+        {
+            return unicode_;
+        }
+
+        constexpr iterator &operator++()
+        {
+            offset_ += size_;
+            decode();
+            return *this;
+        }
+        constexpr iterator operator++(int)
+        {
+            iterator it = *this;
+            ++*this;
+            return it;
+        }
+        constexpr iterator &operator--()
+        {
+            offset_ = detail::prev(str_, offset_);
+            decode();
+            return *this;
+        }
+        constexpr iterator operator--(int)
+        {
+            iterator it = *this;
+            --*this;
+            return it;
+        }
+
+        friend constexpr bool operator==(const iterator &a, const iterator &b)
+        {
+            return a.offset_ == b.offset_;
+        }
+        friend constexpr bool operator!=(const iterator &a, const iterator &b)
+        {
+            return a.offset_ != b.offset_;
+        }
+
+        /* false when the character is invalid */
+        constexpr bool valid() const
+        {
+            return valid_;
+        }
+        /* byte offset of the character */
+        constexpr std::size_t offset() const
+        {
+            return offset_;
+        }
+        /* byte size of the character */
+        constexpr std::size_t size() const
+        {
+            return size_;
+        }
+        /* bytes of the character */
+        constexpr std::basic_string_view<CharT> bytes() const
+        {
+            return std::basic_string_view<CharT>(str_ + offset_, size_);
+        }
+
+        /**
+         * @fn std::size_t skip_ascii()
+         * @brief step over the ASCII characters from the current one, 8 bytes at a time
+         * @return count of the skipped characters
+         */
+        std::size_t skip_ascii()
+        {
+            std::size_t offset = offset_;
+
+            while (offset + 8 <= str_bytesize_)
+            {
+                std::uint64_t block;
+                std::memcpy(&block, str_ + offset, sizeof(block));
+                if (block & UINT64_C(0x8080808080808080))
+                    break;
+                offset += 8;
+            }
+            while (offset < str_bytesize_ && static_cast<unsigned char>(str_[offset]) < 0x80)
+                offset++;
+
+            std::size_t skipped = offset - offset_;
+            if (skipped != 0)
+            {
+                offset_ = offset;
+                decode();
+            }
+            return skipped;
+        }
+
+      private:
+        friend class basic_utf8_view;
+
+        constexpr iterator(const CharT *str, std::size_t str_bytesize, std::size_t offset)
+            : str_(str), str_bytesize_(str_bytesize), offset_(offset)
+        {
+            decode();
+        }
+
+        constexpr void decode()
+        {
+            size_ = detail::next(str_ + offset_, str_bytesize_ - offset_, unicode_, valid_);
+        }
+
+        const CharT *str_ = nullptr;
+        std::size_t str_bytesize_ = 0;
+        std::size_t offset_ = 0;
+        std::size_t size_ = 0;
+        char32_t unicode_ = 0;
+        bool valid_ = false;
+    };
+    using const_iterator = iterator;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+
+    constexpr basic_utf8_view() = default;
+    constexpr basic_utf8_view(std::basic_string_view<CharT> str) : str_(str)
+    {
+    }
+    constexpr basic_utf8_view(const CharT *str, std::size_t str_bytesize) : str_(str, str_bytesize)
+    {
+    }
+
+    constexpr iterator begin() const
+    {
+        return iterator(str_.data(), str_.size(), 0);
+    }
+    constexpr iterator end() const
+    {
+        return iterator(str_.data(), str_.size(), str_.size());
+    }
+    constexpr reverse_iterator rbegin() const
+    {
+        return reverse_iterator(end());
+    }
+    constexpr reverse_iterator rend() const
+    {
+        return reverse_iterator(begin());
+    }
+
+    constexpr bool empty() const
+    {
+        return str_.empty();
+    }
+    /* string of the view */
+    constexpr std::basic_string_view<CharT> view() const
+    {
+        return str_;
+    }
+    /* string between two iterators of the view */
+    constexpr std::basic_string_view<CharT> view(const iterator &first, const iterator &last) const
+    {
+        return str_.substr(first.offset(), last.offset() - first.offset());
+    }
+
+  private:
+    std::basic_string_view<CharT> str_;
+};
+
+using utf8_view = basic_utf8_view<char>;
+#if defined(__cpp_char8_t)
+using u8_view = basic_utf8_view<char8_t>;
+#endif
+} // namespace mutf8
+
+#if defined(__cpp_lib_ranges)
+namespace std::ranges
+{
+template <typename CharT>
+inline constexpr bool enable_borrowed_range<mutf8::basic_utf8_view<CharT>> = true;
+template <typename CharT>
+inline constexpr bool enable_view<mutf8::basic_utf8_view<CharT>> = true;
+} // namespace std::ranges
+#endif
+
+#endif /* end MUTF8_HPP */
@@ -0,0 +1,171 @@
+#ifndef MUTF8_DECODE_TABLE_H
+#define MUTF8_DECODE_TABLE_H
+
+/*
+ * byte size and decoder DFA tables of mutf8.
+ *
+ * shared by mutf8_inline.h and mutf8.hpp, so the C functions and the constexpr functions of C++
+ * decode with the same tables. the initializers are positional, C and C++ read them same.
+ */
+
+/* constexpr in C++, so mutf8.hpp can read the tables at compile time. */
+#if defined(__cplusplus)
+#define M_UTF8_DECODE_TABLE_CONST static constexpr
+#else
+#define M_UTF8_DECODE_TABLE_CONST static const
+#endif
+
+/**
+ * @private
+ * @var uint8_t m_utf8_jump_table[256]
+ * @author Atsushi Enomoto  <atsushi@ximian.com>
+ * @sa https://github.com/corngood/mono/blob/master/eglib/src/gutf8.c
+ * 
+ * @note
+ *  base var is "const guchar g_utf8_jump_table[256]".
+ */
+/*
+ * Index into the table below with the first byte of a UTF-8 sequence to get
+ * the number of bytes that are supposed to follow it to complete the sequence.
+ *
+ * Note that *legal* UTF-8 values can't have 5-bytes or 6-bytes. The table is left
+ * as-is for anyone who may want to do such conversion, which was allowed in
+ * earlier algorithms.
+*/
+M_UTF8_DECODE_TABLE_CONST uint8_t m_utf8_jump_table[256] = {
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4, 5, 5, 5, 5, 6, 6, 1, 1};
+
+/**
+ * @private
+ * @enum m_utf8_dfa_class
+ * @brief byte class of the decoder DFA
+ */
+enum m_utf8_dfa_class
+{
+    M_UTF8_DFA_ASCII, /* 00..7F */
+    M_UTF8_DFA_C80,   /* 80..8E */
+    M_UTF8_DFA_C8F,   /* 8F */
+    M_UTF8_DFA_C90,   /* 90..9E */
+    M_UTF8_DFA_C9F,   /* 9F */
+    M_UTF8_DFA_CA0,   /* A0..AE */
+    M_UTF8_DFA_CAF,   /* AF */
+    M_UTF8_DFA_CB0,   /* B0..B6 */
+    M_UTF8_DFA_CB7,   /* B7 */
+    M_UTF8_DFA_CB8,   /* B8..BD */
+    M_UTF8_DFA_CBE,   /* BE */
+    M_UTF8_DFA_CBF,   /* BF */
+    M_UTF8_DFA_L2,    /* C2..DF */
+    M_UTF8_DFA_LE0,   /* E0 */
+    M_UTF8_DFA_L3,    /* E1..EC, EE */
+    M_UTF8_DFA_LED,   /* ED */
+    M_UTF8_DFA_LEF,   /* EF */
+    M_UTF8_DFA_LF0,   /* F0 */
+    M_UTF8_DFA_L4,    /* F1..F3 */
+    M_UTF8_DFA_LF4,   /* F4 */
+    M_UTF8_DFA_ILLEGAL, /* C0, C1, F5..FF */
+    M_UTF8_DFA_CLASS_SIZE
+};
+
+/**
+ * @private
+ * @enum m_utf8_dfa_state
+ * @brief state of the decoder DFA
+ * @note
+ *   REJECT is 0, so a missing transition rejects.
+ *   the states after EF, F0..F4 are split to reject noncharacters same as m_utf8_ch_validate.
+ */
+enum m_utf8_dfa_state
+{
+    M_UTF8_DFA_REJECT,
+    M_UTF8_DFA_ACCEPT,
+    M_UTF8_DFA_NEED1, /* 1 continuation byte left */
+    M_UTF8_DFA_NEED2, /* 2 continuation bytes left */
+    M_UTF8_DFA_E0,    /* E0 _, A0..BF */
+    M_UTF8_DFA_ED,    /* ED _, 80..9F */
+    M_UTF8_DFA_EF,    /* EF _ */
+    M_UTF8_DFA_EFB7,  /* EF B7 _, not U+FDD0..U+FDEF */
+    M_UTF8_DFA_EFBF,  /* EF BF _, not U+FFFE, U+FFFF */
+    M_UTF8_DFA_F0,    /* F0 _, 90..BF */
+    M_UTF8_DFA_F1,    /* F1..F3 _ */
+    M_UTF8_DFA_F4,    /* F4 _, 80..8F */
+    M_UTF8_DFA_PLANE_END3, /* F? ?F _ */
+    M_UTF8_DFA_PLANE_END4, /* F? ?F BF _, not U+xFFFE, U+xFFFF */
+    M_UTF8_DFA_STATE_SIZE
+};
+
+/**
+ * @private
+ * @var M_UTF8_DECODE_TABLE_CONST uint8_t m_utf8_dfa_class_table[256]
+ * @brief byte to m_utf8_dfa_class
+ */
+// clang-format off
+M_UTF8_DECODE_TABLE_CONST uint8_t m_utf8_dfa_class_table[256] = {
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, /* 00..0F */
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, /* 10..1F */
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, /* 20..2F */
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, /* 30..3F */
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, /* 40..4F */
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, /* 50..5F */
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, /* 60..6F */
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, /* 70..7F */
+     1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  2, /* 80..8F */
+     3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  4, /* 90..9F */
+     5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  6, /* A0..AF */
+     7,  7,  7,  7,  7,  7,  7,  8,  9,  9,  9,  9,  9,  9, 10, 11, /* B0..BF */
+    20, 20, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, /* C0..CF */
+    12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, /* D0..DF */
+    13, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 15, 14, 16, /* E0..EF */
+    17, 18, 18, 18, 19, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, /* F0..FF */
+};
+// clang-format on
+
+/**
+ * @private
+ * @var static const uint8_t m_utf8_dfa_lead_mask[M_UTF8_DFA_CLASS_SIZE]
+ * @brief payload bits of the first byte
+ */
+// clang-format off
+M_UTF8_DECODE_TABLE_CONST uint8_t m_utf8_dfa_lead_mask[M_UTF8_DFA_CLASS_SIZE] = {
+    0x7F,                                                                   /* ASCII */
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,       /* 80..BF */
+    0x1F, 0x0F, 0x0F, 0x0F, 0x0F, 0x07, 0x07, 0x07,                         /* L2, E0, L3, ED, EF, F0, L4, F4 */
+    0x00,                                                                   /* ILLEGAL */
+};
+// clang-format on
+
+/**
+ * @private
+ * @var static const uint8_t m_utf8_dfa_transition[M_UTF8_DFA_STATE_SIZE][M_UTF8_DFA_CLASS_SIZE]
+ * @brief next m_utf8_dfa_state
+ * @note
+ *   a row is a m_utf8_dfa_state, a column is a m_utf8_dfa_class.
+ * @sa http://bjoern.hoehrmann.de/utf-8/decoder/dfa/
+ */
+// clang-format off
+M_UTF8_DECODE_TABLE_CONST uint8_t m_utf8_dfa_transition[M_UTF8_DFA_STATE_SIZE][M_UTF8_DFA_CLASS_SIZE] = {
+    /* AS  80  8F  90  9F  A0  AF  B0  B7  B8  BE  BF  L2  E0  L3  ED  EF  F0  L4  F4  IL */
+    { 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0}, /* REJECT */
+    { 1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  2,  4,  3,  5,  6,  9, 10, 11,  0}, /* ACCEPT */
+    { 0,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  0,  0,  0,  0,  0,  0,  0,  0,  0}, /* NEED1 */
+    { 0,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  0,  0,  0,  0,  0,  0,  0,  0,  0}, /* NEED2 */
+    { 0,  0,  0,  0,  0,  2,  2,  2,  2,  2,  2,  2,  0,  0,  0,  0,  0,  0,  0,  0,  0}, /* E0 */
+    { 0,  2,  2,  2,  2,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0}, /* ED */
+    { 0,  2,  2,  2,  2,  2,  2,  2,  7,  2,  2,  8,  0,  0,  0,  0,  0,  0,  0,  0,  0}, /* EF */
+    { 0,  1,  1,  0,  0,  0,  0,  1,  1,  1,  1,  1,  0,  0,  0,  0,  0,  0,  0,  0,  0}, /* EFB7 */
+    { 0,  1,  1,  1,  1,  1,  1,  1,  1,  1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0}, /* EFBF */
+    { 0,  0,  0,  3, 12,  3, 12,  3,  3,  3,  3, 12,  0,  0,  0,  0,  0,  0,  0,  0,  0}, /* F0 */
+    { 0,  3, 12,  3, 12,  3, 12,  3,  3,  3,  3, 12,  0,  0,  0,  0,  0,  0,  0,  0,  0}, /* F1 */
+    { 0,  3, 12,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0}, /* F4 */
+    { 0,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2, 13,  0,  0,  0,  0,  0,  0,  0,  0,  0}, /* PLANE_END3 */
+    { 0,  1,  1,  1,  1,  1,  1,  1,  1,  1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0}, /* PLANE_END4 */
+};
+// clang-format on
+
+#endif /* end MUTF8_DECODE_TABLE_H */
@@ -0,0 +1,295 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "mutf8.h"
+#include "mutf8_grapheme_table.h"
+#include "mutf8_stats.h"
+
+/**
+ * @private
+ * @struct m_utf8_grapheme_state
+ * @brief segmentation state of UAX #29 rules which look back more than one character
+ */
+struct m_utf8_grapheme_state
+{
+    uint8_t prev;       /* property of the previous character */
+    bool pictographic;  /* Extended_Pictographic Extend* was read( GB11) */
+    bool emoji_zwj;     /* Extended_Pictographic Extend* ZWJ was read( GB11) */
+    bool ri_odd;        /* odd count of Regional_Indicator was read( GB12, GB13) */
+};
+
+/**
+ * @private
+ * @fn static inline uint8_t m_utf8_grapheme_property(uint32_t unicode)
+ * @brief grapheme cluster break property of unicode
+ */
+static inline uint8_t m_utf8_grapheme_property(uint32_t unicode)
+{
+    uint8_t property = m_utf8_grapheme_stage2[(uint32_t)m_utf8_grapheme_stage1[unicode >> M_UTF8_GB_SHIFT]
+                                                  << M_UTF8_GB_SHIFT |
+                                              (unicode & M_UTF8_GB_MASK)];
+
+    if (property == M_UTF8_GB_LV && (unicode - 0xAC00) % 28 != 0)
+    {
+        property = M_UTF8_GB_LVT;
+    }
+    return property;
+}
+
+/**
+ * @private
+ * @fn static inline uint8_t m_utf8_grapheme_decode(const uint8_t *str, size_t str_bytesize, uint8_t *property)
+ * @brief byte size and grapheme cluster break property of the first character
+ * @return character byte size( 1 or more)
+ * @note
+ *   an invalid character is M_UTF8_GB_CONTROL, and is a cluster by itself.
+ */
+static inline uint8_t m_utf8_grapheme_decode(const uint8_t *str, size_t str_bytesize, uint8_t *property)
+{
+    uint32_t unicode;
+    uint8_t ch_byte_size = m_utf8_ch_decode((const m_char8_t *)str, str_bytesize, &unicode);
+
+    if (ch_byte_size == 0)
+    {
+        *property = M_UTF8_GB_CONTROL;
+        ch_byte_size = m_utf8_ch_byte_size((const m_char8_t *)str);
+        if (ch_byte_size == 0)
+            ch_byte_size = 1;
+        if (ch_byte_size > str_bytesize)
+            ch_byte_size = (uint8_t)str_bytesize;
+        return ch_byte_size;
+    }
+    *property = m_utf8_grapheme_property(unicode);
+    return ch_byte_size;
+}
+
+/**
+ * @private
+ * @fn static inline bool m_utf8_grapheme_break(struct m_utf8_grapheme_state *state, uint8_t property)
+ * @brief UAX #29 extended grapheme cluster rules, and update state
+ * @return true when a cluster boundary is before the character of property
+ */
+static inline bool m_utf8_grapheme_break(struct m_utf8_grapheme_state *state, uint8_t property)
+{
+    uint8_t prev = state->prev;
+    bool is_break;
+
+    if (prev == M_UTF8_GB_CR && property == M_UTF8_GB_LF)
+        is_break = false; /* GB3 */
+    else if (prev == M_UTF8_GB_CONTROL || prev == M_UTF8_GB_CR || prev == M_UTF8_GB_LF)
+        is_break = true; /* GB4 */
+    else if (property == M_UTF8_GB_CONTROL || property == M_UTF8_GB_CR || property == M_UTF8_GB_LF)
+        is_break = true; /* GB5 */
+    else if (prev == M_UTF8_GB_L && (property == M_UTF8_GB_L || property == M_UTF8_GB_V ||
+                                     property == M_UTF8_GB_LV || property == M_UTF8_GB_LVT))
+        is_break = false; /* GB6 */
+    else if ((prev == M_UTF8_GB_LV || prev == M_UTF8_GB_V) && (property == M_UTF8_GB_V || property == M_UTF8_GB_T))
+        is_break = false; /* GB7 */
+    else if ((prev == M_UTF8_GB_LVT || prev == M_UTF8_GB_T) && property == M_UTF8_GB_T)
+        is_break = false; /* GB8 */
+    else if (property == M_UTF8_GB_EXTEND || property == M_UTF8_GB_ZWJ || property == M_UTF8_GB_SPACINGMARK)
+        is_break = false; /* GB9, GB9a */
+    else if (prev == M_UTF8_GB_PREPEND)
+        is_break = false; /* GB9b */
+    else if (prev == M_UTF8_GB_ZWJ && property == M_UTF8_GB_EXTENDED_PICTOGRAPHIC && state->emoji_zwj)
+        is_break = false; /* GB11 */
+    else if (prev == M_UTF8_GB_REGIONAL_INDICATOR && property == M_UTF8_GB_REGIONAL_INDICATOR && state->ri_odd)
+        is_break = false; /* GB12, GB13 */
+    else
+        is_break = true; /* GB999 */
+
+    state->emoji_zwj = property == M_UTF8_GB_ZWJ && state->pictographic;
+    if (property == M_UTF8_GB_EXTENDED_PICTOGRAPHIC)
+        state->pictographic = true;
+    else if (property != M_UTF8_GB_EXTEND)
+        state->pictographic = false;
+    state->ri_odd = property == M_UTF8_GB_REGIONAL_INDICATOR && !state->ri_odd;
+    state->prev = property;
+
+    return is_break;
+}
+
+/**
+ * @private
+ * @fn static inline void m_utf8_grapheme_init(struct m_utf8_grapheme_state *state)
+ * @brief start of text state, the first character is not joined to anything( GB1)
+ */
+static inline void m_utf8_grapheme_init(struct m_utf8_grapheme_state *state)
+{
+    state->prev = M_UTF8_GB_CONTROL;
+    state->pictographic = false;
+    state->emoji_zwj = false;
+    state->ri_odd = false;
+}
+
+/**
+ * @private
+ * @fn static inline uint8_t m_utf8_grapheme_ascii_property(uint8_t byte)
+ * @brief grapheme cluster break property of ASCII
+ */
+static inline uint8_t m_utf8_grapheme_ascii_property(uint8_t byte)
+{
+    if (byte == '\r')
+        return M_UTF8_GB_CR;
+    if (byte == '\n')
+        return M_UTF8_GB_LF;
+    if (byte < 0x20 || byte == 0x7F)
+        return M_UTF8_GB_CONTROL;
+    return M_UTF8_GB_OTHER;
+}
+
+/**
+ * @public
+ * @fn int64_t m_utf8_grapheme_next(const m_char8_t *str, size_t str_bytesize, size_t offset)
+ * @brief byte offset of the next grapheme cluster boundary
+ * @param[in] str - utf8 buffer( null-terminated string is not needed)
+ * @param[in] str_bytesize - utf8 buffer byte size
+ * @param[in] offset - byte offset of a grapheme cluster boundary
+ * @return byte offset of the end of the grapheme cluster at offset, str_bytesize when offset is at the end.
+ * @note
+ *   do not read after str_bytesize.
+ *   user-perceived character of UAX #29 extended grapheme cluster,
+ *   combining marks, emoji ZWJ sequences, flags and Hangul jamo are one cluster.
+ *   an invalid character is one cluster.
+ */
+int64_t m_utf8_grapheme_next(const m_char8_t *str, size_t str_bytesize, size_t offset)
+{
+    const uint8_t *ptr = (const uint8_t *)str;
+    struct m_utf8_grapheme_state state;
+    uint8_t property;
+
+    if (offset >= str_bytesize)
+    {
+        return (int64_t)str_bytesize;
+    }
+
+    m_utf8_grapheme_init(&state);
+    if (ptr[offset] < 0x80)
+    {
+        property = m_utf8_grapheme_ascii_property(ptr[offset]);
+        offset++;
+        /* ASCII followed by ASCII is always a boundary except CR LF. */
+        if (offset >= str_bytesize || (ptr[offset] < 0x80 && !(property == M_UTF8_GB_CR && ptr[offset] == '\n')))
+        {
+            return (int64_t)offset;
+        }
+    }
+    else
+    {
+        offset += m_utf8_grapheme_decode(ptr + offset, str_bytesize - offset, &property);
+    }
+    m_utf8_grapheme_break(&state, property);
+
+    while (offset < str_bytesize)
+    {
+        uint8_t ch_byte_size = m_utf8_grapheme_decode(ptr + offset, str_bytesize - offset, &property);
+        if (m_utf8_grapheme_break(&state, property))
+        {
+            break;
+        }
+        offset += ch_byte_size;
+    }
+
+    return (int64_t)offset;
+}
+
+/**
+ * @public
+ * @fn int64_t m_utf8_mem_grapheme_count(const m_char8_t *str, size_t str_bytesize)
+ * @brief utf8 buffer grapheme cluster count
+ * @param[in] str - utf8 buffer( null-terminated string is not needed)
+ * @param[in] str_bytesize - utf8 buffer byte size
+ * @return count size
+ * @note
+ *   do not read after str_bytesize.
+ *   '\0' is a cluster, same as m_utf8_grapheme_next.
+ *   ASCII text is counted by 16 bytes block.
+ */
+int64_t m_utf8_mem_grapheme_count(const m_char8_t *str, size_t str_bytesize)
+{
+    const uint8_t *ptr = (const uint8_t *)str;
+    struct m_utf8_grapheme_state state;
+    int64_t count = 0;
+    size_t str_size = 0;
+
+    M_UTF8_STATS_API(M_UTF8_STATS_GRAPHEME, str_bytesize);
+    m_utf8_grapheme_init(&state);
+    while (str_size < str_bytesize)
+    {
+#if defined(__SSE2__)
+        /* after ASCII, every ASCII starts a cluster except LF after CR. */
+        if (state.prev <= M_UTF8_GB_CONTROL)
+        {
+            const __m128i cr = _mm_set1_epi8('\r');
+            const __m128i lf = _mm_set1_epi8('\n');
+            while (str_size + 16 <= str_bytesize)
+            {
+                __m128i block = _mm_loadu_si128((const __m128i *)(ptr + str_size));
+                if (_mm_movemask_epi8(block) != 0)
+                {
+                    M_UTF8_STATS_ADD(slow_blocks, 1);
+                    break;
+                }
+                M_UTF8_STATS_ADD(fast_blocks, 1);
+                M_UTF8_STATS_ADD(char_count[0], 16);
+                unsigned int cr_mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(block, cr));
+                unsigned int lf_mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(block, lf));
+                cr_mask = cr_mask << 1 | (state.prev == M_UTF8_GB_CR ? 1U : 0U);
+                count += 16 - __builtin_popcount(cr_mask & lf_mask);
+                str_size += 16;
+                state.prev = m_utf8_grapheme_ascii_property(ptr[str_size - 1]);
+                state.pictographic = false;
+                state.ri_odd = false;
+            }
+            if (str_size >= str_bytesize)
+                break;
+        }
+#endif
+        uint8_t property;
+        uint8_t ch_byte_size = 1;
+        if (ptr[str_size] < 0x80)
+        {
+            property = m_utf8_grapheme_ascii_property(ptr[str_size]);
+        }
+        else
+        {
+            ch_byte_size = m_utf8_grapheme_decode(ptr + str_size, str_bytesize - str_size, &property);
+        }
+        if (m_utf8_grapheme_break(&state, property))
+        {
+            count++;
+        }
+        M_UTF8_STATS_CHAR(ch_byte_size);
+        str_size += ch_byte_size;
+    }
+
+    return count;
+}
+
+/**
+ * @public
+ * @fn int64_t m_utf8_str_grapheme_count(const m_char8_t *str, size_t max_str_bytesize)
+ * @brief utf8 string grapheme cluster count
+ * @param[in] str - utf8 string
+ * @param[in] max_str_bytesize - utf8 string byte size( add null-terminated string size)
+ * @return count size
+ * @note
+ *   add null-terminated string size.
+ *   the string is cut at max_str_bytesize - 1 when null-terminated string is not found.
+ */
+int64_t m_utf8_str_grapheme_count(const m_char8_t *str, size_t max_str_bytesize)
+{
+    const m_char8_t *end = memchr(str, '\0', max_str_bytesize);
+    size_t str_bytesize = end ? (size_t)(end - str) : max_str_bytesize;
+
+    if (end == NULL && max_str_bytesize > 0)
+    {
+        str_bytesize--;
+    }
+
+    return m_utf8_mem_grapheme_count(str, str_bytesize);
+}
@@ -0,0 +1,491 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* the index walk decodes every character, inline the primitives. */
+#define M_UTF8_INLINE
+#include "mutf8.h"
+
+#ifndef M_UTF8_INDEX_INTERVAL
+#define M_UTF8_INDEX_INTERVAL 128
+#endif
+
+/**
+ * @private
+ * @struct m_utf8_index_point
+ * @brief checkpoint of m_utf8_index_t, a character boundary
+ */
+struct m_utf8_index_point
+{
+    int64_t byte_offset; /* byte offset of the character */
+    int64_t char_index;  /* character index of the character */
+    int64_t column;      /* display column of the character, 0 when the width is not tracked */
+};
+
+/**
+ * @private
+ * @fn static inline size_t m_utf8_index_next(const m_utf8_index_t *index, const uint8_t *str, size_t str_bytesize, size_t offset, int64_t *column)
+ * @brief byte size of the character at offset, and add its display width to column
+ * @note
+ *   same width as m_utf8_mem_stat, an invalid character is display width 1.
+ *   column is not changed when the width is not tracked.
+ */
+static inline size_t m_utf8_index_next(const m_utf8_index_t *index, const uint8_t *str, size_t str_bytesize,
+                                       size_t offset, int64_t *column)
+{
+    if (str[offset] < 0x80)
+    {
+        if (index->profile != NULL)
+            *column += 1;
+        return 1;
+    }
+    if (index->profile != NULL)
+    {
+        uint32_t unicode;
+        if (m_utf8_ch_decode((const m_char8_t *)str + offset, str_bytesize - offset, &unicode) == 0)
+            *column += 1;
+        else
+            *column += (int64_t)m_utf8_unicode_width(unicode, index->profile);
+    }
+    return m_utf8_ch_byte_size((const m_char8_t *)str + offset);
+}
+
+/**
+ * @private
+ * @fn static size_t m_utf8_index_find_byte(const m_utf8_index_t *index, int64_t byte_offset)
+ * @brief the last checkpoint at or before byte_offset
+ */
+static size_t m_utf8_index_find_byte(const m_utf8_index_t *index, int64_t byte_offset)
+{
+    size_t low = 0;
+    size_t high = index->point_count;
+
+    while (high - low > 1)
+    {
+        size_t mid = low + (high - low) / 2;
+        if (index->points[mid].byte_offset <= byte_offset)
+            low = mid;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+/**
+ * @private
+ * @fn static size_t m_utf8_index_find_char(const m_utf8_index_t *index, int64_t char_index)
+ * @brief the last checkpoint at or before char_index
+ */
+static size_t m_utf8_index_find_char(const m_utf8_index_t *index, int64_t char_index)
+{
+    size_t low = 0;
+    size_t high = index->point_count;
+
+    while (high - low > 1)
+    {
+        size_t mid = low + (high - low) / 2;
+        if (index->points[mid].char_index <= char_index)
+            low = mid;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+/**
+ * @private
+ * @fn static size_t m_utf8_index_find_column(const m_utf8_index_t *index, int64_t column)
+ * @brief the last checkpoint at or before column
+ */
+static size_t m_utf8_index_find_column(const m_utf8_index_t *index, int64_t column)
+{
+    size_t low = 0;
+    size_t high = index->point_count;
+
+    while (high - low > 1)
+    {
+        size_t mid = low + (high - low) / 2;
+        if (index->points[mid].column <= column)
+            low = mid;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+/**
+ * @public
+ * @fn bool m_utf8_index_build(m_utf8_index_t *index, const m_char8_t *str, size_t str_bytesize, size_t interval)
+ * @brief build character index of utf8 buffer
+ * @param[out] index - character index
+ * @param[in] str - utf8 buffer( null-terminated string is not needed)
+ * @param[in] str_bytesize - utf8 buffer byte size
+ * @param[in] interval - characters between checkpoints, 0 is M_UTF8_INDEX_INTERVAL
+ * @return false when allocation failed
+ * @note
+ *   the index does not keep str, pass the same buffer to the other m_utf8_index_ functions.
+ *   characters are counted same as m_utf8_mem_display_count, an invalid character is a character.
+ *   release with m_utf8_index_free.
+ */
+bool m_utf8_index_build(m_utf8_index_t *index, const m_char8_t *str, size_t str_bytesize, size_t interval)
+{
+    index->points = malloc(sizeof(struct m_utf8_index_point) * 16);
+    index->point_count = 1;
+    index->point_capacity = 16;
+    index->interval = interval ? interval : M_UTF8_INDEX_INTERVAL;
+    index->byte_size = 0;
+    index->char_count = 0;
+    index->display_width = 0;
+    index->profile = NULL;
+    if (index->points == NULL)
+    {
+        m_utf8_index_free(index);
+        return false;
+    }
+    index->points[0].byte_offset = 0;
+    index->points[0].char_index = 0;
+    index->points[0].column = 0;
+
+    /* the index of an empty buffer, and insert the whole buffer. */
+    if (m_utf8_index_update(index, str, str_bytesize, 0, 0, str_bytesize) == false)
+    {
+        m_utf8_index_free(index);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @public
+ * @fn bool m_utf8_index_build_width(m_utf8_index_t *index, const m_char8_t *str, size_t str_bytesize, size_t interval, const m_utf8_width_profile_t *profile)
+ * @brief build character and display column index of utf8 buffer
+ * @param[out] index - character index
+ * @param[in] str - utf8 buffer( null-terminated string is not needed), a line for cursor positioning
+ * @param[in] str_bytesize - utf8 buffer byte size
+ * @param[in] interval - characters between checkpoints, 0 is M_UTF8_INDEX_INTERVAL
+ * @param[in] profile - width profile, NULL is same as m_utf8_display_width
+ * @return false when allocation failed
+ * @note
+ *   same as m_utf8_index_build, and the checkpoints also have the sum of display width.
+ *   see m_utf8_index_column and m_utf8_index_column_offset.
+ */
+bool m_utf8_index_build_width(m_utf8_index_t *index, const m_char8_t *str, size_t str_bytesize, size_t interval,
+                              const m_utf8_width_profile_t *profile)
+{
+    if (m_utf8_index_build(index, str, 0, interval) == false)
+    {
+        return false;
+    }
+    index->profile = profile ? profile : m_utf8_width_profile(true, true);
+    if (m_utf8_index_update(index, str, str_bytesize, 0, 0, str_bytesize) == false)
+    {
+        m_utf8_index_free(index);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @public
+ * @fn void m_utf8_index_free(m_utf8_index_t *index)
+ * @brief release the checkpoints of m_utf8_index_build
+ * @param[in,out] index - character index
+ */
+void m_utf8_index_free(m_utf8_index_t *index)
+{
+    free(index->points);
+    index->points = NULL;
+    index->point_count = 0;
+    index->point_capacity = 0;
+    index->byte_size = 0;
+    index->char_count = 0;
+    index->display_width = 0;
+}
+
+/**
+ * @public
+ * @fn bool m_utf8_index_update(m_utf8_index_t *index, const m_char8_t *str, size_t str_bytesize, size_t edit_offset, size_t removed_bytesize, size_t inserted_bytesize)
+ * @brief update character index after an edit of one region
+ * @param[in,out] index - character index of the buffer before the edit
+ * @param[in] str - utf8 buffer after the edit
+ * @param[in] str_bytesize - utf8 buffer byte size after the edit
+ * @param[in] edit_offset - byte offset of the edit
+ * @param[in] removed_bytesize - byte size removed at edit_offset
+ * @param[in] inserted_bytesize - byte size inserted at edit_offset
+ * @return false when the edit does not match the index, or allocation failed.
+ *         the index is not changed, build it again.
+ * @note
+ *   rescan from the checkpoint before the edit until the walk meets a checkpoint after the edit,
+ *   and shift the following checkpoints. so the cost is the edit size, not the buffer size.
+ *   a lookup scans less than 2 * interval characters.
+ */
+bool m_utf8_index_update(m_utf8_index_t *index, const m_char8_t *str, size_t str_bytesize, size_t edit_offset,
+                         size_t removed_bytesize, size_t inserted_bytesize)
+{
+    const uint8_t *ptr = (const uint8_t *)str;
+    int64_t interval = (int64_t)index->interval;
+
+    if (index->points == NULL || edit_offset + removed_bytesize > (size_t)index->byte_size ||
+        (size_t)index->byte_size - removed_bytesize + inserted_bytesize != str_bytesize)
+    {
+        return false;
+    }
+
+    int64_t delta_bytes = (int64_t)inserted_bytesize - (int64_t)removed_bytesize;
+    size_t start = m_utf8_index_find_byte(index, (int64_t)edit_offset);
+    size_t next = start + 1;
+    while (next < index->point_count && index->points[next].byte_offset < (int64_t)(edit_offset + removed_bytesize))
+    {
+        next++;
+    }
+    /* a checkpoint shifted onto the start one is dropped, not kept twice. */
+    while (next < index->point_count &&
+           index->points[next].byte_offset + delta_bytes <= index->points[start].byte_offset)
+    {
+        next++;
+    }
+
+    /* walk the edited region, new checkpoints are every interval characters. */
+    struct m_utf8_index_point *added = NULL;
+    size_t added_count = 0;
+    size_t added_capacity = 0;
+    size_t offset = (size_t)index->points[start].byte_offset;
+    int64_t char_index = index->points[start].char_index;
+    int64_t column = index->points[start].column;
+    int64_t last_char_index = char_index;
+    bool synced = false;
+
+    while (offset < str_bytesize)
+    {
+        while (next < index->point_count && index->points[next].byte_offset + delta_bytes < (int64_t)offset)
+        {
+            next++;
+        }
+        if (next < index->point_count && index->points[next].byte_offset + delta_bytes == (int64_t)offset)
+        {
+            synced = true;
+            break;
+        }
+        if (char_index - last_char_index == interval)
+        {
+            if (added_count == added_capacity)
+            {
+                size_t capacity = added_capacity ? added_capacity * 2 : 16;
+                struct m_utf8_index_point *points = realloc(added, sizeof(struct m_utf8_index_point) * capacity);
+                if (points == NULL)
+                {
+                    free(added);
+                    return false;
+                }
+                added = points;
+                added_capacity = capacity;
+            }
+            added[added_count].byte_offset = (int64_t)offset;
+            added[added_count].char_index = char_index;
+            added[added_count].column = column;
+            added_count++;
+            last_char_index = char_index;
+        }
+        offset += m_utf8_index_next(index, ptr, str_bytesize, offset, &column);
+        char_index++;
+    }
+
+    int64_t delta_chars = 0;
+    int64_t delta_columns = 0;
+    if (synced)
+    {
+        delta_chars = char_index - index->points[next].char_index;
+        delta_columns = column - index->points[next].column;
+        /* merge a short last gap into the previous one. */
+        if (added_count > 0 && char_index - added[added_count - 1].char_index < interval / 2)
+        {
+            added_count--;
+        }
+    }
+    else
+    {
+        next = index->point_count;
+    }
+
+    /* checkpoints are [0, start], added, and [next, point_count) shifted. */
+    size_t tail_count = index->point_count - next;
+    size_t point_count = start + 1 + added_count + tail_count;
+    if (point_count > index->point_capacity)
+    {
+        size_t capacity = index->point_capacity * 2 > point_count ? index->point_capacity * 2 : point_count;
+        struct m_utf8_index_point *points = realloc(index->points, sizeof(struct m_utf8_index_point) * capacity);
+        if (points == NULL)
+        {
+            free(added);
+            return false;
+        }
+        index->points = points;
+        index->point_capacity = capacity;
+    }
+    memmove(index->points + start + 1 + added_count, index->points + next, sizeof(struct m_utf8_index_point) * tail_count);
+    if (added_count > 0)
+    {
+        memcpy(index->points + start + 1, added, sizeof(struct m_utf8_index_point) * added_count);
+    }
+    for (size_t i = start + 1 + added_count; i < point_count; i++)
+    {
+        index->points[i].byte_offset += delta_bytes;
+        index->points[i].char_index += delta_chars;
+        index->points[i].column += delta_columns;
+    }
+    index->point_count = point_count;
+    index->byte_size = (int64_t)str_bytesize;
+    index->char_count = synced ? index->char_count + delta_chars : char_index;
+    index->display_width = synced ? index->display_width + delta_columns : column;
+
+    free(added);
+    return true;
+}
+
+/**
+ * @public
+ * @fn int64_t m_utf8_index_byte_offset(const m_utf8_index_t *index, const m_char8_t *str, int64_t char_index)
+ * @brief byte offset of the character at char_index
+ * @param[in] index - character index of str
+ * @param[in] str - utf8 buffer( null-terminated string is not needed)
+ * @param[in] char_index - character index
+ * @return byte offset, byte_size when char_index is char_count, -1 when char_index is out of range.
+ * @note
+ *   a substring of characters [first, last) is bytes [m_utf8_index_byte_offset(first), m_utf8_index_byte_offset(last)).
+ */
+int64_t m_utf8_index_byte_offset(const m_utf8_index_t *index, const m_char8_t *str, int64_t char_index)
+{
+    const uint8_t *ptr = (const uint8_t *)str;
+
+    if (char_index < 0 || char_index > index->char_count)
+    {
+        return -1;
+    }
+    if (char_index == index->char_count)
+    {
+        return index->byte_size;
+    }
+
+    const struct m_utf8_index_point *point = &index->points[m_utf8_index_find_char(index, char_index)];
+    size_t offset = (size_t)point->byte_offset;
+    for (int64_t i = point->char_index; i < char_index; i++)
+    {
+        offset += m_utf8_ch_byte_size((const m_char8_t *)ptr + offset);
+    }
+    return (int64_t)offset;
+}
+
+/**
+ * @public
+ * @fn int64_t m_utf8_index_char_index(const m_utf8_index_t *index, const m_char8_t *str, int64_t byte_offset)
+ * @brief character index of the character which has the byte at byte_offset
+ * @param[in] index - character index of str
+ * @param[in] str - utf8 buffer( null-terminated string is not needed)
+ * @param[in] byte_offset - byte offset
+ * @return character index, char_count when byte_offset is byte_size, -1 when byte_offset is out of range.
+ */
+int64_t m_utf8_index_char_index(const m_utf8_index_t *index, const m_char8_t *str, int64_t byte_offset)
+{
+    const uint8_t *ptr = (const uint8_t *)str;
+
+    if (byte_offset < 0 || byte_offset > index->byte_size)
+    {
+        return -1;
+    }
+    if (byte_offset == index->byte_size)
+    {
+        return index->char_count;
+    }
+
+    const struct m_utf8_index_point *point = &index->points[m_utf8_index_find_byte(index, byte_offset)];
+    size_t offset = (size_t)point->byte_offset;
+    int64_t char_index = point->char_index;
+    for (;;)
+    {
+        size_t next = offset + m_utf8_ch_byte_size((const m_char8_t *)ptr + offset);
+        if ((int64_t)next > byte_offset)
+            break;
+        offset = next;
+        char_index++;
+    }
+    return char_index;
+}
+
+/**
+ * @public
+ * @fn int64_t m_utf8_index_column(const m_utf8_index_t *index, const m_char8_t *str, int64_t byte_offset)
+ * @brief display column of the character which has the byte at byte_offset
+ * @param[in] index - index of str by m_utf8_index_build_width
+ * @param[in] str - utf8 buffer( null-terminated string is not needed)
+ * @param[in] byte_offset - byte offset
+ * @return display column of the start of the character, display_width when byte_offset is byte_size,
+ *         -1 when byte_offset is out of range or the width is not tracked.
+ */
+int64_t m_utf8_index_column(const m_utf8_index_t *index, const m_char8_t *str, int64_t byte_offset)
+{
+    const uint8_t *ptr = (const uint8_t *)str;
+
+    if (index->profile == NULL || byte_offset < 0 || byte_offset > index->byte_size)
+    {
+        return -1;
+    }
+    if (byte_offset == index->byte_size)
+    {
+        return index->display_width;
+    }
+
+    const struct m_utf8_index_point *point = &index->points[m_utf8_index_find_byte(index, byte_offset)];
+    size_t offset = (size_t)point->byte_offset;
+    int64_t column = point->column;
+    for (;;)
+    {
+        int64_t next_column = column;
+        size_t next = offset + m_utf8_index_next(index, ptr, (size_t)index->byte_size, offset, &next_column);
+        if ((int64_t)next > byte_offset)
+            break;
+        offset = next;
+        column = next_column;
+    }
+    return column;
+}
+
+/**
+ * @public
+ * @fn int64_t m_utf8_index_column_offset(const m_utf8_index_t *index, const m_char8_t *str, int64_t column)
+ * @brief byte offset of the character displayed at column
+ * @param[in] index - index of str by m_utf8_index_build_width
+ * @param[in] str - utf8 buffer( null-terminated string is not needed)
+ * @param[in] column - display column
+ * @return byte offset of the character, byte_size when column is display_width or more,
+ *         -1 when column is negative or the width is not tracked.
+ * @note
+ *   the 2nd column of a wide character is the wide character( hit-testing).
+ */
+int64_t m_utf8_index_column_offset(const m_utf8_index_t *index, const m_char8_t *str, int64_t column)
+{
+    const uint8_t *ptr = (const uint8_t *)str;
+
+    if (index->profile == NULL || column < 0)
+    {
+        return -1;
+    }
+    if (column >= index->display_width)
+    {
+        return index->byte_size;
+    }
+
+    const struct m_utf8_index_point *point = &index->points[m_utf8_index_find_column(index, column)];
+    size_t offset = (size_t)point->byte_offset;
+    int64_t start_column = point->column;
+    for (;;)
+    {
+        int64_t end_column = start_column;
+        size_t next = offset + m_utf8_index_next(index, ptr, (size_t)index->byte_size, offset, &end_column);
+        if (end_column > column)
+            break;
+        offset = next;
+        start_column = end_column;
+    }
+    return (int64_t)offset;
+}
@@ -0,0 +1,387 @@
+#ifndef MUTF8_INLINE_H
+#define MUTF8_INLINE_H
+
+/*
+ * tables and character primitives of mutf8.
+ *
+ * mutf8.c defines the primitives here as extern functions.
+ * define M_UTF8_INLINE before including mutf8.h, and they are static inline( M_UTF8_INLINE_API)
+ * in every translation unit instead, so the compiler can inline m_utf8_ch_byte_size and others without LTO.
+ * the tables are copied into each translation unit which uses them.
+ * the other functions are still in mutf8.c, link it.
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mutf8.h"
+#include "mutf8_decode_table.h"
+#include "mutf8_stats.h"
+#include "mutf8_width_table.h"
+
+/**
+ * @public
+ * @fn uint8_t m_utf8_ch_byte_size(const m_char8_t *character)
+ * @brief utf8 character byte size
+ * @param[in] character - utf8 character
+ * @return utf8 character byte size
+ * @note
+ *   do not use null-terminated string.
+ *   that *legal* UTF-8 values can't have 5-bytes or 6-bytes.
+ */
+M_UTF8_INLINE_API uint8_t m_utf8_ch_byte_size(const m_char8_t *character)
+{
+    return m_utf8_jump_table[(uint8_t)(*character)];
+}
+
+/**
+ * @public
+ * @fn bool m_utf8_ch_validate(const m_char8_t *character, size_t character_bytesize)
+ * @brief utf8 character validate
+ * @param[in] character - utf8 character
+ * @param[in] character_bytesize - utf8 character byte size
+ * @return true valid, false invalid
+ * @author Atsushi Enomoto  <atsushi@ximian.com>
+ * @sa https://github.com/corngood/mono/blob/master/eglib/src/gutf8.c
+ * @note
+ *   do not use null-terminated string.
+ *   base function is "static gboolean utf8_validate (const unsigned char *inptr, size_t len)".
+ */
+M_UTF8_INLINE_API bool m_utf8_ch_validate(const m_char8_t *character, size_t character_size)
+{
+    uint8_t *inptr = (uint8_t *)character;
+    const uint8_t *ptr = inptr + character_size;
+    uint8_t c;
+
+    /* Everything falls through when TRUE... */
+    switch (character_size)
+    {
+    default:
+        return false;
+    case 4:
+        if ((c = (*--ptr)) < 0x80 || c > 0xBF)
+            return false;
+
+        if ((c == 0xBF || c == 0xBE) && ptr[-1] == 0xBF)
+        {
+            if (ptr[-2] == 0x8F || ptr[-2] == 0x9F ||
+                ptr[-2] == 0xAF || ptr[-2] == 0xBF)
+                return false;
+        }
+        /* fall through */
+    case 3:
+        if ((c = (*--ptr)) < 0x80 || c > 0xBF)
+            return false;
+        /* fall through */
+    case 2:
+        if ((c = (*--ptr)) < 0x80 || c > 0xBF)
+            return false;
+
+        /* no fall-through in this inner switch */
+        switch (*inptr)
+        {
+        case 0xE0:
+            if (c < 0xA0)
+                return false;
+            break;
+        case 0xED:
+            if (c > 0x9F)
+                return false;
+            break;
+        case 0xEF:
+            if (c == 0xB7 && (ptr[1] > 0x8F && ptr[1] < 0xB0))
+                return false;
+            if (c == 0xBF && (ptr[1] == 0xBE || ptr[1] == 0xBF))
+                return false;
+            break;
+        case 0xF0:
+            if (c < 0x90)
+                return false;
+            break;
+        case 0xF4:
+            if (c > 0x8F)
+                return false;
+            break;
+        default:
+            if (c < 0x80)
+                return false;
+            break;
+        }
+        /* fall through */
+    case 1:
+        if (*inptr >= 0x80 && *inptr < 0xC2)
+            return false;
+    }
+
+    if (*inptr > 0xF4)
+        return false;
+
+    return true;
+}
+
+/**
+ * @private
+ * @fn static inline uint8_t m_utf8_dfa_decode(const uint8_t *character, size_t max_bytesize, uint32_t *unicode)
+ * @brief utf8 character convert to unicode with the DFA
+ * @param[in] character - utf8 character
+ * @param[in] max_bytesize - readable byte size( 1 or more)
+ * @param[out] unicode - unicode, set only when valid
+ * @return utf8 character byte size, 0 when invalid.
+ * @note
+ *   same result as m_utf8_ch_validate.
+ *   read only until the DFA rejects.
+ */
+static inline uint8_t m_utf8_dfa_decode(const uint8_t *character, size_t max_bytesize, uint32_t *unicode)
+{
+    uint8_t byte_class = m_utf8_dfa_class_table[character[0]];
+    uint8_t state = m_utf8_dfa_transition[M_UTF8_DFA_ACCEPT][byte_class];
+    uint32_t c = character[0] & m_utf8_dfa_lead_mask[byte_class];
+    size_t i = 1;
+
+    while (state > M_UTF8_DFA_ACCEPT && i < max_bytesize)
+    {
+        uint8_t byte = character[i++];
+        c = (c << 6) | (byte & 0x3F);
+        state = m_utf8_dfa_transition[state][m_utf8_dfa_class_table[byte]];
+    }
+
+    if (state != M_UTF8_DFA_ACCEPT)
+        return 0;
+    *unicode = c;
+    return (uint8_t)i;
+}
+
+/**
+ * @public
+ * @fn uint32_t m_utf8_to_unicode(const m_char8_t *character)
+ * @brief utf8 character convert to unicode
+ * @param[in] character  - utf8 character
+ * @return unicode, and convert to 0 when failed.
+ * @author FUNABARA Masao
+ * @note
+ *   use m_utf8_ch_decode to tell U+0000 from an invalid character.
+ */
+M_UTF8_INLINE_API uint32_t m_utf8_to_unicode(const m_char8_t *character)
+{
+    uint32_t unicode = 0;
+
+    if (m_utf8_dfa_decode((const uint8_t *)character, m_utf8_ch_byte_size(character), &unicode) == 0)
+    {
+        return 0;
+    }
+    return unicode;
+}
+
+/**
+ * @public
+ * @fn uint8_t m_utf8_ch_decode(const m_char8_t *character, size_t max_bytesize, uint32_t *unicode)
+ * @brief utf8 character convert to unicode
+ * @param[in] character - utf8 character
+ * @param[in] max_bytesize - readable byte size
+ * @param[out] unicode - unicode, set only when valid
+ * @return utf8 character byte size, 0 when invalid or truncated by max_bytesize.
+ * @note
+ *   do not read after max_bytesize.
+ */
+M_UTF8_INLINE_API uint8_t m_utf8_ch_decode(const m_char8_t *character, size_t max_bytesize, uint32_t *unicode)
+{
+    if (max_bytesize == 0)
+        return 0;
+    return m_utf8_dfa_decode((const uint8_t *)character, max_bytesize, unicode);
+}
+
+/**
+ * @public
+ * @fn uint8_t m_utf8_ch_next(const m_char8_t *character, size_t max_bytesize, uint32_t *unicode, bool *valid)
+ * @brief decode one character and step to the next one
+ * @param[in] character - utf8 character
+ * @param[in] max_bytesize - readable byte size
+ * @param[out] unicode - unicode, M_UTF8_REPLACEMENT_CHARACTER when invalid
+ * @param[out] valid - true valid, false invalid( NULL is ok)
+ * @return byte size to the next character, 0 only when max_bytesize is 0.
+ * @note
+ *   an invalid character is the lead byte and at most 3 continuation bytes after it,
+ *   so the step never swallows the next lead byte and m_utf8_ch_prev can step back exactly.
+ *   same step as mutf8::utf8_view of mutf8.hpp.
+ */
+M_UTF8_INLINE_API uint8_t m_utf8_ch_next(const m_char8_t *character, size_t max_bytesize, uint32_t *unicode,
+                                         bool *valid)
+{
+    const uint8_t *str = (const uint8_t *)character;
+    uint8_t size;
+
+    if (max_bytesize == 0)
+        return 0;
+    if (str[0] < 0x80)
+    {
+        *unicode = str[0];
+        if (valid != NULL)
+            *valid = true;
+        return 1;
+    }
+
+    size = m_utf8_jump_table[str[0]];
+    if (size > max_bytesize)
+        size = (uint8_t)max_bytesize;
+    if (m_utf8_dfa_decode(str, size, unicode) == size)
+    {
+        if (valid != NULL)
+            *valid = true;
+        return size;
+    }
+
+    uint8_t limit = size < 4 ? size : 4;
+    uint8_t i = 1;
+    while (i < limit && (str[i] & 0xC0) == 0x80)
+        i++;
+    *unicode = M_UTF8_REPLACEMENT_CHARACTER;
+    if (valid != NULL)
+        *valid = false;
+    return i;
+}
+
+/**
+ * @public
+ * @fn size_t m_utf8_ch_prev(const m_char8_t *str, size_t offset)
+ * @brief byte offset of the character before offset
+ * @param[in] str - utf8 string
+ * @param[in] offset - byte offset of a character( stepped by m_utf8_ch_next)
+ * @return byte offset of the previous character, 0 when offset is 0.
+ * @note
+ *   step back at most 4 bytes, do not scan from the start.
+ */
+M_UTF8_INLINE_API size_t m_utf8_ch_prev(const m_char8_t *str, size_t offset)
+{
+    size_t lead;
+    uint32_t unicode;
+
+    if (offset == 0)
+        return 0;
+    lead = offset - 1;
+    while (lead > 0 && offset - lead < 4 && ((uint8_t)str[lead] & 0xC0) == 0x80)
+        lead--;
+    if (lead + m_utf8_ch_next(str + lead, offset - lead, &unicode, NULL) == offset)
+        return lead;
+    return offset - 1;
+}
+
+/**
+ * @private
+ * @struct m_utf8_width_profile
+ * @brief display width of each width class in mutf8_width_table.h
+ */
+struct m_utf8_width_profile
+{
+    uint8_t width_of_class[M_UTF8_WIDTH_CLASS_SIZE];
+};
+
+/**
+ * @private
+ * @var static const m_utf8_width_profile_t m_utf8_width_profiles[2][2]
+ * @brief width profiles, index is [ambiguous_wide][emoji_wide]
+ * @note
+ *   read only, so every thread can share them.
+ */
+static const m_utf8_width_profile_t m_utf8_width_profiles[2][2] = {
+    {
+        {{[M_UTF8_WIDTH_NARROW] = 1, [M_UTF8_WIDTH_FULL] = 2, [M_UTF8_WIDTH_AMBIGUOUS] = 1, [M_UTF8_WIDTH_EMOJI] = 1}},
+        {{[M_UTF8_WIDTH_NARROW] = 1, [M_UTF8_WIDTH_FULL] = 2, [M_UTF8_WIDTH_AMBIGUOUS] = 1, [M_UTF8_WIDTH_EMOJI] = 2}},
+    },
+    {
+        {{[M_UTF8_WIDTH_NARROW] = 1, [M_UTF8_WIDTH_FULL] = 2, [M_UTF8_WIDTH_AMBIGUOUS] = 2, [M_UTF8_WIDTH_EMOJI] = 1}},
+        {{[M_UTF8_WIDTH_NARROW] = 1, [M_UTF8_WIDTH_FULL] = 2, [M_UTF8_WIDTH_AMBIGUOUS] = 2, [M_UTF8_WIDTH_EMOJI] = 2}},
+    },
+};
+
+/**
+ * @private
+ * @def M_UTF8_WIDTH_PROFILE_DEFAULT
+ * @brief width profile of m_utf8_display_width( ambiguous and emoji are wide)
+ */
+#define M_UTF8_WIDTH_PROFILE_DEFAULT (&m_utf8_width_profiles[1][1])
+
+/**
+ * @private
+ * @fn static inline uint8_t m_utf8_width_class(uint32_t unicode)
+ * @brief width class of unicode
+ * @param[in] unicode - unicode( up to 0x10FFFF)
+ * @return M_UTF8_WIDTH_NARROW, M_UTF8_WIDTH_FULL, M_UTF8_WIDTH_AMBIGUOUS or M_UTF8_WIDTH_EMOJI
+ * @note
+ *   two table loads, no search.
+ */
+static inline uint8_t m_utf8_width_class(uint32_t unicode)
+{
+    uint32_t block = m_utf8_width_stage1[unicode >> M_UTF8_WIDTH_SHIFT];
+    uint8_t width_class = m_utf8_width_stage2[(block << M_UTF8_WIDTH_SHIFT) | (unicode & M_UTF8_WIDTH_MASK)];
+
+    M_UTF8_STATS_ADD(width_lookups[width_class], 1);
+    return width_class;
+}
+
+/**
+ * @public
+ * @fn size_t m_utf8_display_width(const m_char8_t *character)
+ * @author cxxxr
+ * @sa https://github.com/cxxxr/uemacs/blob/master/utf8.c
+ * @note
+ *   base function is "int unicode_width(unicode_t c)".
+ *   the range tables are compiled into mutf8_width_table.h by tools/mkwidth.py.
+ */
+M_UTF8_INLINE_API size_t m_utf8_display_width(const m_char8_t *character)
+{
+    return m_utf8_display_width_profile(character, M_UTF8_WIDTH_PROFILE_DEFAULT);
+}
+
+/**
+ * @public
+ * @fn const m_utf8_width_profile_t *m_utf8_width_profile(bool ambiguous_wide, bool emoji_wide)
+ * @brief select width profile
+ * @param[in] ambiguous_wide - true: East Asian ambiguous characters are 2 columns, false: 1 column
+ * @param[in] emoji_wide - true: emoji are 2 columns, false: 1 column
+ * @return width profile( read only, thread safe)
+ * @note
+ *   m_utf8_display_width uses m_utf8_width_profile(true, true).
+ */
+M_UTF8_INLINE_API const m_utf8_width_profile_t *m_utf8_width_profile(bool ambiguous_wide, bool emoji_wide)
+{
+    return &m_utf8_width_profiles[ambiguous_wide ? 1 : 0][emoji_wide ? 1 : 0];
+}
+
+/**
+ * @public
+ * @fn size_t m_utf8_unicode_width(uint32_t unicode, const m_utf8_width_profile_t *profile)
+ * @brief unicode display width
+ * @param[in] unicode - unicode
+ * @param[in] profile - width profile, NULL is same as m_utf8_display_width
+ * @return display width( 1 or 2)
+ */
+M_UTF8_INLINE_API size_t m_utf8_unicode_width(uint32_t unicode, const m_utf8_width_profile_t *profile)
+{
+    if (profile == NULL)
+        profile = M_UTF8_WIDTH_PROFILE_DEFAULT;
+    if (unicode > 0x10FFFF)
+        unicode = 0;
+
+    return profile->width_of_class[m_utf8_width_class(unicode)];
+}
+
+/**
+ * @public
+ * @fn size_t m_utf8_display_width_profile(const m_char8_t *character, const m_utf8_width_profile_t *profile)
+ * @brief utf8 character display width
+ * @param[in] character - utf8 character
+ * @param[in] profile - width profile, NULL is same as m_utf8_display_width
+ * @return display width( 1 or 2), invalid character is 1.
+ */
+M_UTF8_INLINE_API size_t m_utf8_display_width_profile(const m_char8_t *character, const m_utf8_width_profile_t *profile)
+{
+    if ((uint8_t)*character < 0x80)
+        return 1;
+    if (profile == NULL)
+        profile = M_UTF8_WIDTH_PROFILE_DEFAULT;
+
+    uint32_t c = m_utf8_to_unicode(character);
+    return profile->width_of_class[m_utf8_width_class(c)];
+}
+
+#endif /* end MUTF8_INLINE_H */
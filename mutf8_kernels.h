@@ -0,0 +1,648 @@
+/*
+ * accelerated kernels of mutf8.c
+ *
+ * this file is included once for each M_UTF8_KERNEL_LEVEL( 0 scalar, 1 SSE2, 2 AVX2, 3 AVX-512),
+ * and every kernel is named by M_UTF8_KERNEL(name), see m_utf8_kernel_table in mutf8.c.
+ * the kernels are compiled for the target of M_UTF8_KERNEL_TARGET, so a level higher than
+ * the compiler options is selected at run time only when the CPU supports it.
+ * do not test the ISA macros( __AVX2__ ...) in this file, test M_UTF8_KERNEL_LEVEL.
+ */
+#if !defined(M_UTF8_KERNEL_LEVEL)
+#error "define M_UTF8_KERNEL_LEVEL before including mutf8_kernels.h"
+#endif
+
+#if M_UTF8_KERNEL_LEVEL == 0
+#define M_UTF8_KERNEL(name) name##_scalar
+#define M_UTF8_KERNEL_TARGET
+#elif M_UTF8_KERNEL_LEVEL == 1
+#define M_UTF8_KERNEL(name) name##_sse2
+#define M_UTF8_KERNEL_TARGET __attribute__((target("sse2")))
+#define M_UTF8_ASCII_BLOCK 16
+#elif M_UTF8_KERNEL_LEVEL == 2
+#define M_UTF8_KERNEL(name) name##_avx2
+#define M_UTF8_KERNEL_TARGET __attribute__((target("avx2,popcnt")))
+#define M_UTF8_ASCII_BLOCK 32
+#elif M_UTF8_KERNEL_LEVEL == 3
+#define M_UTF8_KERNEL(name) name##_avx512
+#define M_UTF8_KERNEL_TARGET __attribute__((target("avx512f,avx512bw,avx2,popcnt")))
+#define M_UTF8_ASCII_BLOCK 64
+#endif
+
+#if M_UTF8_KERNEL_LEVEL >= 1
+/**
+ * @private
+ * @fn static inline uint64_t m_utf8_ascii_mask(const uint8_t *str)
+ * @brief non-ASCII bytes of M_UTF8_ASCII_BLOCK bytes block
+ * @return bit i is set when str[i] is not ASCII
+ */
+M_UTF8_KERNEL_TARGET static inline uint64_t M_UTF8_KERNEL(m_utf8_ascii_mask)(const uint8_t *str)
+{
+#if M_UTF8_KERNEL_LEVEL >= 3
+    return _mm512_movepi8_mask(_mm512_loadu_si512((const void *)str));
+#elif M_UTF8_KERNEL_LEVEL >= 2
+    return (uint32_t)_mm256_movemask_epi8(_mm256_loadu_si256((const __m256i *)str));
+#else
+    return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)str));
+#endif
+}
+#endif
+
+#if M_UTF8_KERNEL_LEVEL == 1
+/**
+ * @private
+ * @fn static size_t m_utf8_valid_length(const uint8_t *str, size_t str_bytesize)
+ * @brief length of the valid utf8 prefix( SSE2)
+ * @note
+ *   skip 16 bytes ASCII blocks, and check other characters with the scalar loop.
+ */
+M_UTF8_KERNEL_TARGET static size_t M_UTF8_KERNEL(m_utf8_valid_length)(const uint8_t *str, size_t str_bytesize)
+{
+    size_t str_size = 0;
+
+    while (str_size + 16 <= str_bytesize)
+    {
+        __m128i input = _mm_loadu_si128((const __m128i *)(str + str_size));
+        int mask = _mm_movemask_epi8(input);
+        if (mask == 0)
+        {
+            M_UTF8_STATS_ADD(fast_blocks, 1);
+            M_UTF8_STATS_ADD(char_count[0], 16);
+            str_size += 16;
+            continue;
+        }
+        M_UTF8_STATS_ADD(slow_blocks, 1);
+        M_UTF8_STATS_ADD(char_count[0], __builtin_ctz(mask));
+        str_size += __builtin_ctz(mask);
+
+        /* validate characters until next ASCII character. */
+        while (str_size < str_bytesize && str[str_size] >= 0x80)
+        {
+            uint8_t ch_byte_size = m_utf8_jump_table[str[str_size]];
+            if (ch_byte_size > str_bytesize - str_size ||
+                m_utf8_ch_validate((const m_char8_t *)str + str_size, ch_byte_size) == false)
+            {
+                return str_size;
+            }
+            M_UTF8_STATS_CHAR(ch_byte_size);
+            str_size += ch_byte_size;
+        }
+    }
+
+    return str_size + m_utf8_valid_length_scalar(str + str_size, str_bytesize - str_size);
+}
+#endif
+
+#if M_UTF8_KERNEL_LEVEL >= 2
+/**
+ * @private
+ * @fn static __m256i m_utf8_check_block(__m256i input, __m256i prev_input)
+ * @brief find invalid bytes in 32 bytes block
+ * @param[in] input - current block
+ * @param[in] prev_input - previous block
+ * @return non-zero bytes where invalid
+ * @sa https://arxiv.org/abs/2010.03090
+ * @note
+ *   classify each byte pair with three 16 entries lookup tables,
+ *   and check the 3rd and 4th bytes of the long sequences.
+ *   also reject noncharacters same as m_utf8_ch_validate.
+ */
+M_UTF8_KERNEL_TARGET static inline __m256i M_UTF8_KERNEL(m_utf8_check_block)(__m256i input, __m256i prev_input)
+{
+    // clang-format off
+    const __m256i byte_1_high_table = _mm256_setr_epi8(
+        M_UTF8_TOO_LONG, M_UTF8_TOO_LONG, M_UTF8_TOO_LONG, M_UTF8_TOO_LONG,
+        M_UTF8_TOO_LONG, M_UTF8_TOO_LONG, M_UTF8_TOO_LONG, M_UTF8_TOO_LONG,
+        M_UTF8_TWO_CONTS, M_UTF8_TWO_CONTS, M_UTF8_TWO_CONTS, M_UTF8_TWO_CONTS,
+        M_UTF8_TOO_SHORT | M_UTF8_OVERLONG_2,
+        M_UTF8_TOO_SHORT,
+        M_UTF8_TOO_SHORT | M_UTF8_OVERLONG_3 | M_UTF8_SURROGATE,
+        M_UTF8_TOO_SHORT | M_UTF8_TOO_LARGE | M_UTF8_TOO_LARGE_1000 | M_UTF8_OVERLONG_4,
+        M_UTF8_TOO_LONG, M_UTF8_TOO_LONG, M_UTF8_TOO_LONG, M_UTF8_TOO_LONG,
+        M_UTF8_TOO_LONG, M_UTF8_TOO_LONG, M_UTF8_TOO_LONG, M_UTF8_TOO_LONG,
+        M_UTF8_TWO_CONTS, M_UTF8_TWO_CONTS, M_UTF8_TWO_CONTS, M_UTF8_TWO_CONTS,
+        M_UTF8_TOO_SHORT | M_UTF8_OVERLONG_2,
+        M_UTF8_TOO_SHORT,
+        M_UTF8_TOO_SHORT | M_UTF8_OVERLONG_3 | M_UTF8_SURROGATE,
+        M_UTF8_TOO_SHORT | M_UTF8_TOO_LARGE | M_UTF8_TOO_LARGE_1000 | M_UTF8_OVERLONG_4);
+    const __m256i byte_1_low_table = _mm256_setr_epi8(
+        M_UTF8_CARRY | M_UTF8_OVERLONG_3 | M_UTF8_OVERLONG_2 | M_UTF8_OVERLONG_4,
+        M_UTF8_CARRY | M_UTF8_OVERLONG_2,
+        M_UTF8_CARRY,
+        M_UTF8_CARRY,
+        M_UTF8_CARRY | M_UTF8_TOO_LARGE,
+        M_UTF8_CARRY | M_UTF8_TOO_LARGE | M_UTF8_TOO_LARGE_1000,
+        M_UTF8_CARRY | M_UTF8_TOO_LARGE | M_UTF8_TOO_LARGE_1000,
+        M_UTF8_CARRY | M_UTF8_TOO_LARGE | M_UTF8_TOO_LARGE_1000,
+        M_UTF8_CARRY | M_UTF8_TOO_LARGE | M_UTF8_TOO_LARGE_1000,
+        M_UTF8_CARRY | M_UTF8_TOO_LARGE | M_UTF8_TOO_LARGE_1000,
+        M_UTF8_CARRY | M_UTF8_TOO_LARGE | M_UTF8_TOO_LARGE_1000,
+        M_UTF8_CARRY | M_UTF8_TOO_LARGE | M_UTF8_TOO_LARGE_1000,
+        M_UTF8_CARRY | M_UTF8_TOO_LARGE | M_UTF8_TOO_LARGE_1000,
+        M_UTF8_CARRY | M_UTF8_TOO_LARGE | M_UTF8_TOO_LARGE_1000 | M_UTF8_SURROGATE,
+        M_UTF8_CARRY | M_UTF8_TOO_LARGE | M_UTF8_TOO_LARGE_1000,
+        M_UTF8_CARRY | M_UTF8_TOO_LARGE | M_UTF8_TOO_LARGE_1000,
+        M_UTF8_CARRY | M_UTF8_OVERLONG_3 | M_UTF8_OVERLONG_2 | M_UTF8_OVERLONG_4,
+        M_UTF8_CARRY | M_UTF8_OVERLONG_2,
+        M_UTF8_CARRY,
+        M_UTF8_CARRY,
+        M_UTF8_CARRY | M_UTF8_TOO_LARGE,
+        M_UTF8_CARRY | M_UTF8_TOO_LARGE | M_UTF8_TOO_LARGE_1000,
+        M_UTF8_CARRY | M_UTF8_TOO_LARGE | M_UTF8_TOO_LARGE_1000,
+        M_UTF8_CARRY | M_UTF8_TOO_LARGE | M_UTF8_TOO_LARGE_1000,
+        M_UTF8_CARRY | M_UTF8_TOO_LARGE | M_UTF8_TOO_LARGE_1000,
+        M_UTF8_CARRY | M_UTF8_TOO_LARGE | M_UTF8_TOO_LARGE_1000,
+        M_UTF8_CARRY | M_UTF8_TOO_LARGE | M_UTF8_TOO_LARGE_1000,
+        M_UTF8_CARRY | M_UTF8_TOO_LARGE | M_UTF8_TOO_LARGE_1000,
+        M_UTF8_CARRY | M_UTF8_TOO_LARGE | M_UTF8_TOO_LARGE_1000,
+        M_UTF8_CARRY | M_UTF8_TOO_LARGE | M_UTF8_TOO_LARGE_1000 | M_UTF8_SURROGATE,
+        M_UTF8_CARRY | M_UTF8_TOO_LARGE | M_UTF8_TOO_LARGE_1000,
+        M_UTF8_CARRY | M_UTF8_TOO_LARGE | M_UTF8_TOO_LARGE_1000);
+    const __m256i byte_2_high_table = _mm256_setr_epi8(
+        M_UTF8_TOO_SHORT, M_UTF8_TOO_SHORT, M_UTF8_TOO_SHORT, M_UTF8_TOO_SHORT,
+        M_UTF8_TOO_SHORT, M_UTF8_TOO_SHORT, M_UTF8_TOO_SHORT, M_UTF8_TOO_SHORT,
+        M_UTF8_TOO_LONG | M_UTF8_OVERLONG_2 | M_UTF8_TWO_CONTS | M_UTF8_OVERLONG_3 | M_UTF8_TOO_LARGE_1000 | M_UTF8_OVERLONG_4,
+        M_UTF8_TOO_LONG | M_UTF8_OVERLONG_2 | M_UTF8_TWO_CONTS | M_UTF8_OVERLONG_3 | M_UTF8_TOO_LARGE,
+        M_UTF8_TOO_LONG | M_UTF8_OVERLONG_2 | M_UTF8_TWO_CONTS | M_UTF8_SURROGATE | M_UTF8_TOO_LARGE,
+        M_UTF8_TOO_LONG | M_UTF8_OVERLONG_2 | M_UTF8_TWO_CONTS | M_UTF8_SURROGATE | M_UTF8_TOO_LARGE,
+        M_UTF8_TOO_SHORT, M_UTF8_TOO_SHORT, M_UTF8_TOO_SHORT, M_UTF8_TOO_SHORT,
+        M_UTF8_TOO_SHORT, M_UTF8_TOO_SHORT, M_UTF8_TOO_SHORT, M_UTF8_TOO_SHORT,
+        M_UTF8_TOO_SHORT, M_UTF8_TOO_SHORT, M_UTF8_TOO_SHORT, M_UTF8_TOO_SHORT,
+        M_UTF8_TOO_LONG | M_UTF8_OVERLONG_2 | M_UTF8_TWO_CONTS | M_UTF8_OVERLONG_3 | M_UTF8_TOO_LARGE_1000 | M_UTF8_OVERLONG_4,
+        M_UTF8_TOO_LONG | M_UTF8_OVERLONG_2 | M_UTF8_TWO_CONTS | M_UTF8_OVERLONG_3 | M_UTF8_TOO_LARGE,
+        M_UTF8_TOO_LONG | M_UTF8_OVERLONG_2 | M_UTF8_TWO_CONTS | M_UTF8_SURROGATE | M_UTF8_TOO_LARGE,
+        M_UTF8_TOO_LONG | M_UTF8_OVERLONG_2 | M_UTF8_TWO_CONTS | M_UTF8_SURROGATE | M_UTF8_TOO_LARGE,
+        M_UTF8_TOO_SHORT, M_UTF8_TOO_SHORT, M_UTF8_TOO_SHORT, M_UTF8_TOO_SHORT);
+    // clang-format on
+    const __m256i low_nibble = _mm256_set1_epi8(0x0F);
+
+    __m256i prev1 = m_utf8_prev_avx2(input, prev_input, 1);
+    __m256i prev2 = m_utf8_prev_avx2(input, prev_input, 2);
+    __m256i prev3 = m_utf8_prev_avx2(input, prev_input, 3);
+
+    /* byte pair classification. */
+    __m256i byte_1_high = _mm256_shuffle_epi8(byte_1_high_table,
+                                              _mm256_and_si256(_mm256_srli_epi16(prev1, 4), low_nibble));
+    __m256i byte_1_low = _mm256_shuffle_epi8(byte_1_low_table, _mm256_and_si256(prev1, low_nibble));
+    __m256i byte_2_high = _mm256_shuffle_epi8(byte_2_high_table,
+                                              _mm256_and_si256(_mm256_srli_epi16(input, 4), low_nibble));
+    __m256i special_cases = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+    /* 3rd byte of 3 or 4 bytes sequence, 4th byte of 4 bytes sequence must be continuation. */
+    __m256i is_third_byte = _mm256_subs_epu8(prev2, _mm256_set1_epi8((char)(0xE0 - 0x80)));
+    __m256i is_fourth_byte = _mm256_subs_epu8(prev3, _mm256_set1_epi8((char)(0xF0 - 0x80)));
+    __m256i must_be_continuation = _mm256_and_si256(_mm256_or_si256(is_third_byte, is_fourth_byte),
+                                                    _mm256_set1_epi8((char)0x80));
+    __m256i error = _mm256_xor_si256(must_be_continuation, special_cases);
+
+    /* noncharacters U+FDD0..U+FDEF( EF B7 90..AF). */
+    __m256i in_90_af = _mm256_sub_epi8(input, _mm256_set1_epi8((char)0x90));
+    in_90_af = _mm256_cmpeq_epi8(_mm256_min_epu8(in_90_af, _mm256_set1_epi8(0x1F)), in_90_af);
+    __m256i fdd0 = _mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi8(prev2, _mm256_set1_epi8((char)0xEF)),
+                                                     _mm256_cmpeq_epi8(prev1, _mm256_set1_epi8((char)0xB7))),
+                                    in_90_af);
+
+    /* noncharacters U+xFFFE, U+xFFFF( EF BF BE..BF, F? ?F BF BE..BF). */
+    __m256i is_be_bf = _mm256_cmpeq_epi8(_mm256_or_si256(input, _mm256_set1_epi8(0x01)),
+                                         _mm256_set1_epi8((char)0xBF));
+    __m256i fffe = _mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi8(_mm256_and_si256(prev2, low_nibble), low_nibble),
+                                                     _mm256_cmpeq_epi8(prev1, _mm256_set1_epi8((char)0xBF))),
+                                    is_be_bf);
+
+    return _mm256_or_si256(error, _mm256_or_si256(fdd0, fffe));
+}
+
+/**
+ * @private
+ * @fn static size_t m_utf8_valid_length(const uint8_t *str, size_t str_bytesize)
+ * @brief length of the valid utf8 prefix( AVX2, AVX-512)
+ * @note
+ *   skip ASCII blocks, and check other 32 bytes blocks with m_utf8_check_block.
+ *   when a block has an error, find the offset with the scalar loop.
+ */
+M_UTF8_KERNEL_TARGET static size_t M_UTF8_KERNEL(m_utf8_valid_length)(const uint8_t *str, size_t str_bytesize)
+{
+    // clang-format off
+    const __m256i max_value = _mm256_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+    // clang-format on
+    __m256i prev_input = _mm256_setzero_si256();
+    __m256i prev_incomplete = _mm256_setzero_si256();
+    size_t str_size = 0;
+
+    while (str_size + 32 <= str_bytesize)
+    {
+#if M_UTF8_KERNEL_LEVEL >= 3
+        /* 64 bytes ASCII block, the previous block must not end with an incomplete character. */
+        if (str_size + 64 <= str_bytesize && M_UTF8_KERNEL(m_utf8_ascii_mask)(str + str_size) == 0)
+        {
+            if (!_mm256_testz_si256(prev_incomplete, prev_incomplete))
+                break;
+            M_UTF8_STATS_ADD(fast_blocks, 1);
+            prev_input = _mm256_loadu_si256((const __m256i *)(str + str_size + 32));
+            str_size += 64;
+            continue;
+        }
+#endif
+        __m256i input = _mm256_loadu_si256((const __m256i *)(str + str_size));
+        if (_mm256_movemask_epi8(input) == 0)
+        {
+            if (!_mm256_testz_si256(prev_incomplete, prev_incomplete))
+                break;
+            M_UTF8_STATS_ADD(fast_blocks, 1);
+        }
+        else
+        {
+            M_UTF8_STATS_ADD(slow_blocks, 1);
+            __m256i error = M_UTF8_KERNEL(m_utf8_check_block)(input, prev_input);
+            if (!_mm256_testz_si256(error, error))
+                break;
+        }
+        prev_incomplete = _mm256_subs_epu8(input, max_value);
+        prev_input = input;
+        str_size += 32;
+    }
+
+    return m_utf8_valid_length_resume(str, str_bytesize, str_size);
+}
+#endif
+
+/**
+ * @private
+ * @fn static void m_utf8_stat_scan(const uint8_t *str, size_t str_bytesize, bool truncated, const m_utf8_width_profile_t *profile, m_utf8_stat_t *stat)
+ * @brief scan utf8 string once, and count characters and display width
+ * @param[in] str - utf8 string
+ * @param[in] str_bytesize - utf8 string byte size( not include null-terminated string size)
+ * @param[in] truncated - true when str_bytesize cut the string, the last character is not counted.
+ * @param[in] profile - width profile
+ * @param[out] stat - result. byte_size is the scanned byte size.
+ * @note
+ *   an invalid character is counted as display width 1( same as m_utf8_display_width).
+ */
+M_UTF8_KERNEL_TARGET static void M_UTF8_KERNEL(m_utf8_stat_scan)(const uint8_t *str, size_t str_bytesize,
+                                                                 bool truncated,
+                                                                 const m_utf8_width_profile_t *profile,
+                                                                 m_utf8_stat_t *stat)
+{
+    size_t str_size = 0;
+    int64_t char_count = 0;
+    int64_t display_width = 0;
+    int64_t error_offset = -1;
+
+    while (str_size < str_bytesize)
+    {
+#if M_UTF8_KERNEL_LEVEL >= 1
+        /* ASCII block is M_UTF8_ASCII_BLOCK characters, and M_UTF8_ASCII_BLOCK columns. */
+        while (str_size + M_UTF8_ASCII_BLOCK <= str_bytesize)
+        {
+            uint64_t mask = M_UTF8_KERNEL(m_utf8_ascii_mask)(str + str_size);
+            if (mask != 0)
+            {
+                int ascii_size = __builtin_ctzll(mask);
+                M_UTF8_STATS_ADD(slow_blocks, 1);
+                M_UTF8_STATS_ADD(char_count[0], ascii_size);
+                str_size += ascii_size;
+                char_count += ascii_size;
+                display_width += ascii_size;
+                break;
+            }
+            M_UTF8_STATS_ADD(fast_blocks, 1);
+            M_UTF8_STATS_ADD(char_count[0], M_UTF8_ASCII_BLOCK);
+            str_size += M_UTF8_ASCII_BLOCK;
+            char_count += M_UTF8_ASCII_BLOCK;
+            display_width += M_UTF8_ASCII_BLOCK;
+        }
+        if (str_size >= str_bytesize)
+            break;
+#endif
+        if (str[str_size] < 0x80)
+        {
+            M_UTF8_STATS_CHAR(1);
+            str_size++;
+            char_count++;
+            display_width++;
+            continue;
+        }
+
+        uint8_t ch_byte_size = m_utf8_jump_table[str[str_size]];
+        if (ch_byte_size > str_bytesize - str_size)
+        {
+            if (truncated)
+                break;
+            M_UTF8_STATS_ADD(invalid_count, 1);
+            if (error_offset < 0)
+                error_offset = (int64_t)str_size;
+            str_size = str_bytesize;
+            char_count++;
+            display_width++;
+            break;
+        }
+
+        uint32_t unicode;
+        if (m_utf8_dfa_decode(str + str_size, ch_byte_size, &unicode) == 0)
+        {
+            M_UTF8_STATS_ADD(invalid_count, 1);
+            if (error_offset < 0)
+                error_offset = (int64_t)str_size;
+            display_width++;
+        }
+        else
+        {
+            display_width += profile->width_of_class[m_utf8_width_class(unicode)];
+        }
+        M_UTF8_STATS_CHAR(ch_byte_size);
+        str_size += ch_byte_size;
+        char_count++;
+    }
+
+    stat->byte_size = (int64_t)str_size;
+    stat->char_count = char_count;
+    stat->display_width = display_width;
+    stat->error_offset = error_offset;
+}
+
+/**
+ * @private
+ * @fn static int64_t m_utf8_count_scan(const uint8_t *str, size_t str_bytesize)
+ * @brief utf8 character count
+ * @param[in] str - utf8 string
+ * @param[in] str_bytesize - utf8 string byte size
+ * @return character count, a character truncated by str_bytesize is counted.
+ */
+M_UTF8_KERNEL_TARGET static int64_t M_UTF8_KERNEL(m_utf8_count_scan)(const uint8_t *str, size_t str_bytesize)
+{
+    size_t str_size = 0;
+    int64_t char_count = 0;
+
+    while (str_size < str_bytesize)
+    {
+#if M_UTF8_KERNEL_LEVEL >= 1
+        while (str_size + M_UTF8_ASCII_BLOCK <= str_bytesize)
+        {
+            uint64_t mask = M_UTF8_KERNEL(m_utf8_ascii_mask)(str + str_size);
+            if (mask != 0)
+            {
+                int ascii_size = __builtin_ctzll(mask);
+                M_UTF8_STATS_ADD(slow_blocks, 1);
+                M_UTF8_STATS_ADD(char_count[0], ascii_size);
+                str_size += ascii_size;
+                char_count += ascii_size;
+                break;
+            }
+            M_UTF8_STATS_ADD(fast_blocks, 1);
+            M_UTF8_STATS_ADD(char_count[0], M_UTF8_ASCII_BLOCK);
+            str_size += M_UTF8_ASCII_BLOCK;
+            char_count += M_UTF8_ASCII_BLOCK;
+        }
+        if (str_size >= str_bytesize)
+            break;
+#endif
+        M_UTF8_STATS_CHAR(m_utf8_jump_table[str[str_size]]);
+        str_size += m_utf8_jump_table[str[str_size]];
+        char_count++;
+    }
+
+    return char_count;
+}
+
+/**
+ * @private
+ * @fn static void m_utf8_to_unicode_scan(const uint8_t *str, size_t str_bytesize, uint32_t *dst, size_t dst_size, m_utf8_conv_t *conv)
+ * @brief body of m_utf8_mem_to_unicode
+ * @param[out] conv - result( not NULL)
+ */
+M_UTF8_KERNEL_TARGET static void M_UTF8_KERNEL(m_utf8_to_unicode_scan)(const uint8_t *str, size_t str_bytesize,
+                                                                       uint32_t *dst, size_t dst_size,
+                                                                       m_utf8_conv_t *conv)
+{
+    size_t str_size = 0;
+    size_t written = 0;
+    int64_t error_offset = -1;
+
+    while (str_size < str_bytesize && written < dst_size)
+    {
+#if M_UTF8_KERNEL_LEVEL >= 2
+        /* ASCII block is zero extended to 32 unicode. */
+        while (str_size + 32 <= str_bytesize && written + 32 <= dst_size)
+        {
+            __m256i input = _mm256_loadu_si256((const __m256i *)(str + str_size));
+            __m128i low = _mm256_castsi256_si128(input);
+            __m128i high = _mm256_extracti128_si256(input, 1);
+            _mm256_storeu_si256((__m256i *)(dst + written), _mm256_cvtepu8_epi32(low));
+            _mm256_storeu_si256((__m256i *)(dst + written + 8), _mm256_cvtepu8_epi32(_mm_srli_si128(low, 8)));
+            _mm256_storeu_si256((__m256i *)(dst + written + 16), _mm256_cvtepu8_epi32(high));
+            _mm256_storeu_si256((__m256i *)(dst + written + 24), _mm256_cvtepu8_epi32(_mm_srli_si128(high, 8)));
+
+            unsigned int mask = (unsigned int)_mm256_movemask_epi8(input);
+            if (mask != 0)
+            {
+                int ascii_size = __builtin_ctz(mask);
+                str_size += ascii_size;
+                written += ascii_size;
+                break;
+            }
+            str_size += 32;
+            written += 32;
+        }
+        if (str_size >= str_bytesize || written >= dst_size)
+            break;
+#elif M_UTF8_KERNEL_LEVEL >= 1
+        /* ASCII block is zero extended to 16 unicode. */
+        while (str_size + 16 <= str_bytesize && written + 16 <= dst_size)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            __m128i input = _mm_loadu_si128((const __m128i *)(str + str_size));
+            __m128i low = _mm_unpacklo_epi8(input, zero);
+            __m128i high = _mm_unpackhi_epi8(input, zero);
+            _mm_storeu_si128((__m128i *)(dst + written), _mm_unpacklo_epi16(low, zero));
+            _mm_storeu_si128((__m128i *)(dst + written + 4), _mm_unpackhi_epi16(low, zero));
+            _mm_storeu_si128((__m128i *)(dst + written + 8), _mm_unpacklo_epi16(high, zero));
+            _mm_storeu_si128((__m128i *)(dst + written + 12), _mm_unpackhi_epi16(high, zero));
+
+            int mask = _mm_movemask_epi8(input);
+            if (mask != 0)
+            {
+                int ascii_size = __builtin_ctz(mask);
+                str_size += ascii_size;
+                written += ascii_size;
+                break;
+            }
+            str_size += 16;
+            written += 16;
+        }
+        if (str_size >= str_bytesize || written >= dst_size)
+            break;
+#endif
+        if (str[str_size] < 0x80)
+        {
+            dst[written++] = str[str_size++];
+            continue;
+        }
+
+        uint8_t ch_byte_size = m_utf8_dfa_decode(str + str_size, str_bytesize - str_size, &dst[written]);
+        if (ch_byte_size == 0)
+        {
+            error_offset = (int64_t)str_size;
+            break;
+        }
+        str_size += ch_byte_size;
+        written++;
+    }
+
+    conv->src_read = (int64_t)str_size;
+    conv->dst_written = (int64_t)written;
+    conv->error_offset = error_offset;
+}
+
+/**
+ * @private
+ * @fn static void m_utf8_to_utf16_scan(const uint8_t *str, size_t str_bytesize, uint16_t *dst, size_t dst_size, m_utf8_conv_t *conv)
+ * @brief body of m_utf8_mem_to_utf16
+ * @param[out] conv - result( not NULL)
+ * @note
+ *   the 3 bytes block needs SSSE3, it is used from the AVX2 level.
+ */
+M_UTF8_KERNEL_TARGET static void M_UTF8_KERNEL(m_utf8_to_utf16_scan)(const uint8_t *str, size_t str_bytesize,
+                                                                     uint16_t *dst, size_t dst_size,
+                                                                     m_utf8_conv_t *conv)
+{
+    size_t str_size = 0;
+    size_t written = 0;
+    int64_t error_offset = -1;
+
+    while (str_size < str_bytesize && written < dst_size)
+    {
+#if M_UTF8_KERNEL_LEVEL >= 2
+        /* ASCII block is zero extended to 32 code units. */
+        while (str_size + 32 <= str_bytesize && written + 32 <= dst_size)
+        {
+            __m256i input = _mm256_loadu_si256((const __m256i *)(str + str_size));
+            _mm256_storeu_si256((__m256i *)(dst + written), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(input)));
+            _mm256_storeu_si256((__m256i *)(dst + written + 16),
+                                _mm256_cvtepu8_epi16(_mm256_extracti128_si256(input, 1)));
+
+            unsigned int mask = (unsigned int)_mm256_movemask_epi8(input);
+            if (mask != 0)
+            {
+                int ascii_size = __builtin_ctz(mask);
+                str_size += ascii_size;
+                written += ascii_size;
+                break;
+            }
+            str_size += 32;
+            written += 32;
+        }
+#elif M_UTF8_KERNEL_LEVEL >= 1
+        /* ASCII block is zero extended to 16 code units. */
+        while (str_size + 16 <= str_bytesize && written + 16 <= dst_size)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            __m128i input = _mm_loadu_si128((const __m128i *)(str + str_size));
+            _mm_storeu_si128((__m128i *)(dst + written), _mm_unpacklo_epi8(input, zero));
+            _mm_storeu_si128((__m128i *)(dst + written + 8), _mm_unpackhi_epi8(input, zero));
+
+            int mask = _mm_movemask_epi8(input);
+            if (mask != 0)
+            {
+                int ascii_size = __builtin_ctz(mask);
+                str_size += ascii_size;
+                written += ascii_size;
+                break;
+            }
+            str_size += 16;
+            written += 16;
+        }
+#endif
+#if M_UTF8_KERNEL_LEVEL >= 1
+        /* 2 bytes block is 8 characters of 110xxxxx 10xxxxxx, lead is not C0 or C1. */
+        while (str_size + 16 <= str_bytesize && written + 8 <= dst_size)
+        {
+            __m128i input = _mm_loadu_si128((const __m128i *)(str + str_size));
+            __m128i pattern = _mm_cmpeq_epi16(_mm_and_si128(input, _mm_set1_epi16((short)0xC0E0)),
+                                              _mm_set1_epi16((short)0x80C0));
+            __m128i overlong = _mm_cmpeq_epi16(_mm_and_si128(input, _mm_set1_epi16(0x1E)), _mm_setzero_si128());
+            if (_mm_movemask_epi8(_mm_andnot_si128(overlong, pattern)) != 0xFFFF)
+                break;
+            __m128i low = _mm_and_si128(_mm_srli_epi16(input, 8), _mm_set1_epi16(0x3F));
+            __m128i high = _mm_slli_epi16(_mm_and_si128(input, _mm_set1_epi16(0x1F)), 6);
+            _mm_storeu_si128((__m128i *)(dst + written), _mm_or_si128(high, low));
+            str_size += 16;
+            written += 8;
+        }
+#endif
+#if M_UTF8_KERNEL_LEVEL >= 2
+        /* 3 bytes block is 4 characters of 1110xxxx 10xxxxxx 10xxxxxx in U+0800..U+FFFF,
+           not surrogate and not noncharacter. */
+        while (str_size + 16 <= str_bytesize && written + 4 <= dst_size)
+        {
+            __m128i input = _mm_loadu_si128((const __m128i *)(str + str_size));
+            /* each 32 bits lane is ( lead, lead, second, third) of a character. */
+            __m128i lanes = _mm_shuffle_epi8(input, _mm_setr_epi8(0, 0, 1, 2, 3, 3, 4, 5, 6, 6, 7, 8, 9, 9, 10, 11));
+            __m128i pattern = _mm_cmpeq_epi32(_mm_and_si128(lanes, _mm_set1_epi32((int)0xC0C0F0F0)),
+                                              _mm_set1_epi32((int)0x8080E0E0));
+            if (_mm_movemask_epi8(pattern) != 0xFFFF)
+                break;
+            /* 16 bits lanes are ( lead, lead) and ( second, third). */
+            __m128i lead = _mm_slli_epi16(_mm_and_si128(lanes, _mm_set1_epi32(0x0F)), 12);
+            __m128i second = _mm_slli_epi16(_mm_and_si128(_mm_srli_epi32(lanes, 16), _mm_set1_epi32(0x3F)), 6);
+            __m128i third = _mm_and_si128(_mm_srli_epi32(lanes, 24), _mm_set1_epi32(0x3F));
+            __m128i unicode = _mm_or_si128(lead, _mm_or_si128(second, third));
+            __m128i high = _mm_and_si128(unicode, _mm_set1_epi32(0xF800));
+            __m128i invalid = _mm_or_si128(_mm_cmpeq_epi32(high, _mm_setzero_si128()),
+                                           _mm_cmpeq_epi32(high, _mm_set1_epi32(0xD800)));
+            __m128i row = _mm_and_si128(unicode, _mm_set1_epi32(0xFFF0));
+            invalid = _mm_or_si128(invalid, _mm_cmpeq_epi32(row, _mm_set1_epi32(0xFDD0)));
+            invalid = _mm_or_si128(invalid, _mm_cmpeq_epi32(row, _mm_set1_epi32(0xFDE0)));
+            invalid = _mm_or_si128(invalid, _mm_cmpeq_epi32(_mm_and_si128(unicode, _mm_set1_epi32(0xFFFE)),
+                                                            _mm_set1_epi32(0xFFFE)));
+            if (_mm_movemask_epi8(invalid) != 0)
+                break;
+            /* pack the low 16 bits of 4 lanes. */
+            unicode = _mm_shuffle_epi8(unicode, _mm_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1));
+            _mm_storel_epi64((__m128i *)(dst + written), unicode);
+            str_size += 12;
+            written += 4;
+        }
+#endif
+#if M_UTF8_KERNEL_LEVEL >= 1
+        if (str_size >= str_bytesize || written >= dst_size)
+            break;
+#endif
+        if (str[str_size] < 0x80)
+        {
+            dst[written++] = str[str_size++];
+            continue;
+        }
+
+        uint32_t unicode;
+        uint8_t ch_byte_size = m_utf8_dfa_decode(str + str_size, str_bytesize - str_size, &unicode);
+        if (ch_byte_size == 0)
+        {
+            error_offset = (int64_t)str_size;
+            break;
+        }
+        if (unicode >= 0x10000)
+        {
+            if (written + 2 > dst_size)
+                break;
+            unicode -= 0x10000;
+            dst[written++] = (uint16_t)(0xD800 | (unicode >> 10));
+            dst[written++] = (uint16_t)(0xDC00 | (unicode & 0x3FF));
+        }
+        else
+        {
+            dst[written++] = (uint16_t)unicode;
+        }
+        str_size += ch_byte_size;
+    }
+
+    conv->src_read = (int64_t)str_size;
+    conv->dst_written = (int64_t)written;
+    conv->error_offset = error_offset;
+}
+
+#undef M_UTF8_KERNEL
+#undef M_UTF8_KERNEL_TARGET
+#undef M_UTF8_ASCII_BLOCK
+#undef M_UTF8_KERNEL_LEVEL
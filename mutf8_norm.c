@@ -0,0 +1,719 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#if defined(__GNUC__)
+#define M_UTF8_NORM_AVX2
+#endif
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "mutf8.h"
+#include "mutf8_norm_table.h"
+#include "mutf8_stats.h"
+
+/* Hangul syllable composition( Unicode 3.12) */
+#define M_UTF8_NORM_S_BASE 0xAC00
+#define M_UTF8_NORM_L_BASE 0x1100
+#define M_UTF8_NORM_V_BASE 0x1161
+#define M_UTF8_NORM_T_BASE 0x11A7
+#define M_UTF8_NORM_L_COUNT 19
+#define M_UTF8_NORM_V_COUNT 21
+#define M_UTF8_NORM_T_COUNT 28
+#define M_UTF8_NORM_N_COUNT (M_UTF8_NORM_V_COUNT * M_UTF8_NORM_T_COUNT)
+#define M_UTF8_NORM_S_COUNT (M_UTF8_NORM_L_COUNT * M_UTF8_NORM_N_COUNT)
+
+/*
+ * code points under U+0300( lead byte under 0xCC) are starters which are Yes in NFC,
+ * and code points under U+00C0( lead byte under 0xC3) are in NFD.
+ */
+#define M_UTF8_NORM_NFC_SAFE_BYTE 0xCC
+#define M_UTF8_NORM_NFD_SAFE_BYTE 0xC3
+
+/* code points of a segment decomposed on the stack, longer segments are allocated. */
+#ifndef M_UTF8_NORM_SEGMENT_SIZE
+#define M_UTF8_NORM_SEGMENT_SIZE 64
+#endif
+
+/**
+ * @private
+ * @fn static inline const struct m_utf8_norm_property *m_utf8_norm_lookup(uint32_t unicode)
+ * @brief canonical combining class and quick check flags of unicode
+ */
+static inline const struct m_utf8_norm_property *m_utf8_norm_lookup(uint32_t unicode)
+{
+    return &m_utf8_norm_property[m_utf8_norm_stage2[(uint32_t)m_utf8_norm_stage1[unicode >> M_UTF8_NORM_SHIFT]
+                                                        << M_UTF8_NORM_SHIFT |
+                                                    (unicode & M_UTF8_NORM_MASK)]];
+}
+
+/**
+ * @private
+ * @fn static inline uint32_t m_utf8_norm_decode(const uint8_t *str, uint8_t *ch_byte_size)
+ * @brief decode the first character of validated utf8
+ */
+static inline uint32_t m_utf8_norm_decode(const uint8_t *str, uint8_t *ch_byte_size)
+{
+    if (str[0] < 0x80)
+    {
+        *ch_byte_size = 1;
+        return str[0];
+    }
+    if (str[0] < 0xE0)
+    {
+        *ch_byte_size = 2;
+        return (uint32_t)(str[0] & 0x1F) << 6 | (str[1] & 0x3F);
+    }
+    if (str[0] < 0xF0)
+    {
+        *ch_byte_size = 3;
+        return (uint32_t)(str[0] & 0x0F) << 12 | (uint32_t)(str[1] & 0x3F) << 6 | (str[2] & 0x3F);
+    }
+    *ch_byte_size = 4;
+    return (uint32_t)(str[0] & 0x07) << 18 | (uint32_t)(str[1] & 0x3F) << 12 | (uint32_t)(str[2] & 0x3F) << 6 |
+           (str[3] & 0x3F);
+}
+
+/**
+ * @private
+ * @struct m_utf8_norm_check
+ * @brief quick check of a normalization form
+ */
+struct m_utf8_norm_check
+{
+    uint8_t no_mask;              /* quick check flags which are not Yes */
+    uint8_t safe_byte;            /* characters of lead byte under this are starters which are Yes */
+    const uint32_t *pairs;        /* the first two bytes of the characters which are not a starter of Yes */
+    const uint8_t (*nibbles)[16]; /* pairs as the boxes of nibbles */
+};
+
+static const struct m_utf8_norm_check m_utf8_norm_checks[] = {
+    [M_UTF8_NORM_NFC] = {M_UTF8_NORM_NFC_NO | M_UTF8_NORM_NFC_MAYBE, M_UTF8_NORM_NFC_SAFE_BYTE, m_utf8_norm_nfc_pairs,
+                         m_utf8_norm_nfc_nibbles},
+    [M_UTF8_NORM_NFD] = {M_UTF8_NORM_NFD_NO, M_UTF8_NORM_NFD_SAFE_BYTE, m_utf8_norm_nfd_pairs, m_utf8_norm_nfd_nibbles},
+};
+
+/**
+ * @private
+ * @fn static inline uint32_t m_utf8_norm_block_hits(const struct m_utf8_norm_check *check, const uint8_t *str)
+ * @brief bit of the byte of 16 bytes, which may be the lead of a character which is not a starter of Yes
+ * @note
+ *   read 17 bytes, the second byte of the last one.
+ *   no branch for each character, the bytes are not decoded.
+ */
+static inline uint32_t m_utf8_norm_block_hits(const struct m_utf8_norm_check *check, const uint8_t *str)
+{
+    uint32_t hits = 0;
+
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        uint32_t index = (uint32_t)str[i] << 6 | (str[i + 1] & 0x3F);
+        hits |= (check->pairs[index >> 5] >> (index & 31) & 1) << i;
+    }
+    return hits;
+}
+
+#if defined(M_UTF8_NORM_AVX2)
+/**
+ * @private
+ * @fn static uint32_t m_utf8_norm_block_hits_avx2(const struct m_utf8_norm_check *check, const uint8_t *str)
+ * @brief bit of the byte of 32 bytes, which may be the lead of a character which is not a starter of Yes( AVX2)
+ * @note
+ *   read 33 bytes. a bit of the boxes is set for the pair of the lead and the next byte,
+ *   so the bits are the same as m_utf8_norm_block_hits or more.
+ */
+__attribute__((target("avx2"))) static uint32_t m_utf8_norm_block_hits_avx2(const struct m_utf8_norm_check *check,
+                                                                             const uint8_t *str)
+{
+    const __m256i low = _mm256_set1_epi8(0x0F);
+    const __m256i lead_high = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)check->nibbles[0]));
+    const __m256i lead_low = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)check->nibbles[1]));
+    const __m256i next_high = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)check->nibbles[2]));
+    const __m256i next_low = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)check->nibbles[3]));
+    __m256i lead = _mm256_loadu_si256((const __m256i *)str);
+    __m256i next = _mm256_loadu_si256((const __m256i *)(str + 1));
+
+    __m256i boxes = _mm256_and_si256(_mm256_shuffle_epi8(lead_high, _mm256_and_si256(_mm256_srli_epi16(lead, 4), low)),
+                                     _mm256_shuffle_epi8(lead_low, _mm256_and_si256(lead, low)));
+    boxes = _mm256_and_si256(boxes, _mm256_shuffle_epi8(next_high, _mm256_and_si256(_mm256_srli_epi16(next, 4), low)));
+    boxes = _mm256_and_si256(boxes, _mm256_shuffle_epi8(next_low, _mm256_and_si256(next, low)));
+    return ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(boxes, _mm256_setzero_si256()));
+}
+#endif
+
+/**
+ * @private
+ * @fn static inline size_t m_utf8_norm_block_size(void)
+ * @brief byte size of the block of m_utf8_norm_hits, by the SIMD level in use
+ */
+static inline size_t m_utf8_norm_block_size(void)
+{
+#if defined(M_UTF8_NORM_AVX2)
+    if (m_utf8_simd_level() >= M_UTF8_SIMD_AVX2)
+        return 32;
+#endif
+    return 16;
+}
+
+/**
+ * @private
+ * @fn static inline uint32_t m_utf8_norm_hits(const struct m_utf8_norm_check *check, const uint8_t *str, size_t block_size)
+ * @brief bit of the byte of the block, which may be the lead of a character which is not a starter of Yes
+ * @note
+ *   read block_size + 1 bytes.
+ */
+static inline uint32_t m_utf8_norm_hits(const struct m_utf8_norm_check *check, const uint8_t *str, size_t block_size)
+{
+#if defined(M_UTF8_NORM_AVX2)
+    if (block_size == 32)
+        return m_utf8_norm_block_hits_avx2(check, str);
+#endif
+    (void)block_size;
+    return m_utf8_norm_block_hits(check, str);
+}
+
+/**
+ * @private
+ * @fn static inline size_t m_utf8_norm_prev(const uint8_t *str, size_t offset)
+ * @brief offset of the character before offset in validated utf8
+ */
+static inline size_t m_utf8_norm_prev(const uint8_t *str, size_t offset)
+{
+    do
+    {
+        offset--;
+    } while ((str[offset] & 0xC0) == 0x80);
+    return offset;
+}
+
+/**
+ * @private
+ * @fn static inline bool m_utf8_norm_is_stable(const struct m_utf8_norm_check *check, const uint8_t *str, uint8_t *ch_byte_size)
+ * @brief the first character is a starter which is Yes in quick check
+ */
+static inline bool m_utf8_norm_is_stable(const struct m_utf8_norm_check *check, const uint8_t *str,
+                                         uint8_t *ch_byte_size)
+{
+    uint32_t unicode = m_utf8_norm_decode(str, ch_byte_size);
+    const struct m_utf8_norm_property *property;
+
+    if (str[0] < check->safe_byte)
+        return true;
+    property = m_utf8_norm_lookup(unicode);
+    return property->ccc == 0 && (property->flags & check->no_mask) == 0;
+}
+
+/**
+ * @private
+ * @fn static size_t m_utf8_norm_scan(const struct m_utf8_norm_check *check, size_t block_size, const uint8_t *str, size_t str_bytesize, size_t offset, size_t *stable)
+ * @brief skip characters which are Yes in quick check( UAX #15 9.1), from offset
+ * @param[in] check - quick check of the form
+ * @param[in] block_size - m_utf8_norm_block_size
+ * @param[in] str - validated utf8 buffer
+ * @param[in] str_bytesize - utf8 buffer byte size
+ * @param[in] offset - start offset, a starter which is Yes or a boundary( m_utf8_norm_is_boundary)
+ * @param[out] stable - offset of the last starter which is Yes before the return value
+ * @return offset of the first character which is not Yes or is not in canonical order, str_bytesize when none
+ */
+static size_t m_utf8_norm_scan(const struct m_utf8_norm_check *check, size_t block_size, const uint8_t *str,
+                               size_t str_bytesize, size_t offset, size_t *stable)
+{
+    size_t last_stable = offset;
+    uint8_t last_ccc = 0;
+    uint32_t hits = 0;      /* leads to check in the block */
+    size_t block = offset;  /* offset of the block of hits */
+    size_t block_end = offset;
+
+    while (true)
+    {
+        size_t next;
+        if (hits != 0)
+        {
+            next = block + (size_t)__builtin_ctz(hits);
+            hits &= hits - 1;
+            if (next < offset)
+                continue; /* lead of the character checked already */
+        }
+        else if (offset < block_end)
+        {
+            /* rest of the block is starters of Yes, and the last character may cross the end. */
+            next = block_end;
+            while (next < str_bytesize && (str[next] & 0xC0) == 0x80)
+                next++;
+            last_stable = m_utf8_norm_prev(str, next);
+            last_ccc = 0;
+            offset = next;
+            continue;
+        }
+        else if (str_bytesize - offset > block_size)
+        {
+            size_t skip = offset;
+#if defined(__SSE2__)
+            /* skip blocks of the bytes under safe_byte. */
+            const __m128i safe = _mm_set1_epi8((char)check->safe_byte);
+            while (str_bytesize - skip > 16)
+            {
+                __m128i bytes = _mm_loadu_si128((const __m128i *)(str + skip));
+                /* byte >= safe_byte, unsigned compare by the max. */
+                if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(bytes, safe), bytes)) != 0)
+                    break;
+                skip += 16;
+            }
+#endif
+            while (str_bytesize - skip > block_size && (hits = m_utf8_norm_hits(check, str + skip, block_size)) == 0)
+                skip += block_size;
+            block = skip;
+            block_end = str_bytesize - skip > block_size ? skip + block_size : skip;
+            if (skip > offset)
+            {
+                while (skip < str_bytesize && (str[skip] & 0xC0) == 0x80)
+                    skip++; /* skip the rest of the last character */
+                last_stable = m_utf8_norm_prev(str, skip);
+                last_ccc = 0;
+                offset = skip;
+            }
+            continue;
+        }
+        else if (offset < str_bytesize)
+        {
+            next = offset; /* tail of the buffer */
+        }
+        else
+        {
+            break;
+        }
+
+        /* characters in [offset, next) are starters of Yes. */
+        if (next > offset)
+            last_ccc = 0;
+
+        uint8_t ch_byte_size;
+        const struct m_utf8_norm_property *property = m_utf8_norm_lookup(m_utf8_norm_decode(str + next, &ch_byte_size));
+        if ((property->flags & check->no_mask) != 0 || (property->ccc != 0 && last_ccc > property->ccc))
+        {
+            if (next > offset)
+                last_stable = m_utf8_norm_prev(str, next);
+            offset = next;
+            break;
+        }
+        if (property->ccc == 0)
+            last_stable = next;
+        else if (next > offset)
+            last_stable = m_utf8_norm_prev(str, next);
+        last_ccc = property->ccc;
+        offset = next + ch_byte_size;
+    }
+    *stable = last_stable;
+    return offset;
+}
+
+/**
+ * @private
+ * @fn static size_t m_utf8_norm_stable_before(const struct m_utf8_norm_check *check, const uint8_t *str, size_t start, size_t limit)
+ * @brief offset of the last starter which is Yes in ( start, limit], start when none
+ * @note
+ *   characters in [start, limit) are Yes.
+ */
+static size_t m_utf8_norm_stable_before(const struct m_utf8_norm_check *check, const uint8_t *str, size_t start,
+                                        size_t limit)
+{
+    size_t offset = limit;
+
+    while (offset > start)
+    {
+        uint8_t ch_byte_size;
+        while (offset > start && (str[offset] & 0xC0) == 0x80)
+            offset--;
+        if (offset == start || m_utf8_norm_is_stable(check, str + offset, &ch_byte_size))
+            return offset;
+        offset--;
+    }
+    return start;
+}
+
+/**
+ * @private
+ * @fn static int m_utf8_norm_find_decomposition(uint32_t unicode)
+ * @brief index of m_utf8_norm_decomposition, -1 when not found
+ */
+static int m_utf8_norm_find_decomposition(uint32_t unicode)
+{
+    int low = 0;
+    int high = (int)(sizeof(m_utf8_norm_decomposition) / sizeof(m_utf8_norm_decomposition[0])) - 1;
+
+    while (low <= high)
+    {
+        int mid = (low + high) / 2;
+        if (m_utf8_norm_decomposition[mid].unicode < unicode)
+            low = mid + 1;
+        else if (m_utf8_norm_decomposition[mid].unicode > unicode)
+            high = mid - 1;
+        else
+            return mid;
+    }
+    return -1;
+}
+
+/**
+ * @private
+ * @fn static inline bool m_utf8_norm_is_boundary(const struct m_utf8_norm_check *check, const uint8_t *str, uint8_t *ch_byte_size)
+ * @brief the first character does not interact with the characters before it
+ * @note
+ *   a starter whose decomposition starts with a starter, and not Maybe in NFC( composes with the starter before).
+ *   U+0F73, U+0F75 and U+0F81 are starters, but decompose to U+0F71( ccc 129) and a vowel sign.
+ */
+static inline bool m_utf8_norm_is_boundary(const struct m_utf8_norm_check *check, const uint8_t *str,
+                                           uint8_t *ch_byte_size)
+{
+    uint32_t unicode = m_utf8_norm_decode(str, ch_byte_size);
+    const struct m_utf8_norm_property *property;
+
+    if (str[0] < check->safe_byte)
+        return true;
+    property = m_utf8_norm_lookup(unicode);
+    /* no_mask has NFC_MAYBE only in NFC. */
+    if (property->ccc != 0 || (property->flags & check->no_mask & M_UTF8_NORM_NFC_MAYBE) != 0)
+        return false;
+    if ((property->flags & M_UTF8_NORM_NFD_NO) != 0)
+    {
+        int index = m_utf8_norm_find_decomposition(unicode);
+        if (index >= 0)
+            return m_utf8_norm_lookup(m_utf8_norm_decomposition_pool[m_utf8_norm_decomposition[index].offset])->ccc ==
+                   0;
+    }
+    return true;
+}
+
+/**
+ * @private
+ * @fn static size_t m_utf8_norm_segment_end(const struct m_utf8_norm_check *check, const uint8_t *str, size_t str_bytesize, size_t offset)
+ * @brief offset of the next boundary( m_utf8_norm_is_boundary) after the character of offset, str_bytesize when none
+ * @note
+ *   not only a starter which is Yes, so a run of precomposed characters( Hangul syllables in NFD)
+ *   is a segment per character, and fits in dst and in the local code points.
+ */
+static size_t m_utf8_norm_segment_end(const struct m_utf8_norm_check *check, const uint8_t *str, size_t str_bytesize,
+                                      size_t offset)
+{
+    uint8_t ch_byte_size;
+
+    m_utf8_norm_decode(str + offset, &ch_byte_size);
+    offset += ch_byte_size;
+    while (offset < str_bytesize && !m_utf8_norm_is_boundary(check, str + offset, &ch_byte_size))
+        offset += ch_byte_size;
+    return offset;
+}
+
+/**
+ * @private
+ * @fn static uint32_t m_utf8_norm_find_composition(uint32_t first, uint32_t second)
+ * @brief primary composite of the pair, 0 when none
+ */
+static uint32_t m_utf8_norm_find_composition(uint32_t first, uint32_t second)
+{
+    if (first - M_UTF8_NORM_L_BASE < M_UTF8_NORM_L_COUNT && second - M_UTF8_NORM_V_BASE < M_UTF8_NORM_V_COUNT)
+    {
+        return M_UTF8_NORM_S_BASE +
+               ((first - M_UTF8_NORM_L_BASE) * M_UTF8_NORM_V_COUNT + (second - M_UTF8_NORM_V_BASE)) *
+                   M_UTF8_NORM_T_COUNT;
+    }
+    if (first - M_UTF8_NORM_S_BASE < M_UTF8_NORM_S_COUNT && (first - M_UTF8_NORM_S_BASE) % M_UTF8_NORM_T_COUNT == 0 &&
+        second - (M_UTF8_NORM_T_BASE + 1) < M_UTF8_NORM_T_COUNT - 1)
+    {
+        return first + (second - M_UTF8_NORM_T_BASE);
+    }
+
+    int low = 0;
+    int high = (int)(sizeof(m_utf8_norm_composition) / sizeof(m_utf8_norm_composition[0])) - 1;
+    while (low <= high)
+    {
+        int mid = (low + high) / 2;
+        const struct m_utf8_norm_composition *entry = &m_utf8_norm_composition[mid];
+        if (entry->first < first || (entry->first == first && entry->second < second))
+            low = mid + 1;
+        else if (entry->first > first || entry->second > second)
+            high = mid - 1;
+        else
+            return entry->composite;
+    }
+    return 0;
+}
+
+/**
+ * @private
+ * @fn static size_t m_utf8_norm_decompose(const uint8_t *str, size_t str_bytesize, uint32_t *unicodes)
+ * @brief full canonical decomposition of validated utf8, in canonical order
+ * @param[out] unicodes - code points( str_bytesize * 2 is enough)
+ * @return code point count
+ */
+static size_t m_utf8_norm_decompose(const uint8_t *str, size_t str_bytesize, uint32_t *unicodes)
+{
+    size_t count = 0;
+    size_t offset = 0;
+
+    while (offset < str_bytesize)
+    {
+        uint8_t ch_byte_size;
+        uint32_t unicode = m_utf8_norm_decode(str + offset, &ch_byte_size);
+        offset += ch_byte_size;
+
+        uint32_t s_index = unicode - M_UTF8_NORM_S_BASE;
+        if (s_index < M_UTF8_NORM_S_COUNT)
+        {
+            unicodes[count++] = M_UTF8_NORM_L_BASE + s_index / M_UTF8_NORM_N_COUNT;
+            unicodes[count++] = M_UTF8_NORM_V_BASE + (s_index % M_UTF8_NORM_N_COUNT) / M_UTF8_NORM_T_COUNT;
+            if (s_index % M_UTF8_NORM_T_COUNT != 0)
+                unicodes[count++] = M_UTF8_NORM_T_BASE + s_index % M_UTF8_NORM_T_COUNT;
+            continue;
+        }
+        if ((m_utf8_norm_lookup(unicode)->flags & M_UTF8_NORM_NFD_NO) != 0)
+        {
+            int index = m_utf8_norm_find_decomposition(unicode);
+            if (index >= 0)
+            {
+                const uint32_t *mapping = &m_utf8_norm_decomposition_pool[m_utf8_norm_decomposition[index].offset];
+                for (uint16_t i = 0; i < m_utf8_norm_decomposition[index].size; i++)
+                    unicodes[count++] = mapping[i];
+                continue;
+            }
+        }
+        unicodes[count++] = unicode;
+    }
+
+    /* canonical ordering, stable insertion sort of non-starters by ccc. */
+    for (size_t i = 1; i < count; i++)
+    {
+        uint32_t unicode = unicodes[i];
+        uint8_t ccc = m_utf8_norm_lookup(unicode)->ccc;
+        size_t j = i;
+        if (ccc == 0)
+            continue;
+        while (j > 0 && m_utf8_norm_lookup(unicodes[j - 1])->ccc > ccc)
+        {
+            unicodes[j] = unicodes[j - 1];
+            j--;
+        }
+        unicodes[j] = unicode;
+    }
+    return count;
+}
+
+/**
+ * @private
+ * @fn static size_t m_utf8_norm_compose(uint32_t *unicodes, size_t count)
+ * @brief canonical composition of decomposed code points( UAX #15 sample code)
+ * @return composed code point count
+ */
+static size_t m_utf8_norm_compose(uint32_t *unicodes, size_t count)
+{
+    size_t starter = 0;
+    size_t composed = 1;
+    int last_ccc;
+
+    if (count == 0)
+        return 0;
+    last_ccc = m_utf8_norm_lookup(unicodes[0])->ccc != 0 ? 256 : 0;
+    for (size_t i = 1; i < count; i++)
+    {
+        uint32_t unicode = unicodes[i];
+        int ccc = m_utf8_norm_lookup(unicode)->ccc;
+        uint32_t composite = m_utf8_norm_find_composition(unicodes[starter], unicode);
+
+        if (composite != 0 && (last_ccc < ccc || last_ccc == 0))
+        {
+            unicodes[starter] = composite;
+            continue;
+        }
+        if (ccc == 0)
+            starter = composed;
+        last_ccc = ccc;
+        unicodes[composed++] = unicode;
+    }
+    return composed;
+}
+
+/**
+ * @private
+ * @fn static int64_t m_utf8_norm_segment(const uint8_t *str, size_t str_bytesize, m_utf8_norm_t form, uint32_t *local, uint32_t **unicodes)
+ * @brief normalize a segment to code points
+ * @param[in] local - M_UTF8_NORM_SEGMENT_SIZE code points
+ * @param[out] unicodes - local, or allocated when the segment is long( free by the caller)
+ * @return code point count, -1 when not allocated
+ */
+static int64_t m_utf8_norm_segment(const uint8_t *str, size_t str_bytesize, m_utf8_norm_t form, uint32_t *local,
+                                   uint32_t **unicodes)
+{
+    size_t count;
+
+    *unicodes = local;
+    if (str_bytesize * 2 > M_UTF8_NORM_SEGMENT_SIZE)
+    {
+        *unicodes = malloc(str_bytesize * 2 * sizeof(uint32_t));
+        if (*unicodes == NULL)
+            return -1;
+    }
+    count = m_utf8_norm_decompose(str, str_bytesize, *unicodes);
+    if (form == M_UTF8_NORM_NFC)
+        count = m_utf8_norm_compose(*unicodes, count);
+    return (int64_t)count;
+}
+
+/**
+ * @public
+ * @fn int64_t m_utf8_mem_norm_quick_check(const m_char8_t *str, size_t str_bytesize, m_utf8_norm_t form)
+ * @brief byte size of the prefix of utf8 buffer which is surely normalized in form
+ * @param[in] str - utf8 buffer( null-terminated string is not needed)
+ * @param[in] str_bytesize - utf8 buffer byte size
+ * @param[in] form - M_UTF8_NORM_NFC or M_UTF8_NORM_NFD
+ * @return str_bytesize when quick check is Yes( UAX #15 9.1), or the offset of the segment which needs m_utf8_mem_normalize.
+ * @note
+ *   do not copy nor decompose, stops before the first invalid character.
+ *   less than str_bytesize does not always mean not normalized, use m_utf8_mem_is_normalized.
+ */
+int64_t m_utf8_mem_norm_quick_check(const m_char8_t *str, size_t str_bytesize, m_utf8_norm_t form)
+{
+    const uint8_t *ptr = (const uint8_t *)str;
+
+    M_UTF8_STATS_API(M_UTF8_STATS_NORMALIZE, str_bytesize);
+    size_t valid_size = (size_t)m_utf8_mem_valid_length(str, str_bytesize);
+    size_t stable;
+    size_t offset = m_utf8_norm_scan(&m_utf8_norm_checks[form], m_utf8_norm_block_size(), ptr, valid_size, 0, &stable);
+
+    return (int64_t)(offset == valid_size ? valid_size : stable);
+}
+
+/**
+ * @public
+ * @fn bool m_utf8_mem_is_normalized(const m_char8_t *str, size_t str_bytesize, m_utf8_norm_t form)
+ * @brief utf8 buffer is valid and normalized in form
+ * @param[in] str - utf8 buffer( null-terminated string is not needed)
+ * @param[in] str_bytesize - utf8 buffer byte size
+ * @param[in] form - M_UTF8_NORM_NFC or M_UTF8_NORM_NFD
+ * @return true when normalized, false when not normalized, invalid or memory is not allocated
+ * @note
+ *   only the segments which are not Yes in quick check are normalized and compared.
+ */
+bool m_utf8_mem_is_normalized(const m_char8_t *str, size_t str_bytesize, m_utf8_norm_t form)
+{
+    const uint8_t *ptr = (const uint8_t *)str;
+    const struct m_utf8_norm_check *check = &m_utf8_norm_checks[form];
+    size_t block_size = m_utf8_norm_block_size();
+    size_t offset = 0;
+
+    M_UTF8_STATS_API(M_UTF8_STATS_NORMALIZE, str_bytesize);
+    if ((size_t)m_utf8_mem_valid_length(str, str_bytesize) != str_bytesize)
+        return false;
+    while (true)
+    {
+        size_t stable;
+        offset = m_utf8_norm_scan(check, block_size, ptr, str_bytesize, offset, &stable);
+        if (offset == str_bytesize)
+            return true;
+
+        size_t end = m_utf8_norm_segment_end(check, ptr, str_bytesize, offset);
+        uint32_t local[M_UTF8_NORM_SEGMENT_SIZE];
+        uint32_t *unicodes;
+        int64_t count = m_utf8_norm_segment(ptr + stable, end - stable, form, local, &unicodes);
+        bool same = count >= 0;
+        size_t read = stable;
+        for (int64_t i = 0; same && i < count; i++)
+        {
+            uint8_t ch_byte_size;
+            same = read < end && m_utf8_norm_decode(ptr + read, &ch_byte_size) == unicodes[i];
+            read += ch_byte_size;
+        }
+        if (unicodes != local)
+            free(unicodes);
+        if (!same || read != end)
+            return false;
+        offset = end;
+    }
+}
+
+/**
+ * @public
+ * @fn bool m_utf8_mem_normalize(m_char8_t *dst, size_t dst_bytesize, const m_char8_t *src, size_t src_bytesize, m_utf8_norm_t form, m_utf8_conv_t *conv)
+ * @brief normalize utf8 buffer to NFC or NFD
+ * @param[out] dst - utf8 buffer
+ * @param[in] dst_bytesize - utf8 buffer byte size
+ * @param[in] src - utf8 buffer( null-terminated string is not needed)
+ * @param[in] src_bytesize - utf8 buffer byte size
+ * @param[in] form - M_UTF8_NORM_NFC or M_UTF8_NORM_NFD
+ * @param[out] conv - read size, written size and first invalid offset( NULL is ok)
+ * @return true when all of src is normalized, false when src is invalid, dst is full or memory is not allocated
+ * @note
+ *   do not write null-terminated string.
+ *   the text which is Yes in quick check is copied as is, only the other segments are decomposed.
+ *   stops before the first invalid character, or before a segment which does not fit in dst,
+ *   the rest can be normalized from conv->src_read.
+ *   src_bytesize * 3 is always enough for dst_bytesize.
+ */
+bool m_utf8_mem_normalize(m_char8_t *dst, size_t dst_bytesize, const m_char8_t *src, size_t src_bytesize,
+                          m_utf8_norm_t form, m_utf8_conv_t *conv)
+{
+    const uint8_t *ptr = (const uint8_t *)src;
+    uint8_t *out = (uint8_t *)dst;
+    const struct m_utf8_norm_check *check = &m_utf8_norm_checks[form];
+    size_t block_size = m_utf8_norm_block_size();
+
+    M_UTF8_STATS_API(M_UTF8_STATS_NORMALIZE, src_bytesize);
+    size_t valid_size = (size_t)m_utf8_mem_valid_length(src, src_bytesize);
+    size_t copied = 0; /* src is copied until here */
+    size_t offset = 0;
+    size_t written = 0;
+    bool result = valid_size == src_bytesize;
+
+    while (true)
+    {
+        size_t stable;
+        offset = m_utf8_norm_scan(check, block_size, ptr, valid_size, offset, &stable);
+        if (offset == valid_size)
+            stable = valid_size;
+
+        /* text before stable is normalized. */
+        size_t span = stable - copied;
+        if (span > dst_bytesize - written)
+        {
+            span = m_utf8_norm_stable_before(check, ptr, copied, copied + (dst_bytesize - written)) - copied;
+            memcpy(out + written, ptr + copied, span);
+            written += span;
+            copied += span;
+            result = false;
+            break;
+        }
+        memcpy(out + written, ptr + copied, span);
+        written += span;
+        copied = stable;
+        if (offset == valid_size)
+            break;
+
+        size_t end = m_utf8_norm_segment_end(check, ptr, valid_size, offset);
+        uint32_t local[M_UTF8_NORM_SEGMENT_SIZE];
+        uint32_t *unicodes;
+        int64_t count = m_utf8_norm_segment(ptr + stable, end - stable, form, local, &unicodes);
+        int64_t size = count >= 0 ? m_utf8_size_from_unicode(unicodes, (size_t)count) : -1;
+        if (size < 0 || (size_t)size > dst_bytesize - written)
+        {
+            if (unicodes != local)
+                free(unicodes);
+            result = false;
+            break;
+        }
+        for (int64_t i = 0; i < count; i++)
+            written += m_utf8_from_unicode(unicodes[i], (m_char8_t *)out + written);
+        if (unicodes != local)
+            free(unicodes);
+        copied = offset = end;
+    }
+
+    if (conv != NULL)
+    {
+        conv->src_read = (int64_t)copied;
+        conv->dst_written = (int64_t)written;
+        conv->error_offset = valid_size < src_bytesize ? (int64_t)valid_size : -1;
+    }
+    return result;
+}
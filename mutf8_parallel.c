@@ -0,0 +1,298 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "mutf8.h"
+
+#ifndef M_UTF8_PARALLEL_CHUNK_SIZE
+#define M_UTF8_PARALLEL_CHUNK_SIZE (1 << 20)
+#endif
+
+/**
+ * @private
+ * @enum m_utf8_parallel_mode
+ * @brief work of a chunk
+ */
+enum m_utf8_parallel_mode
+{
+    M_UTF8_PARALLEL_VALIDATE,
+    M_UTF8_PARALLEL_COUNT,
+    M_UTF8_PARALLEL_STAT,
+};
+
+/**
+ * @private
+ * @struct m_utf8_parallel_job
+ * @brief chunks shared by the workers
+ */
+struct m_utf8_parallel_job
+{
+    const m_char8_t *str;
+    size_t str_bytesize;
+    size_t chunk_count;
+    enum m_utf8_parallel_mode mode;
+    const m_utf8_width_profile_t *profile;
+    m_utf8_stat_t *results; /* result of each chunk, byte_size is the chunk start */
+    atomic_size_t next_chunk;
+    atomic_bool invalid; /* validate found an invalid chunk, the rest is skipped */
+};
+
+/**
+ * @private
+ * @fn static bool m_utf8_parallel_is_boundary(const uint8_t *str, size_t offset)
+ * @brief every character walk of the string has a character boundary at offset
+ * @note
+ *   offset is not a continuation byte( 10xxxxxx), and no character before offset
+ *   is longer than the distance to offset. an invalid character is skipped by
+ *   m_utf8_ch_byte_size too, so a chunk from offset is counted same as the serial walk.
+ */
+static bool m_utf8_parallel_is_boundary(const uint8_t *str, size_t offset)
+{
+    if ((str[offset] & 0xC0) == 0x80)
+    {
+        return false;
+    }
+    for (size_t back = 1; back <= 5 && back <= offset; back++)
+    {
+        if (m_utf8_ch_byte_size((const m_char8_t *)str + offset - back) > back)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @private
+ * @fn static size_t m_utf8_parallel_boundary(const struct m_utf8_parallel_job *job, size_t chunk)
+ * @brief start byte offset of the chunk
+ * @note
+ *   the nominal chunk start is moved forward to the next boundary,
+ *   so the neighbouring chunks agree on it without sharing anything.
+ */
+static size_t m_utf8_parallel_boundary(const struct m_utf8_parallel_job *job, size_t chunk)
+{
+    size_t offset = chunk * (size_t)M_UTF8_PARALLEL_CHUNK_SIZE;
+
+    if (offset >= job->str_bytesize)
+    {
+        return job->str_bytesize;
+    }
+    if (offset == 0)
+    {
+        return 0;
+    }
+    while (offset < job->str_bytesize && !m_utf8_parallel_is_boundary((const uint8_t *)job->str, offset))
+    {
+        offset++;
+    }
+    return offset;
+}
+
+/**
+ * @private
+ * @fn static void *m_utf8_parallel_worker(void *arg)
+ * @brief process chunks until none is left
+ */
+static void *m_utf8_parallel_worker(void *arg)
+{
+    struct m_utf8_parallel_job *job = arg;
+    size_t chunk;
+
+    while ((chunk = atomic_fetch_add(&job->next_chunk, 1)) < job->chunk_count)
+    {
+        m_utf8_stat_t *result = &job->results[chunk];
+        size_t start = m_utf8_parallel_boundary(job, chunk);
+        size_t end = m_utf8_parallel_boundary(job, chunk + 1);
+        const m_char8_t *ptr = job->str + start;
+        size_t size = end > start ? end - start : 0;
+
+        result->byte_size = (int64_t)start;
+        result->char_count = 0;
+        result->display_width = 0;
+        result->error_offset = -1;
+        switch (job->mode)
+        {
+        case M_UTF8_PARALLEL_VALIDATE:
+            if (atomic_load(&job->invalid) == false && m_utf8_mem_validate(ptr, size) == false)
+            {
+                result->error_offset = 0;
+                atomic_store(&job->invalid, true);
+            }
+            break;
+        case M_UTF8_PARALLEL_COUNT:
+            result->char_count = m_utf8_mem_display_count(ptr, size);
+            break;
+        case M_UTF8_PARALLEL_STAT:
+        {
+            int64_t start_offset = result->byte_size;
+            m_utf8_mem_stat(ptr, size, job->profile, result);
+            result->byte_size = start_offset;
+            break;
+        }
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @private
+ * @fn static bool m_utf8_parallel_run(struct m_utf8_parallel_job *job, unsigned int threads, m_utf8_stat_t *stat)
+ * @brief run the job on worker threads, and combine the chunk results in order
+ * @return false when the job could not start, the caller falls back to the serial function.
+ */
+static bool m_utf8_parallel_run(struct m_utf8_parallel_job *job, unsigned int threads, m_utf8_stat_t *stat)
+{
+    if (threads == 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (unsigned int)cpus : 1;
+    }
+    job->chunk_count = (job->str_bytesize + M_UTF8_PARALLEL_CHUNK_SIZE - 1) / M_UTF8_PARALLEL_CHUNK_SIZE;
+    if (threads > job->chunk_count)
+    {
+        threads = (unsigned int)job->chunk_count;
+    }
+    if (threads <= 1)
+    {
+        return false;
+    }
+
+    pthread_t *workers = malloc(sizeof(pthread_t) * (threads - 1));
+    job->results = malloc(sizeof(m_utf8_stat_t) * job->chunk_count);
+    if (workers == NULL || job->results == NULL)
+    {
+        free(workers);
+        free(job->results);
+        return false;
+    }
+    atomic_init(&job->next_chunk, 0);
+    atomic_init(&job->invalid, false);
+
+    /* the calling thread is a worker too. */
+    unsigned int started = 0;
+    while (started < threads - 1 && pthread_create(&workers[started], NULL, m_utf8_parallel_worker, job) == 0)
+    {
+        started++;
+    }
+    m_utf8_parallel_worker(job);
+    for (unsigned int i = 0; i < started; i++)
+    {
+        pthread_join(workers[i], NULL);
+    }
+
+    stat->byte_size = (int64_t)job->str_bytesize;
+    stat->char_count = 0;
+    stat->display_width = 0;
+    stat->error_offset = -1;
+    for (size_t chunk = 0; chunk < job->chunk_count; chunk++)
+    {
+        const m_utf8_stat_t *result = &job->results[chunk];
+        stat->char_count += result->char_count;
+        stat->display_width += result->display_width;
+        if (stat->error_offset < 0 && result->error_offset >= 0)
+        {
+            stat->error_offset = result->byte_size + result->error_offset;
+        }
+    }
+
+    free(workers);
+    free(job->results);
+    return true;
+}
+
+/**
+ * @public
+ * @fn bool m_utf8_mem_validate_parallel(const m_char8_t *str, size_t str_bytesize, unsigned int threads)
+ * @brief utf8 buffer validate on threads
+ * @param[in] str - utf8 buffer( null-terminated string is not needed)
+ * @param[in] str_bytesize - utf8 buffer byte size
+ * @param[in] threads - thread count, 0 is the online CPU count
+ * @return same as m_utf8_mem_validate
+ * @note
+ *   the buffer is split into M_UTF8_PARALLEL_CHUNK_SIZE chunks at character boundaries.
+ *   a small buffer is validated on the calling thread.
+ */
+bool m_utf8_mem_validate_parallel(const m_char8_t *str, size_t str_bytesize, unsigned int threads)
+{
+    struct m_utf8_parallel_job job = {.str = str, .str_bytesize = str_bytesize, .mode = M_UTF8_PARALLEL_VALIDATE};
+    m_utf8_stat_t stat;
+
+    if (m_utf8_parallel_run(&job, threads, &stat) == false)
+    {
+        return m_utf8_mem_validate(str, str_bytesize);
+    }
+    return stat.error_offset < 0;
+}
+
+/**
+ * @public
+ * @fn int64_t m_utf8_mem_display_count_parallel(const m_char8_t *str, size_t str_bytesize, unsigned int threads)
+ * @brief utf8 buffer display character count on threads
+ * @param[in] str - utf8 buffer( null-terminated string is not needed)
+ * @param[in] str_bytesize - utf8 buffer byte size
+ * @param[in] threads - thread count, 0 is the online CPU count
+ * @return same as m_utf8_mem_display_count
+ */
+int64_t m_utf8_mem_display_count_parallel(const m_char8_t *str, size_t str_bytesize, unsigned int threads)
+{
+    struct m_utf8_parallel_job job = {.str = str, .str_bytesize = str_bytesize, .mode = M_UTF8_PARALLEL_COUNT};
+    m_utf8_stat_t stat;
+
+    if (m_utf8_parallel_run(&job, threads, &stat) == false)
+    {
+        return m_utf8_mem_display_count(str, str_bytesize);
+    }
+    return stat.char_count;
+}
+
+/**
+ * @public
+ * @fn bool m_utf8_mem_stat_parallel(const m_char8_t *str, size_t str_bytesize, const m_utf8_width_profile_t *profile, m_utf8_stat_t *stat, unsigned int threads)
+ * @brief utf8 buffer character count, display width and first error on threads
+ * @param[in] str - utf8 buffer( null-terminated string is not needed)
+ * @param[in] str_bytesize - utf8 buffer byte size
+ * @param[in] profile - width profile, NULL is same as m_utf8_display_width
+ * @param[out] stat - same as m_utf8_mem_stat
+ * @param[in] threads - thread count, 0 is the online CPU count
+ * @return same as m_utf8_mem_stat
+ */
+bool m_utf8_mem_stat_parallel(const m_char8_t *str, size_t str_bytesize, const m_utf8_width_profile_t *profile,
+                              m_utf8_stat_t *stat, unsigned int threads)
+{
+    struct m_utf8_parallel_job job = {
+        .str = str, .str_bytesize = str_bytesize, .mode = M_UTF8_PARALLEL_STAT, .profile = profile};
+
+    if (m_utf8_parallel_run(&job, threads, stat) == false)
+    {
+        return m_utf8_mem_stat(str, str_bytesize, profile, stat);
+    }
+    return stat->error_offset < 0;
+}
+
+/**
+ * @public
+ * @fn bool m_utf8_str_validate_parallel(const m_char8_t *str, size_t max_str_bytesize, unsigned int threads)
+ * @brief utf8 string validate on threads
+ * @param[in] str - utf8 string
+ * @param[in] max_str_bytesize - utf8 string byte size( add null-terminated string size)
+ * @param[in] threads - thread count, 0 is the online CPU count
+ * @return same as m_utf8_str_validate
+ * @note
+ *   add null-terminated string size.
+ */
+bool m_utf8_str_validate_parallel(const m_char8_t *str, size_t max_str_bytesize, unsigned int threads)
+{
+    const m_char8_t *end = memchr(str, '\0', max_str_bytesize);
+
+    if (end == NULL)
+    {
+        return false;
+    }
+    return m_utf8_mem_validate_parallel(str, (size_t)(end - str), threads);
+}
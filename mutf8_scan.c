@@ -0,0 +1,380 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "mutf8.h"
+
+#define SCAN_CHUNK_SIZE ((size_t)1 << 20)
+
+/*
+ * usage: ./mutf8-scan [-j threads] [-n] file...
+ *
+ *   -j threads - files scanned at once( default the online CPU count)
+ *   -n         - East Asian ambiguous characters are 1 column( default 2)
+ *
+ * each file is memory-mapped and read in chunks of whole lines,
+ * a file which is not a regular file( pipe, /dev/stdin) is read into memory first.
+ * one tab separated row per file, in the order of the arguments:
+ *   valid, first error offset( -1 when none), bytes, characters, columns, lines,
+ *   columns of the longest line( not include "\n" and "\r\n") and MB/s.
+ * exit status is 0 when every file is valid, 1 when a file is invalid, 2 when a file is not read.
+ */
+
+/**
+ * @private
+ * @struct scan_result
+ * @brief result of a file
+ */
+struct scan_result
+{
+    const char *path;
+    int error;          /* errno when the file is not read, 0 when read */
+    m_utf8_stat_t stat; /* byte size, characters, columns and first error of the file */
+    int64_t lines;
+    int64_t longest;    /* columns of the longest line */
+    double seconds;
+    bool done;
+};
+
+/**
+ * @private
+ * @struct scan_job
+ * @brief files shared by the workers
+ */
+struct scan_job
+{
+    struct scan_result *results;
+    size_t file_count;
+    const m_utf8_width_profile_t *profile;
+    atomic_size_t next_file;
+    pthread_mutex_t lock; /* done of results */
+    pthread_cond_t done;
+};
+
+static double scan_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @private
+ * @fn static void scan_lines(const m_char8_t *str, size_t str_bytesize, const m_utf8_width_profile_t *profile, struct scan_result *result)
+ * @brief count lines, and find the longest line
+ * @note
+ *   columns of a line are not more than its byte size,
+ *   so only the lines longer than the longest one so far are decoded.
+ */
+static void scan_lines(const m_char8_t *str, size_t str_bytesize, const m_utf8_width_profile_t *profile,
+                       struct scan_result *result)
+{
+    size_t offset = 0;
+
+    while (offset < str_bytesize)
+    {
+        const m_char8_t *newline = memchr(str + offset, '\n', str_bytesize - offset);
+        size_t end = newline != NULL ? (size_t)(newline - str) : str_bytesize;
+        size_t line_bytesize = end - offset;
+
+        if (newline != NULL && line_bytesize > 0 && str[end - 1] == '\r')
+            line_bytesize--;
+        if ((int64_t)line_bytesize > result->longest)
+        {
+            m_utf8_stat_t line;
+            m_utf8_mem_stat(str + offset, line_bytesize, profile, &line);
+            if (result->longest < line.display_width)
+                result->longest = line.display_width;
+        }
+        result->lines++;
+        offset = newline != NULL ? end + 1 : end;
+    }
+}
+
+/**
+ * @private
+ * @fn static void scan_buffer(const m_char8_t *str, size_t str_bytesize, const m_utf8_width_profile_t *profile, struct scan_result *result)
+ * @brief stat the buffer and its lines, by chunks of whole lines
+ * @note
+ *   a chunk is read twice( stat and lines) while it is in the cache.
+ *   a chunk ends after '\n', so an invalid character does not cross chunks.
+ */
+static void scan_buffer(const m_char8_t *str, size_t str_bytesize, const m_utf8_width_profile_t *profile,
+                        struct scan_result *result)
+{
+    m_utf8_stat_t *stat = &result->stat;
+    size_t offset = 0;
+
+    stat->byte_size = (int64_t)str_bytesize;
+    stat->char_count = 0;
+    stat->display_width = 0;
+    stat->error_offset = -1;
+    result->lines = 0;
+    result->longest = 0;
+
+    while (offset < str_bytesize)
+    {
+        size_t end = str_bytesize;
+        if (str_bytesize - offset > SCAN_CHUNK_SIZE)
+        {
+            const m_char8_t *newline =
+                memchr(str + offset + SCAN_CHUNK_SIZE, '\n', str_bytesize - offset - SCAN_CHUNK_SIZE);
+            if (newline != NULL)
+                end = (size_t)(newline - str) + 1;
+        }
+
+        m_utf8_stat_t chunk;
+        m_utf8_mem_stat(str + offset, end - offset, profile, &chunk);
+        stat->char_count += chunk.char_count;
+        stat->display_width += chunk.display_width;
+        if (stat->error_offset < 0 && chunk.error_offset >= 0)
+            stat->error_offset = (int64_t)offset + chunk.error_offset;
+        scan_lines(str + offset, end - offset, profile, result);
+        offset = end;
+    }
+}
+
+/**
+ * @private
+ * @fn static m_char8_t *scan_read(int fd, size_t *size)
+ * @brief read a file which is not mapped( pipe, terminal, /dev/stdin) to the end
+ * @return allocated buffer( free by the caller), NULL and errno when failed
+ */
+static m_char8_t *scan_read(int fd, size_t *size)
+{
+    size_t capacity = SCAN_CHUNK_SIZE;
+    m_char8_t *buffer = malloc(capacity);
+
+    *size = 0;
+    while (buffer != NULL)
+    {
+        if (*size == capacity)
+        {
+            m_char8_t *grown = capacity <= SIZE_MAX / 2 ? realloc(buffer, capacity * 2) : NULL;
+            if (grown == NULL)
+            {
+                free(buffer);
+                errno = ENOMEM;
+                return NULL;
+            }
+            buffer = grown;
+            capacity *= 2;
+        }
+
+        ssize_t n = read(fd, buffer + *size, capacity - *size);
+        if (n > 0)
+        {
+            *size += (size_t)n;
+        }
+        else if (n == 0)
+        {
+            return buffer;
+        }
+        else if (errno != EINTR)
+        {
+            int error = errno;
+            free(buffer);
+            errno = error;
+            return NULL;
+        }
+    }
+    errno = ENOMEM;
+    return NULL;
+}
+
+/**
+ * @private
+ * @fn static void scan_file(struct scan_result *result, const m_utf8_width_profile_t *profile)
+ * @brief map the file, and scan it
+ * @note
+ *   a file which is not a regular file is read to the end instead.
+ */
+static void scan_file(struct scan_result *result, const m_utf8_width_profile_t *profile)
+{
+    double start = scan_now();
+    struct stat st;
+    int fd = open(result->path, O_RDONLY);
+
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        result->error = errno;
+        if (fd >= 0)
+            close(fd);
+        return;
+    }
+
+    size_t size = (size_t)st.st_size;
+    if (!S_ISREG(st.st_mode))
+    {
+        /* st_size is not the byte size of a pipe, read it. */
+        m_char8_t *buffer = scan_read(fd, &size);
+        if (buffer == NULL)
+        {
+            result->error = errno;
+            close(fd);
+            return;
+        }
+        scan_buffer(buffer, size, profile, result);
+        free(buffer);
+    }
+    else if (size == 0)
+    {
+        scan_buffer("", 0, profile, result);
+    }
+    else
+    {
+        void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED)
+        {
+            result->error = errno;
+            close(fd);
+            return;
+        }
+        /* read once from the start, the kernel reads ahead and drops the pages behind. */
+        madvise(map, size, MADV_SEQUENTIAL);
+        scan_buffer(map, size, profile, result);
+        munmap(map, size);
+    }
+    close(fd);
+    result->seconds = scan_now() - start;
+}
+
+/**
+ * @private
+ * @fn static void *scan_worker(void *arg)
+ * @brief scan files until none is left
+ */
+static void *scan_worker(void *arg)
+{
+    struct scan_job *job = arg;
+    size_t file;
+
+    while ((file = atomic_fetch_add(&job->next_file, 1)) < job->file_count)
+    {
+        scan_file(&job->results[file], job->profile);
+
+        pthread_mutex_lock(&job->lock);
+        job->results[file].done = true;
+        pthread_cond_broadcast(&job->done);
+        pthread_mutex_unlock(&job->lock);
+    }
+    return NULL;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: mutf8-scan [-j threads] [-n] file...\n");
+}
+
+int main(int argc, char *argv[])
+{
+    long threads = 0;
+    bool ambiguous_wide = true;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "j:nh")) != -1)
+    {
+        switch (opt)
+        {
+        case 'j':
+            threads = strtol(optarg, NULL, 10);
+            break;
+        case 'n':
+            ambiguous_wide = false;
+            break;
+        default:
+            usage();
+            return 2;
+        }
+    }
+    if (optind >= argc)
+    {
+        usage();
+        return 2;
+    }
+
+    struct scan_job job;
+    job.file_count = (size_t)(argc - optind);
+    job.results = calloc(job.file_count, sizeof(struct scan_result));
+    job.profile = m_utf8_width_profile(ambiguous_wide, true);
+    if (job.results == NULL)
+    {
+        perror("mutf8-scan");
+        return 2;
+    }
+    for (size_t i = 0; i < job.file_count; i++)
+        job.results[i].path = argv[optind + (int)i];
+    atomic_init(&job.next_file, 0);
+    pthread_mutex_init(&job.lock, NULL);
+    pthread_cond_init(&job.done, NULL);
+
+    if (threads <= 0)
+    {
+        threads = sysconf(_SC_NPROCESSORS_ONLN);
+        if (threads <= 0)
+            threads = 1;
+    }
+    if ((size_t)threads > job.file_count)
+        threads = (long)job.file_count;
+
+    double start = scan_now();
+    pthread_t *workers = malloc(sizeof(pthread_t) * (size_t)threads);
+    long started = 0;
+    while (workers != NULL && started < threads && pthread_create(&workers[started], NULL, scan_worker, &job) == 0)
+        started++;
+    if (started == 0)
+        scan_worker(&job);
+
+    /* print in the order of the arguments, while the rest is scanned. */
+    int status = 0;
+    int64_t total_bytes = 0;
+    printf("file\tvalid\terror_offset\tbytes\tchars\tcolumns\tlines\tlongest\tMB/s\n");
+    for (size_t i = 0; i < job.file_count; i++)
+    {
+        struct scan_result *result = &job.results[i];
+
+        pthread_mutex_lock(&job.lock);
+        while (!result->done)
+            pthread_cond_wait(&job.done, &job.lock);
+        pthread_mutex_unlock(&job.lock);
+
+        if (result->error != 0)
+        {
+            fprintf(stderr, "mutf8-scan: %s: %s\n", result->path, strerror(result->error));
+            status = 2;
+            continue;
+        }
+        bool valid = result->stat.error_offset < 0;
+        if (!valid && status == 0)
+            status = 1;
+        total_bytes += result->stat.byte_size;
+        printf("%s\t%s\t%lld\t%lld\t%lld\t%lld\t%lld\t%lld\t%.1f\n", result->path, valid ? "valid" : "invalid",
+               (long long)result->stat.error_offset, (long long)result->stat.byte_size,
+               (long long)result->stat.char_count, (long long)result->stat.display_width, (long long)result->lines,
+               (long long)result->longest,
+               result->seconds > 0 ? (double)result->stat.byte_size / result->seconds / 1e6 : 0.0);
+    }
+    for (long i = 0; i < started; i++)
+        pthread_join(workers[i], NULL);
+
+    double seconds = scan_now() - start;
+    if (job.file_count > 1)
+        fprintf(stderr, "mutf8-scan: %zu files, %lld bytes, %.1f MB/s, %ld threads\n", job.file_count,
+                (long long)total_bytes, seconds > 0 ? (double)total_bytes / seconds / 1e6 : 0.0, threads);
+
+    free(workers);
+    free(job.results);
+    pthread_mutex_destroy(&job.lock);
+    pthread_cond_destroy(&job.done);
+    return status;
+}
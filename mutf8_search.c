@@ -0,0 +1,677 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#if defined(__GNUC__)
+#define M_UTF8_SEARCH_AVX2
+#endif
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* the candidates are decoded character by character, inline the primitives. */
+#define M_UTF8_INLINE
+#include "mutf8.h"
+#include "mutf8_fold_table.h"
+#include "mutf8_stats.h"
+
+/* bytes of the code points folded to the same one, 4 at most( see tools/mkfold.py). */
+#define M_UTF8_SEARCH_PROBE_BYTES 4
+
+/* probes of a pattern, the first character and 2 characters at most. */
+#define M_UTF8_SEARCH_PROBE_COUNT 3
+
+/* probes are taken from the characters in the first bytes of the pattern. */
+#ifndef M_UTF8_SEARCH_PROBE_SPAN
+#define M_UTF8_SEARCH_PROBE_SPAN 64
+#endif
+
+/**
+ * @private
+ * @struct m_utf8_search_probe
+ * @brief bytes which every match has at offset from its start
+ */
+struct m_utf8_search_probe
+{
+    size_t offset;
+    uint8_t bytes[M_UTF8_SEARCH_PROBE_BYTES]; /* padded with bytes[0] */
+    uint8_t count;
+    uint8_t case_bit;  /* 0x20 when bytes[0] is both cases of an ascii letter, OR-ed before the compare */
+    bool continuation; /* a continuation byte is also a candidate */
+};
+
+/**
+ * @private
+ * @struct m_utf8_search_pattern
+ * @brief pattern, and its probes
+ * @note
+ *   an offset where every probe is found is a candidate. the probes are tested for a block of offsets at once,
+ *   and the candidates are verified one by one.
+ *   probes[0] is the lead bytes of the first character, the others are the last bytes of the characters.
+ */
+struct m_utf8_search_pattern
+{
+    const uint8_t *pattern;
+    size_t pattern_bytesize;
+    bool ignore_case;
+    struct m_utf8_search_probe probes[M_UTF8_SEARCH_PROBE_COUNT]; /* padded with probes[0] */
+    size_t probe_span; /* the largest offset of the probes */
+    bool single;       /* every probe is a byte, or an ascii letter of both cases */
+};
+
+/**
+ * @private
+ * @fn static inline uint8_t m_utf8_search_fold_ascii(uint8_t c)
+ * @brief simple case folding of an ascii byte
+ */
+static inline uint8_t m_utf8_search_fold_ascii(uint8_t c)
+{
+    return (uint8_t)(c - 'A') < 26 ? (uint8_t)(c | 0x20) : c;
+}
+
+/**
+ * @public
+ * @fn uint32_t m_utf8_unicode_fold(uint32_t unicode)
+ * @brief simple case folding of unicode( CaseFolding.txt C and S)
+ * @param[in] unicode - unicode code point
+ * @return folded code point, unicode itself when it is not folded
+ * @note
+ *   'K' and U+212A KELVIN SIGN are folded to 'k', U+1E9E is folded to U+00DF.
+ *   the full folding( U+00DF to "ss") is not done, a code point is folded to a code point.
+ */
+uint32_t m_utf8_unicode_fold(uint32_t unicode)
+{
+    if (unicode < 0x80)
+        return m_utf8_search_fold_ascii((uint8_t)unicode);
+    if (unicode > 0x10FFFF)
+        return unicode;
+    return (uint32_t)((int32_t)unicode +
+                      m_utf8_fold_delta[m_utf8_fold_stage2[(uint32_t)m_utf8_fold_stage1[unicode >> M_UTF8_FOLD_SHIFT]
+                                                               << M_UTF8_FOLD_SHIFT |
+                                                           (unicode & M_UTF8_FOLD_MASK)]]);
+}
+
+/**
+ * @private
+ * @fn static void m_utf8_search_add_byte(struct m_utf8_search_probe *probe, uint8_t c)
+ * @brief add c to the probe, when it is not in the probe
+ */
+static void m_utf8_search_add_byte(struct m_utf8_search_probe *probe, uint8_t c)
+{
+    uint8_t i = 0;
+
+    while (i < probe->count && probe->bytes[i] != c)
+        i++;
+    if (i == probe->count)
+        probe->bytes[probe->count++] = c;
+}
+
+/**
+ * @private
+ * @fn static void m_utf8_search_add_unicode(uint32_t unicode, struct m_utf8_search_probe *lead, struct m_utf8_search_probe *last, uint8_t *min_bytesize, uint8_t *max_bytesize)
+ * @brief add the lead byte and the last byte of unicode to the probes
+ */
+static void m_utf8_search_add_unicode(uint32_t unicode, struct m_utf8_search_probe *lead,
+                                      struct m_utf8_search_probe *last, uint8_t *min_bytesize, uint8_t *max_bytesize)
+{
+    m_char8_t character[4];
+    uint8_t ch_byte_size = m_utf8_from_unicode(unicode, character);
+
+    m_utf8_search_add_byte(lead, (uint8_t)character[0]);
+    m_utf8_search_add_byte(last, (uint8_t)character[ch_byte_size - 1]);
+    if (*min_bytesize > ch_byte_size)
+        *min_bytesize = ch_byte_size;
+    if (*max_bytesize < ch_byte_size)
+        *max_bytesize = ch_byte_size;
+}
+
+/**
+ * @private
+ * @fn static void m_utf8_search_variants(uint32_t unicode, bool ignore_case, struct m_utf8_search_probe *lead, struct m_utf8_search_probe *last, uint8_t *min_bytesize, uint8_t *max_bytesize)
+ * @brief lead bytes and last bytes of the code points which match unicode
+ * @param[in] unicode - unicode code point
+ * @param[in] ignore_case - the code points folded to the same one match
+ * @param[out] lead - lead bytes, the offset is not set
+ * @param[out] last - last bytes, the offset is not set
+ * @param[out] min_bytesize - byte size of the shortest code point
+ * @param[out] max_bytesize - byte size of the longest code point
+ */
+static void m_utf8_search_variants(uint32_t unicode, bool ignore_case, struct m_utf8_search_probe *lead,
+                                   struct m_utf8_search_probe *last, uint8_t *min_bytesize, uint8_t *max_bytesize)
+{
+    const size_t unfold_size = sizeof(m_utf8_fold_unfold) / sizeof(m_utf8_fold_unfold[0]);
+
+    lead->count = 0;
+    lead->continuation = false;
+    last->count = 0;
+    last->continuation = false;
+    *min_bytesize = 4;
+    *max_bytesize = 1;
+    if (!ignore_case)
+    {
+        m_utf8_search_add_unicode(unicode, lead, last, min_bytesize, max_bytesize);
+        return;
+    }
+
+    uint32_t folded = m_utf8_unicode_fold(unicode);
+    size_t low = 0;
+    size_t high = unfold_size;
+    while (low < high)
+    {
+        size_t middle = (low + high) / 2;
+        if (m_utf8_fold_unfold[middle].folded < folded)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    /* folded itself, then the code points folded to it. */
+    m_utf8_search_add_unicode(folded, lead, last, min_bytesize, max_bytesize);
+    for (; low < unfold_size && m_utf8_fold_unfold[low].folded == folded; low++)
+        m_utf8_search_add_unicode(m_utf8_fold_unfold[low].unicode, lead, last, min_bytesize, max_bytesize);
+}
+
+/**
+ * @private
+ * @fn static bool m_utf8_search_init(struct m_utf8_search_pattern *pattern, const m_char8_t *str, size_t str_bytesize, m_utf8_search_t search)
+ * @brief make the pattern and its probes
+ * @return true when the pattern is valid and not empty
+ * @note
+ *   the probes are the lead bytes of the first character, the last bytes of the last character and of the middle one,
+ *   while every character matches a fixed byte size. when the first character does not( 'k' and U+212A),
+ *   the lead bytes of the second character, or a continuation byte of the longer first character.
+ */
+static bool m_utf8_search_init(struct m_utf8_search_pattern *pattern, const m_char8_t *str, size_t str_bytesize,
+                               m_utf8_search_t search)
+{
+    struct m_utf8_search_probe lasts[M_UTF8_SEARCH_PROBE_SPAN + 1];
+    struct m_utf8_search_probe lead;
+    size_t last_count = 0;
+    size_t offset = 0;
+
+    if (str == NULL || str_bytesize == 0 || !m_utf8_mem_validate(str, str_bytesize))
+        return false;
+
+    pattern->pattern = (const uint8_t *)str;
+    pattern->pattern_bytesize = str_bytesize;
+    pattern->ignore_case = search == M_UTF8_SEARCH_IGNORE_CASE;
+    while (offset < str_bytesize && offset < M_UTF8_SEARCH_PROBE_SPAN)
+    {
+        uint32_t unicode = 0;
+        uint8_t min_bytesize, max_bytesize;
+        uint8_t ch_byte_size = m_utf8_ch_next(str + offset, str_bytesize - offset, &unicode, NULL);
+
+        m_utf8_search_variants(unicode, pattern->ignore_case, &lead, &lasts[last_count], &min_bytesize,
+                               &max_bytesize);
+        if (offset == 0)
+        {
+            pattern->probes[0] = lead;
+            pattern->probes[0].offset = 0;
+        }
+        if (min_bytesize != max_bytesize)
+        {
+            if (offset == 0 && ch_byte_size < str_bytesize)
+            {
+                /* the second character at the shorter size, a continuation byte at the longer size. */
+                m_utf8_ch_next(str + ch_byte_size, str_bytesize - ch_byte_size, &unicode, NULL);
+                m_utf8_search_variants(unicode, pattern->ignore_case, &lasts[0], &lead, &min_bytesize, &max_bytesize);
+                lasts[0].offset = min_bytesize;
+                lasts[0].continuation = true;
+                last_count = 1;
+            }
+            break;
+        }
+        lasts[last_count].offset = offset + max_bytesize - 1;
+        if (lasts[last_count].offset > 0)
+            last_count++;
+        offset += max_bytesize;
+    }
+
+    /* the last character, then the middle one. */
+    uint8_t probe_count = 1;
+    if (last_count > 0)
+        pattern->probes[probe_count++] = lasts[last_count - 1];
+    if (last_count > 1)
+        pattern->probes[probe_count++] = lasts[(last_count - 1) / 2];
+    pattern->probe_span = probe_count > 1 ? pattern->probes[1].offset : 0;
+    pattern->single = true;
+    for (uint8_t i = 0; i < M_UTF8_SEARCH_PROBE_COUNT; i++)
+    {
+        struct m_utf8_search_probe *probe = &pattern->probes[i];
+        if (i >= probe_count)
+        {
+            *probe = pattern->probes[0];
+            continue;
+        }
+        probe->case_bit = 0;
+        if (probe->count == 2 && (probe->bytes[0] ^ probe->bytes[1]) == 0x20 && probe->bytes[0] < 0x80)
+        {
+            probe->bytes[0] |= 0x20;
+            probe->count = 1;
+            probe->case_bit = 0x20;
+        }
+        for (uint8_t j = probe->count; j < M_UTF8_SEARCH_PROBE_BYTES; j++)
+            probe->bytes[j] = probe->bytes[0];
+        if (probe->count > 1 || probe->continuation)
+            pattern->single = false;
+    }
+    return true;
+}
+
+/**
+ * @private
+ * @fn static size_t m_utf8_search_match(const struct m_utf8_search_pattern *pattern, const uint8_t *str, size_t str_bytesize, size_t offset)
+ * @brief byte size of the match at offset, 0 when not matched
+ */
+static size_t m_utf8_search_match(const struct m_utf8_search_pattern *pattern, const uint8_t *str,
+                                  size_t str_bytesize, size_t offset)
+{
+    const uint8_t *pattern_str = pattern->pattern;
+    size_t pattern_bytesize = pattern->pattern_bytesize;
+
+    if (!pattern->ignore_case)
+    {
+        if (str_bytesize - offset < pattern_bytesize || memcmp(str + offset, pattern_str, pattern_bytesize) != 0)
+            return 0;
+        return pattern_bytesize;
+    }
+
+    size_t pattern_offset = 0;
+    size_t str_offset = offset;
+    while (pattern_offset < pattern_bytesize)
+    {
+        if (str_offset >= str_bytesize)
+            return 0;
+        if ((pattern_str[pattern_offset] | str[str_offset]) < 0x80)
+        {
+            if (m_utf8_search_fold_ascii(pattern_str[pattern_offset]) != m_utf8_search_fold_ascii(str[str_offset]))
+                return 0;
+            pattern_offset++;
+            str_offset++;
+            continue;
+        }
+
+        uint32_t pattern_unicode = 0, unicode = 0;
+        bool valid;
+        pattern_offset += m_utf8_ch_next((const m_char8_t *)pattern_str + pattern_offset,
+                                         pattern_bytesize - pattern_offset, &pattern_unicode, NULL);
+        str_offset += m_utf8_ch_next((const m_char8_t *)str + str_offset, str_bytesize - str_offset, &unicode, &valid);
+        if (!valid || m_utf8_unicode_fold(pattern_unicode) != m_utf8_unicode_fold(unicode))
+            return 0;
+    }
+    return str_offset - offset;
+}
+
+/**
+ * @private
+ * @fn static inline bool m_utf8_search_is_first(const struct m_utf8_search_pattern *pattern, uint8_t c)
+ * @brief c is a lead byte of the first character of the pattern
+ */
+static inline bool m_utf8_search_is_first(const struct m_utf8_search_pattern *pattern, uint8_t c)
+{
+    const struct m_utf8_search_probe *probe = &pattern->probes[0];
+
+    for (uint8_t i = 0; i < probe->count; i++)
+    {
+        if (probe->bytes[i] == (c | probe->case_bit))
+            return true;
+    }
+    return false;
+}
+
+#if defined(M_UTF8_SEARCH_AVX2)
+/**
+ * @private
+ * @fn static inline __m256i m_utf8_search_equal_avx2(const struct m_utf8_search_probe *probe, __m256i bytes)
+ * @brief test 32 bytes by a probe of more than one byte or of the leads of a continuation
+ * @return 0xFF of the byte which is one of the probe bytes
+ */
+__attribute__((target("avx2"))) static inline __m256i m_utf8_search_equal_avx2(const struct m_utf8_search_probe *probe, __m256i bytes)
+{
+    /* signed 0xC0 is over 0x80 to 0xBF */
+    __m256i equal = probe->continuation ? _mm256_cmpgt_epi8(_mm256_set1_epi8((char)0xC0), bytes) : _mm256_setzero_si256();
+    equal = _mm256_or_si256(equal, _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8((char)probe->bytes[0])));
+    equal = _mm256_or_si256(equal, _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8((char)probe->bytes[1])));
+    equal = _mm256_or_si256(equal, _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8((char)probe->bytes[2])));
+    return _mm256_or_si256(equal, _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8((char)probe->bytes[3])));
+}
+
+/**
+ * @private
+ * @fn static size_t m_utf8_search_block_avx2(const struct m_utf8_search_pattern *pattern, const uint8_t *str, size_t str_bytesize, size_t offset, uint32_t *hits)
+ * @brief skip blocks of 32 offsets without a candidate
+ * @param[out] hits - bit of the candidate in the block, 0 when the rest is shorter than a block and the probe span
+ * @return offset of the block
+ */
+__attribute__((target("avx2"))) static size_t m_utf8_search_block_avx2(const struct m_utf8_search_pattern *pattern, const uint8_t *str,
+                                                                       size_t str_bytesize, size_t offset, uint32_t *hits)
+{
+    const struct m_utf8_search_probe *probes = pattern->probes;
+    const __m256i case_bit0 = _mm256_set1_epi8((char)probes[0].case_bit);
+    const __m256i case_bit1 = _mm256_set1_epi8((char)probes[1].case_bit);
+    const __m256i case_bit2 = _mm256_set1_epi8((char)probes[2].case_bit);
+
+    if (pattern->single)
+    {
+        /* one byte of each probe, the loop of most patterns */
+        const __m256i byte0 = _mm256_set1_epi8((char)probes[0].bytes[0]);
+        const __m256i byte1 = _mm256_set1_epi8((char)probes[1].bytes[0]);
+        const __m256i byte2 = _mm256_set1_epi8((char)probes[2].bytes[0]);
+        for (; str_bytesize - offset >= 32 + pattern->probe_span; offset += 32)
+        {
+            const uint8_t *block = str + offset;
+            __m256i bytes0 = _mm256_or_si256(_mm256_loadu_si256((const __m256i *)(block + probes[0].offset)), case_bit0);
+            __m256i bytes1 = _mm256_or_si256(_mm256_loadu_si256((const __m256i *)(block + probes[1].offset)), case_bit1);
+            __m256i bytes2 = _mm256_or_si256(_mm256_loadu_si256((const __m256i *)(block + probes[2].offset)), case_bit2);
+            __m256i candidate = _mm256_and_si256(_mm256_cmpeq_epi8(bytes0, byte0), _mm256_cmpeq_epi8(bytes1, byte1));
+            uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(candidate, _mm256_cmpeq_epi8(bytes2, byte2)));
+            if (mask != 0)
+            {
+                *hits = mask;
+                return offset;
+            }
+        }
+        *hits = 0;
+        return offset;
+    }
+
+    for (; str_bytesize - offset >= 32 + pattern->probe_span; offset += 32)
+    {
+        const uint8_t *block = str + offset;
+        __m256i bytes0 = _mm256_or_si256(_mm256_loadu_si256((const __m256i *)(block + probes[0].offset)), case_bit0);
+        __m256i bytes1 = _mm256_or_si256(_mm256_loadu_si256((const __m256i *)(block + probes[1].offset)), case_bit1);
+        __m256i bytes2 = _mm256_or_si256(_mm256_loadu_si256((const __m256i *)(block + probes[2].offset)), case_bit2);
+        __m256i candidate = _mm256_and_si256(m_utf8_search_equal_avx2(&probes[0], bytes0),
+                                             m_utf8_search_equal_avx2(&probes[1], bytes1));
+        uint32_t mask =
+            (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(candidate, m_utf8_search_equal_avx2(&probes[2], bytes2)));
+        if (mask != 0)
+        {
+            *hits = mask;
+            return offset;
+        }
+    }
+    *hits = 0;
+    return offset;
+}
+#endif
+
+#if defined(__SSE2__)
+/**
+ * @private
+ * @fn static inline __m128i m_utf8_search_equal_sse2(const struct m_utf8_search_probe *probe, __m128i bytes)
+ * @brief test 16 bytes by a probe of more than one byte or of the leads of a continuation
+ * @return 0xFF of the byte which is one of the probe bytes
+ */
+static inline __m128i m_utf8_search_equal_sse2(const struct m_utf8_search_probe *probe, __m128i bytes)
+{
+    /* signed 0xC0 is over 0x80 to 0xBF */
+    __m128i equal = probe->continuation ? _mm_cmpgt_epi8(_mm_set1_epi8((char)0xC0), bytes) : _mm_setzero_si128();
+    equal = _mm_or_si128(equal, _mm_cmpeq_epi8(bytes, _mm_set1_epi8((char)probe->bytes[0])));
+    equal = _mm_or_si128(equal, _mm_cmpeq_epi8(bytes, _mm_set1_epi8((char)probe->bytes[1])));
+    equal = _mm_or_si128(equal, _mm_cmpeq_epi8(bytes, _mm_set1_epi8((char)probe->bytes[2])));
+    return _mm_or_si128(equal, _mm_cmpeq_epi8(bytes, _mm_set1_epi8((char)probe->bytes[3])));
+}
+
+/**
+ * @private
+ * @fn static size_t m_utf8_search_block_sse2(const struct m_utf8_search_pattern *pattern, const uint8_t *str, size_t str_bytesize, size_t offset, uint32_t *hits)
+ * @brief skip blocks of 16 offsets without a candidate
+ * @param[out] hits - bit of the candidate in the block, 0 when the rest is shorter than a block and the probe span
+ * @return offset of the block
+ */
+static size_t m_utf8_search_block_sse2(const struct m_utf8_search_pattern *pattern, const uint8_t *str,
+                                       size_t str_bytesize, size_t offset, uint32_t *hits)
+{
+    const struct m_utf8_search_probe *probes = pattern->probes;
+    const __m128i case_bit0 = _mm_set1_epi8((char)probes[0].case_bit);
+    const __m128i case_bit1 = _mm_set1_epi8((char)probes[1].case_bit);
+    const __m128i case_bit2 = _mm_set1_epi8((char)probes[2].case_bit);
+
+    if (pattern->single)
+    {
+        /* one byte of each probe, the loop of most patterns */
+        const __m128i byte0 = _mm_set1_epi8((char)probes[0].bytes[0]);
+        const __m128i byte1 = _mm_set1_epi8((char)probes[1].bytes[0]);
+        const __m128i byte2 = _mm_set1_epi8((char)probes[2].bytes[0]);
+        for (; str_bytesize - offset >= 16 + pattern->probe_span; offset += 16)
+        {
+            const uint8_t *block = str + offset;
+            __m128i bytes0 = _mm_or_si128(_mm_loadu_si128((const __m128i *)(block + probes[0].offset)), case_bit0);
+            __m128i bytes1 = _mm_or_si128(_mm_loadu_si128((const __m128i *)(block + probes[1].offset)), case_bit1);
+            __m128i bytes2 = _mm_or_si128(_mm_loadu_si128((const __m128i *)(block + probes[2].offset)), case_bit2);
+            __m128i candidate = _mm_and_si128(_mm_cmpeq_epi8(bytes0, byte0), _mm_cmpeq_epi8(bytes1, byte1));
+            uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(candidate, _mm_cmpeq_epi8(bytes2, byte2)));
+            if (mask != 0)
+            {
+                *hits = mask;
+                return offset;
+            }
+        }
+        *hits = 0;
+        return offset;
+    }
+
+    for (; str_bytesize - offset >= 16 + pattern->probe_span; offset += 16)
+    {
+        const uint8_t *block = str + offset;
+        __m128i bytes0 = _mm_or_si128(_mm_loadu_si128((const __m128i *)(block + probes[0].offset)), case_bit0);
+        __m128i bytes1 = _mm_or_si128(_mm_loadu_si128((const __m128i *)(block + probes[1].offset)), case_bit1);
+        __m128i bytes2 = _mm_or_si128(_mm_loadu_si128((const __m128i *)(block + probes[2].offset)), case_bit2);
+        __m128i candidate = _mm_and_si128(m_utf8_search_equal_sse2(&probes[0], bytes0),
+                                          m_utf8_search_equal_sse2(&probes[1], bytes1));
+        uint32_t mask =
+            (uint32_t)_mm_movemask_epi8(_mm_and_si128(candidate, m_utf8_search_equal_sse2(&probes[2], bytes2)));
+        if (mask != 0)
+        {
+            *hits = mask;
+            return offset;
+        }
+    }
+    *hits = 0;
+    return offset;
+}
+#endif
+
+/**
+ * @private
+ * @fn static inline size_t m_utf8_search_block_size(void)
+ * @brief byte size of the block of m_utf8_search_block by the SIMD level in use, 0 when no block
+ */
+static inline size_t m_utf8_search_block_size(void)
+{
+    m_utf8_simd_t level = m_utf8_simd_level();
+
+#if defined(M_UTF8_SEARCH_AVX2)
+    if (level >= M_UTF8_SIMD_AVX2)
+        return 32;
+#endif
+#if defined(__SSE2__)
+    if (level >= M_UTF8_SIMD_SSE2)
+        return 16;
+#endif
+    (void)level;
+    return 0;
+}
+
+/**
+ * @private
+ * @fn static inline size_t m_utf8_search_block(const struct m_utf8_search_pattern *pattern, size_t block_size, const uint8_t *str, size_t str_bytesize, size_t offset, uint32_t *hits)
+ * @brief skip blocks without a candidate
+ * @param[out] hits - bit of the candidate in the block, 0 when the rest is shorter than a block
+ * @return offset of the block
+ */
+static inline size_t m_utf8_search_block(const struct m_utf8_search_pattern *pattern, size_t block_size,
+                                         const uint8_t *str, size_t str_bytesize, size_t offset, uint32_t *hits)
+{
+#if defined(M_UTF8_SEARCH_AVX2)
+    if (block_size == 32)
+        return m_utf8_search_block_avx2(pattern, str, str_bytesize, offset, hits);
+#endif
+#if defined(__SSE2__)
+    if (block_size == 16)
+        return m_utf8_search_block_sse2(pattern, str, str_bytesize, offset, hits);
+#endif
+    (void)pattern;
+    (void)block_size;
+    (void)str;
+    (void)str_bytesize;
+    *hits = 0;
+    return offset;
+}
+
+/**
+ * @private
+ * @fn static int64_t m_utf8_search_run(const struct m_utf8_search_pattern *pattern, const uint8_t *str, size_t str_bytesize, int64_t *offsets, size_t offsets_size, int64_t limit, size_t *match_bytesize)
+ * @brief find the matches which do not overlap, from the start
+ * @param[out] offsets - byte offsets of the first offsets_size matches( NULL is ok when offsets_size is 0)
+ * @param[in] offsets_size - offsets array size
+ * @param[in] limit - stop at this match count, 0 is no limit
+ * @param[out] match_bytesize - byte size of the last match
+ * @return match count
+ * @note
+ *   the hits of a block are verified in the order, the hits in the last match are skipped.
+ */
+static int64_t m_utf8_search_run(const struct m_utf8_search_pattern *pattern, const uint8_t *str, size_t str_bytesize,
+                                 int64_t *offsets, size_t offsets_size, int64_t limit, size_t *match_bytesize)
+{
+    size_t block_size = m_utf8_search_block_size();
+    size_t offset = 0;
+    int64_t count = 0;
+    size_t size;
+
+    while (offset < str_bytesize)
+    {
+        uint32_t hits;
+        size_t block = m_utf8_search_block(pattern, block_size, str, str_bytesize, offset, &hits);
+        if (hits == 0)
+        {
+            offset = block; /* tail of the buffer */
+            break;
+        }
+        while (hits != 0)
+        {
+            size_t candidate = block + (size_t)__builtin_ctz(hits);
+            hits &= hits - 1;
+            if (candidate >= offset && (size = m_utf8_search_match(pattern, str, str_bytesize, candidate)) != 0)
+            {
+                if ((size_t)count < offsets_size)
+                    offsets[count] = (int64_t)candidate;
+                *match_bytesize = size;
+                if (++count == limit)
+                    return count;
+                offset = candidate + size;
+            }
+        }
+        if (offset < block + block_size)
+            offset = block + block_size;
+    }
+
+    while (offset < str_bytesize)
+    {
+        if (pattern->probes[0].count == 1 && pattern->probes[0].case_bit == 0)
+        {
+            const uint8_t *first = memchr(str + offset, pattern->probes[0].bytes[0], str_bytesize - offset);
+            if (first == NULL)
+                break;
+            offset = (size_t)(first - str);
+        }
+        else if (!m_utf8_search_is_first(pattern, str[offset]))
+        {
+            offset++;
+            continue;
+        }
+        if ((size = m_utf8_search_match(pattern, str, str_bytesize, offset)) != 0)
+        {
+            if ((size_t)count < offsets_size)
+                offsets[count] = (int64_t)offset;
+            *match_bytesize = size;
+            if (++count == limit)
+                return count;
+            offset += size;
+        }
+        else
+        {
+            offset++;
+        }
+    }
+    return count;
+}
+
+/**
+ * @public
+ * @fn int64_t m_utf8_mem_find(const m_char8_t *str, size_t str_bytesize, const m_char8_t *pattern, size_t pattern_bytesize, m_utf8_search_t search, size_t *match_bytesize)
+ * @brief find the first match of pattern in utf8 buffer
+ * @param[in] str - utf8 buffer( null-terminated string is not needed)
+ * @param[in] str_bytesize - utf8 buffer byte size
+ * @param[in] pattern - utf8 pattern( null-terminated string is not needed)
+ * @param[in] pattern_bytesize - utf8 pattern byte size
+ * @param[in] search - M_UTF8_SEARCH_EXACT or M_UTF8_SEARCH_IGNORE_CASE
+ * @param[out] match_bytesize - byte size of the match( NULL is ok), differs from pattern_bytesize when case is ignored
+ * @return byte offset of the match, -1 when none, or pattern is empty or invalid
+ * @note
+ *   a match starts and ends on character boundaries( m_utf8_ch_next), also in invalid utf8.
+ *   an invalid character of str is not matched.
+ *   the candidates are tested 32 bytes at a time with AVX2, 16 bytes with SSE2, by the first byte and the last byte
+ *   of pattern. when case is ignored, by the bytes of every case of the characters.
+ */
+int64_t m_utf8_mem_find(const m_char8_t *str, size_t str_bytesize, const m_char8_t *pattern, size_t pattern_bytesize,
+                        m_utf8_search_t search, size_t *match_bytesize)
+{
+    struct m_utf8_search_pattern search_pattern;
+    int64_t offset = -1;
+    size_t size = 0;
+
+    M_UTF8_STATS_API(M_UTF8_STATS_SEARCH, str_bytesize);
+    if (str != NULL && m_utf8_search_init(&search_pattern, pattern, pattern_bytesize, search))
+        m_utf8_search_run(&search_pattern, (const uint8_t *)str, str_bytesize, &offset, 1, 1, &size);
+    if (match_bytesize != NULL)
+        *match_bytesize = offset >= 0 ? size : 0;
+    return offset;
+}
+
+/**
+ * @public
+ * @fn int64_t m_utf8_mem_find_all(const m_char8_t *str, size_t str_bytesize, const m_char8_t *pattern, size_t pattern_bytesize, m_utf8_search_t search, int64_t *offsets, size_t offsets_size)
+ * @brief find the matches of pattern in utf8 buffer, which do not overlap
+ * @param[in] str - utf8 buffer( null-terminated string is not needed)
+ * @param[in] str_bytesize - utf8 buffer byte size
+ * @param[in] pattern - utf8 pattern( null-terminated string is not needed)
+ * @param[in] pattern_bytesize - utf8 pattern byte size
+ * @param[in] search - M_UTF8_SEARCH_EXACT or M_UTF8_SEARCH_IGNORE_CASE
+ * @param[out] offsets - byte offsets of the first offsets_size matches( NULL is ok when offsets_size is 0)
+ * @param[in] offsets_size - offsets array size
+ * @return match count, it may be more than offsets_size. -1 when pattern is empty or invalid
+ * @note
+ *   the next match is searched from the end of a match, same as m_utf8_mem_count.
+ */
+int64_t m_utf8_mem_find_all(const m_char8_t *str, size_t str_bytesize, const m_char8_t *pattern,
+                            size_t pattern_bytesize, m_utf8_search_t search, int64_t *offsets, size_t offsets_size)
+{
+    struct m_utf8_search_pattern search_pattern;
+    size_t size;
+
+    M_UTF8_STATS_API(M_UTF8_STATS_SEARCH, str_bytesize);
+    if (str == NULL || !m_utf8_search_init(&search_pattern, pattern, pattern_bytesize, search))
+        return -1;
+    return m_utf8_search_run(&search_pattern, (const uint8_t *)str, str_bytesize, offsets, offsets != NULL ? offsets_size : 0,
+                             0, &size);
+}
+
+/**
+ * @public
+ * @fn int64_t m_utf8_mem_count(const m_char8_t *str, size_t str_bytesize, const m_char8_t *pattern, size_t pattern_bytesize, m_utf8_search_t search)
+ * @brief count the matches of pattern in utf8 buffer, which do not overlap
+ * @param[in] str - utf8 buffer( null-terminated string is not needed)
+ * @param[in] str_bytesize - utf8 buffer byte size
+ * @param[in] pattern - utf8 pattern( null-terminated string is not needed)
+ * @param[in] pattern_bytesize - utf8 pattern byte size
+ * @param[in] search - M_UTF8_SEARCH_EXACT or M_UTF8_SEARCH_IGNORE_CASE
+ * @return match count, -1 when pattern is empty or invalid
+ */
+int64_t m_utf8_mem_count(const m_char8_t *str, size_t str_bytesize, const m_char8_t *pattern, size_t pattern_bytesize,
+                         m_utf8_search_t search)
+{
+    return m_utf8_mem_find_all(str, str_bytesize, pattern, pattern_bytesize, search, NULL, 0);
+}
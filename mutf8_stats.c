@@ -0,0 +1,159 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#if defined(M_UTF8_STATS)
+#include <pthread.h>
+#endif
+
+#include "mutf8.h"
+#include "mutf8_stats.h"
+
+/* every member of m_utf8_stats_t is uint64_t. */
+#define M_UTF8_STATS_COUNTER_SIZE (sizeof(m_utf8_stats_t) / sizeof(uint64_t))
+
+#if defined(M_UTF8_STATS)
+_Thread_local struct m_utf8_stats_slot m_utf8_stats_local;
+
+/**
+ * @private
+ * @var static struct m_utf8_stats_slot *m_utf8_stats_threads
+ * @brief counters of the living threads which counted something
+ * @note
+ *   m_utf8_stats_retired is the sum of the exited threads, m_utf8_stats_base is the sum at m_utf8_stats_reset.
+ *   the counters are only added, so a reset does not write the counters of other threads.
+ */
+static struct m_utf8_stats_slot *m_utf8_stats_threads;
+static m_utf8_stats_t m_utf8_stats_retired;
+static m_utf8_stats_t m_utf8_stats_base;
+static pthread_mutex_t m_utf8_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t m_utf8_stats_once = PTHREAD_ONCE_INIT;
+static pthread_key_t m_utf8_stats_key;
+
+/**
+ * @private
+ * @fn static void m_utf8_stats_sum(m_utf8_stats_t *sum, const m_utf8_stats_t *stats)
+ * @brief add the counters of stats to sum
+ */
+static void m_utf8_stats_sum(m_utf8_stats_t *sum, const m_utf8_stats_t *stats)
+{
+    uint64_t *dst = (uint64_t *)sum;
+    const uint64_t *src = (const uint64_t *)stats;
+
+    for (size_t i = 0; i < M_UTF8_STATS_COUNTER_SIZE; i++)
+    {
+        dst[i] += __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @private
+ * @fn static void m_utf8_stats_total(m_utf8_stats_t *total)
+ * @brief sum of the living and exited threads( lock m_utf8_stats_mutex)
+ */
+static void m_utf8_stats_total(m_utf8_stats_t *total)
+{
+    *total = m_utf8_stats_retired;
+    for (struct m_utf8_stats_slot *slot = m_utf8_stats_threads; slot != NULL; slot = slot->next)
+    {
+        m_utf8_stats_sum(total, &slot->stats);
+    }
+}
+
+/**
+ * @private
+ * @fn static void m_utf8_stats_exit(void *arg)
+ * @brief move the counters of an exiting thread to m_utf8_stats_retired
+ */
+static void m_utf8_stats_exit(void *arg)
+{
+    struct m_utf8_stats_slot *slot = arg;
+
+    pthread_mutex_lock(&m_utf8_stats_mutex);
+    for (struct m_utf8_stats_slot **link = &m_utf8_stats_threads; *link != NULL; link = &(*link)->next)
+    {
+        if (*link == slot)
+        {
+            *link = slot->next;
+            break;
+        }
+    }
+    m_utf8_stats_sum(&m_utf8_stats_retired, &slot->stats);
+    pthread_mutex_unlock(&m_utf8_stats_mutex);
+}
+
+/**
+ * @private
+ * @fn static void m_utf8_stats_init(void)
+ * @brief create the key, its destructor is called at the exit of a registered thread
+ */
+static void m_utf8_stats_init(void)
+{
+    pthread_key_create(&m_utf8_stats_key, m_utf8_stats_exit);
+}
+
+/**
+ * @private
+ * @fn void m_utf8_stats_register(void)
+ * @brief link the counters of the calling thread, at the first count of the thread
+ */
+void m_utf8_stats_register(void)
+{
+    struct m_utf8_stats_slot *slot = &m_utf8_stats_local;
+
+    pthread_once(&m_utf8_stats_once, m_utf8_stats_init);
+    pthread_mutex_lock(&m_utf8_stats_mutex);
+    slot->next = m_utf8_stats_threads;
+    m_utf8_stats_threads = slot;
+    slot->registered = true;
+    pthread_mutex_unlock(&m_utf8_stats_mutex);
+    pthread_setspecific(m_utf8_stats_key, slot);
+}
+#endif
+
+/**
+ * @public
+ * @fn bool m_utf8_stats_snapshot(m_utf8_stats_t *stats)
+ * @brief counters of all threads since the last m_utf8_stats_reset
+ * @param[out] stats - counters, all 0 when the library is not built with M_UTF8_STATS
+ * @return true when the library is built with M_UTF8_STATS
+ * @note
+ *   a thread keeps its own counters, so counting does not share a cache line with other threads.
+ *   the counters of a running call may be partly added.
+ */
+bool m_utf8_stats_snapshot(m_utf8_stats_t *stats)
+{
+#if defined(M_UTF8_STATS)
+    m_utf8_stats_t total;
+    uint64_t *dst = (uint64_t *)stats;
+    const uint64_t *now = (const uint64_t *)&total;
+    const uint64_t *base = (const uint64_t *)&m_utf8_stats_base;
+
+    pthread_mutex_lock(&m_utf8_stats_mutex);
+    m_utf8_stats_total(&total);
+    for (size_t i = 0; i < M_UTF8_STATS_COUNTER_SIZE; i++)
+    {
+        dst[i] = now[i] - base[i];
+    }
+    pthread_mutex_unlock(&m_utf8_stats_mutex);
+    return true;
+#else
+    memset(stats, 0, sizeof(*stats));
+    return false;
+#endif
+}
+
+/**
+ * @public
+ * @fn void m_utf8_stats_reset(void)
+ * @brief set the counters of all threads to 0
+ * @note
+ *   nothing when the library is not built with M_UTF8_STATS.
+ */
+void m_utf8_stats_reset(void)
+{
+#if defined(M_UTF8_STATS)
+    pthread_mutex_lock(&m_utf8_stats_mutex);
+    m_utf8_stats_total(&m_utf8_stats_base);
+    pthread_mutex_unlock(&m_utf8_stats_mutex);
+#endif
+}
@@ -0,0 +1,68 @@
+#ifndef MUTF8_STATS_H
+#define MUTF8_STATS_H
+
+/*
+ * counters of mutf8, see m_utf8_stats_snapshot.
+ *
+ * build the library with M_UTF8_STATS defined to count, and the macros below add to the counters
+ * of the calling thread. without M_UTF8_STATS, every macro is ((void)0) and adds no instruction.
+ * a translation unit with M_UTF8_INLINE must agree with the library on M_UTF8_STATS.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "mutf8.h"
+
+#if defined(M_UTF8_STATS)
+/**
+ * @private
+ * @struct m_utf8_stats_slot
+ * @brief counters of a thread, linked to the list of m_utf8_stats_snapshot
+ */
+struct m_utf8_stats_slot
+{
+    m_utf8_stats_t stats;
+    struct m_utf8_stats_slot *next;
+    bool registered;
+};
+
+extern _Thread_local struct m_utf8_stats_slot m_utf8_stats_local;
+extern void m_utf8_stats_register(void);
+
+/**
+ * @private
+ * @fn static inline void m_utf8_stats_add(uint64_t *counter, uint64_t n)
+ * @brief add to a counter of the calling thread
+ * @note
+ *   only the owner thread writes the counter, m_utf8_stats_snapshot reads it from other threads.
+ *   so a relaxed load and store is enough, no locked instruction.
+ */
+static inline void m_utf8_stats_add(uint64_t *counter, uint64_t n)
+{
+    __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + n, __ATOMIC_RELAXED);
+}
+
+#define M_UTF8_STATS_ADD(member, n)                                           \
+    do                                                                        \
+    {                                                                         \
+        if (!m_utf8_stats_local.registered)                                   \
+            m_utf8_stats_register();                                          \
+        m_utf8_stats_add(&m_utf8_stats_local.stats.member, (uint64_t)(n));    \
+    } while (0)
+#else
+#define M_UTF8_STATS_ADD(member, n) ((void)0)
+#endif
+
+/* a call of the API group, bytesize is the input byte size. */
+#define M_UTF8_STATS_API(api, bytesize)              \
+    do                                               \
+    {                                                \
+        M_UTF8_STATS_ADD(api_calls[(api)], 1);       \
+        M_UTF8_STATS_ADD(api_bytes[(api)], bytesize); \
+    } while (0)
+
+/* a character of ch_byte_size bytes( m_utf8_jump_table), 5 and 6 bytes are counted as 4. */
+#define M_UTF8_STATS_CHAR(ch_byte_size) \
+    M_UTF8_STATS_ADD(char_count[((ch_byte_size) > 4 ? 4 : (ch_byte_size)) - 1], 1)
+
+#endif /* end MUTF8_STATS_H */
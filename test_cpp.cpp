@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "mutf8.h"
+#include "mutf8.hpp"
+
+// compile-time checks
+static_assert(mutf8::validate("abc"));
+static_assert(mutf8::validate(u8"あいう🚀"));
+static_assert(!mutf8::validate("\xC0\xAF"));             // overlong
+static_assert(!mutf8::validate("\xED\xA0\x80"));         // surrogate
+static_assert(!mutf8::validate("\xF4\x90\x80\x80"));     // out of range
+static_assert(!mutf8::validate("\xEF\xB7\x90"));         // U+FDD0
+static_assert(!mutf8::validate("\xEF\xBF\xBF"));         // U+FFFF
+static_assert(!mutf8::validate("\xE3\x81"));             // truncated
+static_assert(mutf8::validate(std::string_view("a\0b", 3)));
+static_assert(mutf8::valid_length("ab\xFF" "c") == 2);
+static_assert(mutf8::length(u8"aあ🚀") == 3);
+static_assert(mutf8::length("") == 0);
+static_assert(mutf8::display_width(u8"メニュー") == 8);
+static_assert(mutf8::display_width(u8"é") == 2);
+static_assert(mutf8::display_width(u8"é", false) == 1);
+static_assert(mutf8::display_width(u8"🚀", true, false) == 1);
+static_assert(mutf8::display_width("a\xFF" "b") == 3);
+static_assert(mutf8::unicode_width(U'あ') == 2);
+static_assert(mutf8::unicode_width(U'a') == 1);
+
+constexpr mutf8::literal title = u8"タイトル";
+static_assert(title.length() == 4);
+static_assert(title.display_width() == 8);
+static_assert(title.byte_size() == 12);
+
+constexpr std::int64_t view_count(std::string_view str)
+{
+    std::int64_t count = 0;
+    for (char32_t c : mutf8::utf8_view(str))
+        count += c != mutf8::replacement_character;
+    return count;
+}
+static_assert(view_count("aあ🚀") == 3);
+static_assert(view_count("a\xE3\x81" "b") == 2);
+static_assert(*mutf8::utf8_view("あい").begin() == U'あ');
+static_assert(*--mutf8::utf8_view("あい").end() == U'い');
+static_assert(std::is_same_v<std::iterator_traits<mutf8::utf8_view::iterator>::iterator_category,
+                             std::bidirectional_iterator_tag>);
+#if defined(__cpp_lib_ranges)
+static_assert(std::ranges::bidirectional_range<mutf8::utf8_view>);
+static_assert(std::ranges::view<mutf8::utf8_view>);
+#endif
+
+int main(void)
+{
+    // test mutf8::utf8_view
+    {
+        std::string str = "abcdefghijあいう\xF0\x9F" "x🚀";
+        mutf8::utf8_view view(str);
+        std::vector<char32_t> unicodes(view.begin(), view.end());
+        assert((unicodes == std::vector<char32_t>{U'a', U'b', U'c', U'd', U'e', U'f', U'g', U'h', U'i', U'j', U'あ',
+                                                  U'い', U'う', mutf8::replacement_character, U'x', U'🚀'}));
+        assert(std::distance(view.begin(), view.end()) == 16);
+        assert(std::count(view.begin(), view.end(), mutf8::replacement_character) == 1);
+
+        std::vector<char32_t> reversed(view.rbegin(), view.rend());
+        assert(std::equal(reversed.begin(), reversed.end(), unicodes.rbegin()));
+
+        auto it = std::find(view.begin(), view.end(), U'い');
+        assert(it.offset() == 13 && it.size() == 3 && it.valid());
+        assert(view.view(view.begin(), it) == "abcdefghijあ");
+        ++it, ++it;
+        assert(!it.valid() && it.bytes() == "\xF0\x9F");
+
+        it = view.begin();
+        assert(it.skip_ascii() == 10);
+        assert(*it == U'あ' && it.offset() == 10);
+        assert(it.skip_ascii() == 0);
+    }
+
+    // test mutf8::utf8_view of an exact size buffer, end() does not read after the buffer
+    {
+        char *heap = static_cast<char *>(std::malloc(5));
+        assert(heap != nullptr);
+        std::memcpy(heap, "ab\xE3\x81\x82", 5);
+        mutf8::utf8_view view(std::string_view(heap, 5));
+        std::vector<char32_t> unicodes(view.begin(), view.end());
+        assert((unicodes == std::vector<char32_t>{U'a', U'b', U'あ'}));
+        assert((--view.end()).offset() == 2);
+        std::free(heap);
+
+        mutf8::utf8_view empty;
+        assert(empty.begin() == empty.end() && std::distance(empty.begin(), empty.end()) == 0);
+    }
+
+    // test mutf8::utf8_view against m_utf8_ch_next and m_utf8_ch_prev
+    {
+        srand(20);
+        char buf[64];
+        for (int n = 0; n < 100000; n++)
+        {
+            size_t size = (size_t)(rand() % (int)sizeof(buf));
+            for (size_t i = 0; i < size; i++)
+            {
+                static const unsigned char bytes[] = {0x41, 0x80, 0x8F, 0x9F, 0xA0, 0xBE, 0xBF, 0xC1, 0xC2,
+                                                      0xE0, 0xE3, 0xED, 0xEF, 0xF0, 0xF4, 0xF5, 0xF8, 0xFF};
+                buf[i] = (char)(rand() % 4 ? bytes[rand() % sizeof(bytes)] : rand());
+            }
+            mutf8::utf8_view view(buf, size);
+            std::vector<size_t> offsets;
+            size_t offset = 0;
+            for (auto it = view.begin(); it != view.end(); ++it)
+            {
+                uint32_t unicode;
+                bool valid;
+                assert(it.offset() == offset);
+                offset += m_utf8_ch_next(buf + offset, size - offset, &unicode, &valid);
+                assert(*it == unicode && it.valid() == valid);
+                offsets.push_back(it.offset());
+            }
+            assert(offset == size);
+            for (auto it = view.end(); it != view.begin();)
+            {
+                --it;
+                assert(it.offset() == offsets.back());
+                assert(m_utf8_ch_prev(buf, offset) == offsets.back());
+                offset = offsets.back();
+                offsets.pop_back();
+            }
+            assert(offsets.empty());
+        }
+    }
+
+    // test mutf8::validate, length and display_width against the C functions
+    {
+        const char *strs[] = {
+            "", "abc", "あいう", "🚀a", "éa", "\xC0\xAF", "\xED\xA0\x80", "\xE3\x81", "a\xFF", "\xEF\xBF\xBE",
+        };
+        for (const char *s : strs)
+        {
+            std::string_view view(s);
+            m_utf8_stat_t stat;
+            m_utf8_mem_stat(view.data(), view.size(), NULL, &stat);
+            assert(mutf8::validate(view) == m_utf8_mem_validate(view.data(), view.size()));
+            assert(mutf8::length(view) == m_utf8_mem_display_count(view.data(), view.size()));
+            assert(mutf8::display_width(view) == stat.display_width);
+        }
+    }
+
+    // test random bytes against the C functions
+    {
+        srand(19);
+        char buf[64];
+        for (int n = 0; n < 100000; n++)
+        {
+            size_t size = (size_t)(rand() % (int)sizeof(buf));
+            for (size_t i = 0; i < size; i++)
+            {
+                static const unsigned char bytes[] = {0x00, 0x41, 0x7F, 0x80, 0xA0, 0xBF, 0xC2, 0xDF, 0xE0,
+                                                      0xE3, 0xED, 0xEF, 0xF0, 0xF4, 0xF5, 0xFF, 0xB7, 0x9F};
+                buf[i] = (char)(rand() % 2 ? bytes[rand() % sizeof(bytes)] : rand());
+            }
+            std::string_view view(buf, size);
+            m_utf8_stat_t stat;
+            m_utf8_mem_stat(buf, size, m_utf8_width_profile(false, true), &stat);
+            assert(mutf8::validate(view) == m_utf8_mem_validate(buf, size));
+            assert(mutf8::length(view) == m_utf8_mem_display_count(buf, size));
+            assert(mutf8::display_width(view, false, true) == stat.display_width);
+        }
+    }
+
+    // test mutf8::unicode_width against the C function
+    {
+        const m_utf8_width_profile_t *profile = m_utf8_width_profile(true, false);
+        for (uint32_t c = 0; c < 0x110000; c++)
+            assert(mutf8::unicode_width(c, true, false) == m_utf8_unicode_width(c, profile));
+    }
+    return 0;
+}
@@ -1,6 +1,8 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <locale.h>
 #include "mutf8.h"
@@ -64,6 +66,21 @@ int main(void)
         assert(m_utf8_to_unicode(str4) == 0x1F680);
     }
 
+    // test m_utf8_ch_decode
+    {
+        uint32_t unicode = 0xFFFFFFFF;
+        assert(m_utf8_ch_decode("", 1, &unicode) == 1);
+        assert(unicode == 0);
+        assert(m_utf8_ch_decode(u8"あ", 3, &unicode) == 3);
+        assert(unicode == 0x3042);
+        assert(m_utf8_ch_decode(u8"🚀", 4, &unicode) == 4);
+        assert(unicode == 0x1F680);
+        assert(m_utf8_ch_decode(u8"あ", 2, &unicode) == 0);          // truncated
+        assert(m_utf8_ch_decode(u8"\xc3\x28", 2, &unicode) == 0);    // invalid
+        assert(m_utf8_ch_decode(u8"\xef\xbf\xbe", 3, &unicode) == 0); // U+FFFE
+        assert(m_utf8_ch_decode(u8"a", 0, &unicode) == 0);
+    }
+
     // test m_utf8_display_width
     {
         setlocale(LC_ALL, "ja_JP.UTF-8");
@@ -75,6 +92,40 @@ int main(void)
         assert(m_utf8_display_width(str3) == 2);
         m_char8_t *str4 = u8"🚀";
         assert(m_utf8_display_width(str4) == 2);
+        assert(m_utf8_display_width(u8"ñ") == 1);
+        assert(m_utf8_display_width(u8"¡") == 2);  // ambiguous
+        assert(m_utf8_display_width(u8"Ａ") == 2); // full width
+        assert(m_utf8_display_width(u8"😀") == 2);
+        assert(m_utf8_display_width(u8"\U0010FFFD") == 2);
+        assert(m_utf8_display_width("\xe3\x28\xa1") == 1); // invalid
+    }
+
+    // test m_utf8_display_width_profile
+    {
+        const m_utf8_width_profile_t *cjk = m_utf8_width_profile(true, true);
+        const m_utf8_width_profile_t *western = m_utf8_width_profile(false, true);
+        const m_utf8_width_profile_t *narrow = m_utf8_width_profile(false, false);
+        assert(m_utf8_display_width_profile(u8"a", cjk) == 1);
+        assert(m_utf8_display_width_profile(u8"¡", cjk) == 2);
+        assert(m_utf8_display_width_profile(u8"¡", western) == 1);
+        assert(m_utf8_display_width_profile(u8"¡", NULL) == 2);
+        assert(m_utf8_display_width_profile(u8"あ", western) == 2);
+        assert(m_utf8_display_width_profile(u8"あ", narrow) == 2);
+        assert(m_utf8_display_width_profile(u8"🚀", western) == 2);
+        assert(m_utf8_display_width_profile(u8"🚀", narrow) == 1);
+        assert(m_utf8_display_width_profile(u8"🚀", m_utf8_width_profile(true, false)) == 1);
+        assert(m_utf8_unicode_width(0x3042, western) == 2);
+        assert(m_utf8_unicode_width(0x00A1, western) == 1);
+        assert(m_utf8_unicode_width(0x00A1, NULL) == 2);
+        assert(m_utf8_unicode_width(0x110000, NULL) == 1);
+        // emoji in the ambiguous ranges follow the emoji width
+        assert(m_utf8_display_width_profile(u8"🆎", western) == 2);
+        assert(m_utf8_unicode_width(0x1F191, western) == 2 && m_utf8_unicode_width(0x1F19A, western) == 2);
+        assert(m_utf8_unicode_width(0x1F18E, m_utf8_width_profile(true, false)) == 1);
+
+        m_utf8_stat_t stat;
+        assert(m_utf8_str_stat(u8"¡🚀あ", 100, narrow, &stat) == true);
+        assert(stat.display_width == 4);
     }
 
     // test m_utf8_str_byte_size
@@ -127,6 +178,31 @@ int main(void)
         assert(m_utf8_str_validate(str2, size_str2) == false);
     }
 
+    // test m_utf8_str_validate (long string)
+    {
+        m_char8_t str1[] = u8"0123456789abcdef0123456789abcdefあいうえお🚀0123456789abcdef0123456789abcdef";
+        assert(m_utf8_str_validate(str1, sizeof(str1)) == true);
+        assert(m_utf8_str_validate(str1, sizeof(str1) - 1) == false);
+        for (size_t i = 0; i < sizeof(str1) - 1; i++)
+        {
+            m_char8_t str2[sizeof(str1)];
+            memcpy(str2, str1, sizeof(str1));
+            str2[i] = '\xff';
+            assert(m_utf8_str_validate(str2, sizeof(str2)) == false);
+        }
+
+        m_char8_t str3[] = "0123456789abcdef0123456789abcde\xef\xbf\xbe" "0123456789abcdef"; // U+FFFE
+        assert(m_utf8_str_validate(str3, sizeof(str3)) == false);
+        m_char8_t str4[] = "0123456789abcdef0123456789abcde\xef\xb7\x90"; // U+FDD0
+        assert(m_utf8_str_validate(str4, sizeof(str4)) == false);
+        m_char8_t str5[] = "0123456789abcdef0123456789abcd\xf0\x9f\xbf\xbf" "0123456789abcdef"; // U+1FFFF
+        assert(m_utf8_str_validate(str5, sizeof(str5)) == false);
+        m_char8_t str6[] = "0123456789abcdef0123456789abcde\xed\xa0\x80" "0123456789abcdef"; // surrogate
+        assert(m_utf8_str_validate(str6, sizeof(str6)) == false);
+        m_char8_t str7[] = "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcde\xe3\x81"; // truncated
+        assert(m_utf8_str_validate(str7, sizeof(str7)) == false);
+    }
+
     // test m_utf8_str_display_count
     {
         m_char8_t *str1 = u8"a";
@@ -140,6 +216,126 @@ int main(void)
         assert(m_utf8_str_display_count(str3, size_str3) == 2);
     }
 
+    // test m_utf8_str_stat
+    {
+        m_utf8_stat_t stat;
+        m_char8_t *str1 = u8"🚀aあ";
+        assert(m_utf8_str_stat(str1, 9, NULL, &stat) == true);
+        assert(stat.byte_size == 9);
+        assert(stat.char_count == 3);
+        assert(stat.display_width == 5);
+        assert(stat.error_offset == -1);
+
+        assert(m_utf8_str_stat(str1, 8, NULL, &stat) == false);
+        assert(stat.byte_size == m_utf8_str_byte_size(str1, 8));
+        assert(stat.char_count == 2);
+        assert(stat.display_width == 3);
+        assert(stat.error_offset == -1);
+
+        assert(m_utf8_str_stat(str1, 0, NULL, &stat) == false);
+        assert(stat.byte_size == 0);
+        assert(stat.char_count == 0);
+
+        m_char8_t *str2 = u8"🚀aあ\xf0\x28\x8c\xbcい";
+        assert(m_utf8_str_stat(str2, 100, NULL, &stat) == false);
+        assert(stat.byte_size == 16);
+        assert(stat.char_count == 5);
+        assert(stat.error_offset == 8);
+
+        m_char8_t *str3 = u8"0123456789abcdef0123456789abcdef©あ";
+        assert(m_utf8_str_stat(str3, 100, NULL, &stat) == true);
+        assert(stat.byte_size == 38);
+        assert(stat.char_count == 34);
+        assert(stat.display_width == 35);
+    }
+
+    // test m_utf8_mem_to_unicode
+    {
+        m_utf8_conv_t conv;
+        uint32_t dst[64];
+        m_char8_t src1[] = u8"0123456789abcdef0123456789abcdefあ🚀\0a";
+        assert(m_utf8_mem_to_unicode(src1, sizeof(src1) - 1, dst, 64, &conv) == true);
+        assert(conv.src_read == sizeof(src1) - 1);
+        assert(conv.dst_written == 36);
+        assert(conv.error_offset == -1);
+        assert(dst[15] == 'f' && dst[32] == 0x3042 && dst[33] == 0x1F680 && dst[34] == 0 && dst[35] == 'a');
+
+        assert(m_utf8_mem_to_unicode(src1, sizeof(src1) - 1, dst, 33, &conv) == false);
+        assert(conv.src_read == 35);
+        assert(conv.dst_written == 33);
+        assert(conv.error_offset == -1);
+
+        assert(m_utf8_mem_to_unicode(src1, 34, dst, 64, &conv) == false); // truncated
+        assert(conv.src_read == 32);
+        assert(conv.dst_written == 32);
+        assert(conv.error_offset == 32);
+
+        m_char8_t *src2 = u8"aあ\xf0\x28\x8c\xbc";
+        assert(m_utf8_mem_to_unicode(src2, 8, dst, 64, NULL) == false);
+        assert(m_utf8_mem_to_unicode(src2, 8, dst, 64, &conv) == false);
+        assert(conv.dst_written == 2);
+        assert(conv.error_offset == 4);
+    }
+
+    // test m_utf8_stream_feed
+    {
+        m_char8_t *str1 = u8"🚀aあ0123456789abcdef0123456789abcdef©";
+        size_t size_str1 = strlen(str1);
+        for (size_t i = 0; i <= size_str1; i++)
+        {
+            m_utf8_stream_t stream;
+            m_utf8_stream_init(&stream);
+            assert(m_utf8_stream_feed(&stream, str1, i) == true);
+            assert(m_utf8_stream_feed(&stream, str1 + i, size_str1 - i) == true);
+            assert(m_utf8_stream_finish(&stream) == true);
+            assert(stream.offset == (int64_t)size_str1);
+        }
+
+        m_utf8_stream_t stream;
+        m_utf8_stream_init(&stream);
+        assert(m_utf8_stream_feed(&stream, u8"aあ", 3) == true); // "a\xe3\x81"
+        assert(m_utf8_stream_finish(&stream) == false);        // truncated
+        assert(stream.error_offset == 1);
+
+        m_utf8_stream_init(&stream);
+        assert(m_utf8_stream_feed(&stream, "a\xe3", 2) == true);
+        assert(m_utf8_stream_feed(&stream, "\x28", 1) == false);
+        assert(stream.error_offset == 1);
+        assert(m_utf8_stream_feed(&stream, "a", 1) == false);
+        assert(m_utf8_stream_finish(&stream) == false);
+    }
+
+    // test m_utf8_stream_decode
+    {
+        m_char8_t *str1 = u8"🚀aあ";
+        for (size_t i = 0; i <= 8; i++)
+        {
+            m_utf8_stream_t stream;
+            m_utf8_conv_t conv;
+            uint32_t dst[3];
+            size_t written = 0;
+            m_utf8_stream_init(&stream);
+            assert(m_utf8_stream_decode(&stream, str1, i, dst, 3, &conv) == true);
+            written += conv.dst_written;
+            assert(m_utf8_stream_decode(&stream, str1 + i, 8 - i, dst + written, 3 - written, &conv) == true);
+            written += conv.dst_written;
+            assert(m_utf8_stream_finish(&stream) == true);
+            assert(written == 3);
+            assert(dst[0] == 0x1F680 && dst[1] == 'a' && dst[2] == 0x3042);
+        }
+
+        m_utf8_stream_t stream;
+        m_utf8_conv_t conv;
+        uint32_t dst[3];
+        m_utf8_stream_init(&stream);
+        assert(m_utf8_stream_decode(&stream, str1, 8, dst, 1, &conv) == false); // dst is full
+        assert(conv.src_read == 4);
+        assert(conv.dst_written == 1);
+        assert(conv.error_offset == -1);
+        assert(m_utf8_stream_decode(&stream, str1 + 4, 4, dst, 3, &conv) == true);
+        assert(conv.dst_written == 2);
+    }
+
     // test m_utf8_str_cpy
     {
         int dst_size;
@@ -231,6 +427,29 @@ int main(void)
         assert(m_utf8_str_display_count(dst17, dst_size) == 0);
     }
 
+    // test m_utf8_str_cpy_size
+    {
+        m_char8_t src[1024];
+        for (int i = 0; i < 300; i++)
+        {
+            memcpy(src + i * 3, u8"あ", 3);
+        }
+        src[900] = '\0';
+
+        m_char8_t dst1[1024];
+        assert(m_utf8_str_cpy_size(dst1, sizeof(dst1), src, sizeof(src)) == 900);
+        assert(memcmp(dst1, src, 901) == 0);
+        assert(m_utf8_str_display_count(dst1, sizeof(dst1)) == 300);
+
+        m_char8_t dst2[300];
+        assert(m_utf8_str_cpy_size(dst2, sizeof(dst2), src, sizeof(src)) == 297);
+        assert(dst2[297] == '\0');
+        assert(m_utf8_str_cpy_size(dst2, 299, src, sizeof(src)) == 297);
+        assert(m_utf8_str_cpy_size(dst2, sizeof(dst2), src, 10) == 9);
+        assert(m_utf8_str_cpy_size(dst2, sizeof(dst2), src, 0) == 0);
+        assert(dst2[0] == '\0');
+    }
+
     // test m_utf8_str_cat
     {
         int dst_size;
@@ -243,5 +462,649 @@ int main(void)
         m_utf8_str_cat(dst1, dst_size, src2, 16);
         assert(m_utf8_str_display_count(dst1, dst_size) == 10);
     }
+
+    // test m_utf8_mem_byte_size
+    {
+        m_char8_t str1[] = u8"🚀a\0あ"; // 4 + 1 + 1 + 3 bytes
+        assert(m_utf8_mem_byte_size(str1, 9) == 9);
+        assert(m_utf8_mem_byte_size(str1, 8) == 6);
+        assert(m_utf8_mem_byte_size(str1, 7) == 6);
+        assert(m_utf8_mem_byte_size(str1, 6) == 6);
+        assert(m_utf8_mem_byte_size(str1, 3) == 0);
+        assert(m_utf8_mem_byte_size(str1, 0) == 0);
+        assert(m_utf8_mem_byte_size("\xf8\x88", 2) == 0); // 5 bytes lead
+    }
+
+    // test m_utf8_mem_validate
+    {
+        m_char8_t str1[] = u8"🚀a\0あ";
+        assert(m_utf8_mem_validate(str1, 9) == true);
+        assert(m_utf8_mem_validate(str1, 8) == false);
+        assert(m_utf8_mem_validate(str1 + 5, 4) == true);
+        assert(m_utf8_mem_validate(str1 + 1, 3) == false);
+        assert(m_utf8_mem_validate(str1, 0) == true);
+    }
+
+    // test m_utf8_mem_display_count
+    {
+        m_char8_t str1[] = u8"🚀a\0あ0123456789abcdef0123456789abcdef";
+        assert(m_utf8_mem_display_count(str1, 9) == 4);
+        assert(m_utf8_mem_display_count(str1, 8) == 4); // truncated "あ" is counted.
+        assert(m_utf8_mem_display_count(str1, 6) == 3);
+        assert(m_utf8_mem_display_count(str1, sizeof(str1) - 1) == 36);
+    }
+
+    // test m_utf8_mem_stat
+    {
+        m_utf8_stat_t stat;
+        m_char8_t str1[] = u8"🚀a\0あ";
+        assert(m_utf8_mem_stat(str1, 9, NULL, &stat) == true);
+        assert(stat.byte_size == 9);
+        assert(stat.char_count == 4);
+        assert(stat.display_width == 6);
+        assert(m_utf8_mem_stat(str1, 8, NULL, &stat) == false);
+        assert(stat.error_offset == 6);
+    }
+
+    // test m_utf8_mem_cpy
+    {
+        m_char8_t src[] = u8"あ\0いう"; // 10 bytes
+        m_char8_t dst[16];
+        assert(m_utf8_mem_cpy(dst, sizeof(dst), src, 10) == 10);
+        assert(memcmp(dst, src, 10) == 0 && dst[10] == '\0');
+        assert(m_utf8_mem_cpy(dst, 10, src, 10) == 7);
+        assert(dst[7] == '\0');
+        assert(m_utf8_mem_cpy(dst, 16, src, 9) == 7);
+        assert(m_utf8_mem_cpy(dst, 4, src, 10) == 3);
+        assert(m_utf8_mem_cpy(dst, 3, src, 10) == 0);
+        assert(dst[0] == '\0');
+        assert(m_utf8_mem_cpy(dst, 0, src, 10) == 0);
+    }
+    // test m_utf8_builder
+    {
+        m_char8_t buf[12];
+        m_utf8_builder_t builder;
+        m_utf8_builder_init(&builder, buf, sizeof(buf));
+        assert(builder.char_count == -1);
+        m_utf8_builder_track(&builder, NULL);
+        assert(m_utf8_builder_append_str(&builder, u8"あ") == true);
+        assert(m_utf8_builder_append_int(&builder, -42) == true);
+        assert(m_utf8_builder_append_unicode(&builder, 0x1F680) == true);
+        assert(strcmp(buf, u8"あ-42🚀") == 0);
+        assert(builder.byte_size == 10 && builder.char_count == 5 && builder.display_width == 7);
+        assert(m_utf8_builder_append_unicode(&builder, 0xD800) == false);
+        assert(m_utf8_builder_append_str(&builder, u8"い") == false);
+        assert(builder.truncated == true && builder.byte_size == 10);
+        assert(m_utf8_builder_append_format(&builder, "%s", u8"う") == false);
+        assert(builder.byte_size == 10 && buf[10] == '\0');
+        assert(m_utf8_builder_append_format(&builder, "%d", 7) == true);
+        assert(strcmp(buf, u8"あ-42🚀7") == 0 && builder.char_count == 6);
+        m_utf8_builder_truncate(&builder, 9);
+        assert(strcmp(buf, u8"あ-42") == 0);
+        assert(builder.char_count == 4 && builder.display_width == 5);
+    }
+    {
+        m_utf8_builder_t builder;
+        assert(m_utf8_builder_init_alloc(&builder, 0) == true);
+        for (int i = 0; i < 1000; i++)
+        {
+            assert(m_utf8_builder_append_str(&builder, u8"あいう") == true);
+        }
+        assert(m_utf8_builder_append_format(&builder, "%s%d", u8"え", 100) == true);
+        assert(builder.byte_size == 9006 && builder.truncated == false);
+        assert(m_utf8_str_validate(builder.buf, builder.byte_size + 1) == true);
+        m_utf8_builder_free(&builder);
+        assert(builder.buf == NULL);
+
+        // the capacity does not overflow, the append is truncated
+        m_char8_t big[64];
+        memset(big, 'a', sizeof(big));
+        assert(m_utf8_builder_init_alloc(&builder, 0) == true);
+        assert(m_utf8_builder_append(&builder, big, 8) == true);
+        assert(m_utf8_builder_append(&builder, big, SIZE_MAX - 4) == false);
+        assert(builder.truncated == true && builder.byte_size == 15 && builder.buf[15] == '\0');
+        m_utf8_builder_free(&builder);
+    }
+    // test m_utf8_mem_fit_width
+    {
+        m_utf8_stat_t stat;
+        m_char8_t dst[32];
+        m_char8_t src[] = u8"aあいう"; // 10 bytes, 7 columns
+        assert(m_utf8_mem_truncate_width(dst, sizeof(dst), src, 10, 7, NULL, &stat) == true);
+        assert(strcmp(dst, src) == 0 && stat.byte_size == 10 && stat.display_width == 7);
+        assert(m_utf8_mem_truncate_width(dst, sizeof(dst), src, 10, 4, NULL, &stat) == false);
+        assert(strcmp(dst, u8"aあ") == 0 && stat.display_width == 3 && stat.char_count == 2);
+        assert(m_utf8_mem_truncate_width(dst, 5, src, 10, 7, NULL, &stat) == false);
+        assert(strcmp(dst, u8"aあ") == 0 && stat.byte_size == 4);
+        assert(m_utf8_mem_pad_width(dst, sizeof(dst), src, 10, 4, M_UTF8_ALIGN_LEFT, NULL, &stat) == false);
+        assert(strcmp(dst, u8"aあ ") == 0 && stat.display_width == 4);
+        assert(m_utf8_mem_pad_width(dst, sizeof(dst), src, 4, 6, M_UTF8_ALIGN_RIGHT, NULL, &stat) == true);
+        assert(strcmp(dst, u8"   aあ") == 0 && stat.char_count == 5);
+        assert(m_utf8_mem_pad_width(dst, sizeof(dst), src, 4, 6, M_UTF8_ALIGN_CENTER, NULL, &stat) == true);
+        assert(strcmp(dst, u8" aあ  ") == 0);
+        assert(m_utf8_mem_ellipsize_width(dst, sizeof(dst), src, 10, 7, NULL, NULL, &stat) == true);
+        assert(strcmp(dst, src) == 0);
+        assert(m_utf8_mem_ellipsize_width(dst, sizeof(dst), src, 10, 6, NULL, NULL, &stat) == false);
+        assert(strcmp(dst, u8"aあ…") == 0 && stat.display_width == 5);
+        assert(m_utf8_mem_ellipsize_width(dst, sizeof(dst), src, 10, 6, NULL, m_utf8_width_profile(false, true),
+                                          &stat) == false);
+        assert(strcmp(dst, u8"aあい…") == 0 && stat.display_width == 6);
+        assert(m_utf8_mem_fit_width(dst, sizeof(dst), src, 10, 5, M_UTF8_ALIGN_LEFT, "...", NULL, &stat) == false);
+        assert(strcmp(dst, u8"a... ") == 0 && stat.display_width == 5);
+        assert(m_utf8_mem_fit_width(dst, 0, src, 10, 6, M_UTF8_ALIGN_LEFT, NULL, NULL, &stat) == false);
+        assert(stat.byte_size == 0);
+        // dst is too small for the padding, the text is kept and the padding is cut
+        assert(m_utf8_mem_fit_width(dst, 5, "ab", 2, 10, M_UTF8_ALIGN_LEFT, NULL, NULL, &stat) == true);
+        assert(strcmp(dst, "ab  ") == 0 && stat.display_width == 4 && stat.char_count == 4);
+        assert(m_utf8_mem_pad_width(dst, 8, "abc", 3, 10, M_UTF8_ALIGN_RIGHT, NULL, &stat) == true);
+        assert(strcmp(dst, "    abc") == 0 && stat.byte_size == 7);
+        assert(m_utf8_mem_pad_width(dst, 8, "abc", 3, 10, M_UTF8_ALIGN_CENTER, NULL, &stat) == true);
+        assert(strcmp(dst, "  abc  ") == 0);
+        assert(m_utf8_mem_pad_width(dst, 5, src, 10, 7, M_UTF8_ALIGN_LEFT, NULL, &stat) == false);
+        assert(strcmp(dst, u8"aあ") == 0 && stat.display_width == 3);
+        assert(m_utf8_mem_pad_width(dst, 5, "", 0, 10, M_UTF8_ALIGN_LEFT, NULL, &stat) == true);
+        assert(strcmp(dst, "    ") == 0);
+        assert(m_utf8_mem_fit_width(dst, 6, src, 10, 6, M_UTF8_ALIGN_RIGHT, "...", NULL, &stat) == false);
+        assert(strcmp(dst, u8" a...") == 0 && stat.display_width == 5);
+    }
+    // test m_utf8_mem_grapheme_count
+    {
+        m_char8_t *str1 = "\u30DB\u309A"; // combine string 'ポ'
+        assert(m_utf8_str_grapheme_count(str1, 7) == 1);
+        m_char8_t *str2 = u8"a\r\nb"; // CR LF is one cluster
+        assert(m_utf8_mem_grapheme_count(str2, 4) == 3);
+        m_char8_t *str3 = u8"👨\u200D👩\u200D👧"; // ZWJ sequence
+        assert(m_utf8_mem_grapheme_count(str3, strlen(str3)) == 1);
+        m_char8_t *str4 = u8"🇯🇵🇺🇸🇫"; // flags and a single regional indicator
+        assert(m_utf8_mem_grapheme_count(str4, strlen(str4)) == 3);
+        m_char8_t *str5 = u8"\u1100\u1161\u11A8\uAC00\u11A8"; // Hangul jamo and syllable
+        assert(m_utf8_mem_grapheme_count(str5, strlen(str5)) == 2);
+        m_char8_t *str6 = u8"👍🏽e\u0301\u0915\u093F"; // emoji modifier, combining mark and spacing mark
+        assert(m_utf8_mem_grapheme_count(str6, strlen(str6)) == 3);
+        m_char8_t str7[] = u8"0123456789abcdef\r\n0123456789abcde\r\n\xe3"; // ASCII blocks and invalid
+        assert(m_utf8_mem_grapheme_count(str7, sizeof(str7) - 1) == 34);
+        assert(m_utf8_str_grapheme_count(u8"\u0301a", 4) == 2);
+        assert(m_utf8_mem_grapheme_count(str1, 0) == 0);
+    }
+
+    // test m_utf8_grapheme_next
+    {
+        m_char8_t *str1 = u8"e\u0301\r\n🇯🇵x";
+        size_t size1 = strlen(str1);
+        assert(m_utf8_grapheme_next(str1, size1, 0) == 3);
+        assert(m_utf8_grapheme_next(str1, size1, 3) == 5);
+        assert(m_utf8_grapheme_next(str1, size1, 5) == 13);
+        assert(m_utf8_grapheme_next(str1, size1, 13) == 14);
+        assert(m_utf8_grapheme_next(str1, size1, 14) == 14);
+    }
+    // test m_utf8_mem_stat_parallel
+    {
+        size_t size = 5 * 1024 * 1024 + 3;
+        m_char8_t *str = malloc(size + 1);
+        for (size_t i = 0; i < size; i += 3)
+        {
+            memcpy(str + i, i % 7 ? u8"あ" : "abc", 3);
+        }
+        str[size] = '\0';
+        m_utf8_stat_t stat;
+        m_utf8_stat_t stat_parallel;
+        assert(m_utf8_mem_validate_parallel(str, size, 4) == true);
+        assert(m_utf8_str_validate_parallel(str, size + 1, 4) == true);
+        assert(m_utf8_mem_display_count_parallel(str, size, 4) == m_utf8_mem_display_count(str, size));
+        assert(m_utf8_mem_stat_parallel(str, size, NULL, &stat_parallel, 0) == true);
+        m_utf8_mem_stat(str, size, NULL, &stat);
+        assert(memcmp(&stat, &stat_parallel, sizeof(stat)) == 0);
+
+        // invalid characters which cover the chunk boundaries
+        for (size_t i = 1; i <= 4; i++)
+        {
+            memset(str + i * 1024 * 1024 - 2, 0xF0 + (m_char8_t)i, 5);
+        }
+        str[size - 2] = (m_char8_t)0xE3;
+        assert(m_utf8_mem_validate_parallel(str, size, 4) == false);
+        assert(m_utf8_mem_display_count_parallel(str, size, 4) == m_utf8_mem_display_count(str, size));
+        assert(m_utf8_mem_stat_parallel(str, size, NULL, &stat_parallel, 4) == false);
+        m_utf8_mem_stat(str, size, NULL, &stat);
+        assert(memcmp(&stat, &stat_parallel, sizeof(stat)) == 0);
+        free(str);
+    }
+    // test m_utf8_mem_to_utf16
+    {
+        m_utf8_conv_t conv;
+        uint16_t dst[64];
+        m_char8_t *str1 = u8"aé€🚀あいうえおかきくけこさし0123456789abcdef"; // 4 bytes character is a surrogate pair
+        size_t size1 = strlen(str1);
+        assert(m_utf8_mem_utf16_size(str1, size1) == 33);
+        assert(m_utf8_mem_to_utf16(str1, size1, dst, 64, &conv) == true);
+        assert(conv.dst_written == 33 && conv.src_read == (int64_t)size1 && conv.error_offset == -1);
+        assert(dst[0] == 'a' && dst[1] == 0x00E9 && dst[2] == 0x20AC);
+        assert(dst[3] == 0xD83D && dst[4] == 0xDE80 && dst[5] == 0x3042 && dst[32] == 'f');
+        assert(m_utf8_mem_to_utf16(str1, size1, dst, 4, &conv) == false);
+        assert(conv.dst_written == 3 && conv.src_read == 6 && conv.error_offset == -1);
+
+        m_char8_t str2[] = u8"éééééééééééé\xed\xa0\x80"; // surrogate is invalid
+        assert(m_utf8_mem_to_utf16(str2, sizeof(str2) - 1, dst, 64, &conv) == false);
+        assert(conv.dst_written == 12 && conv.error_offset == 24);
+    }
+    // test m_utf8_from_unicode
+    {
+        m_char8_t character[4];
+        assert(m_utf8_from_unicode(0x41, character) == 1 && character[0] == 'A');
+        assert(m_utf8_from_unicode(0x3042, character) == 3 && memcmp(character, u8"あ", 3) == 0);
+        assert(m_utf8_from_unicode(0x1F680, character) == 4 && memcmp(character, u8"🚀", 4) == 0);
+        assert(m_utf8_from_unicode(0xD800, character) == 0);
+        assert(m_utf8_from_unicode(0xFFFF, character) == 0);
+        assert(m_utf8_from_unicode(0x110000, character) == 0);
+    }
+
+    // test m_utf8_mem_from_unicode
+    {
+        m_utf8_conv_t conv;
+        m_char8_t dst[64];
+        uint32_t src1[] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f', 0xE9, 0x1F680};
+        assert(m_utf8_size_from_unicode(src1, 18) == 22);
+        assert(m_utf8_mem_from_unicode(src1, 18, dst, 64, &conv) == true);
+        assert(conv.src_read == 18 && conv.dst_written == 22 && conv.error_offset == -1);
+        assert(memcmp(dst, u8"0123456789abcdefé🚀", 22) == 0);
+        assert(m_utf8_mem_from_unicode(src1, 18, dst, 20, &conv) == false);
+        assert(conv.src_read == 17 && conv.dst_written == 18 && conv.error_offset == -1);
+        uint32_t src2[] = {'a', 0xDC00, 'b'};
+        assert(m_utf8_mem_from_unicode(src2, 3, dst, 64, &conv) == false);
+        assert(conv.src_read == 1 && conv.error_offset == 1);
+    }
+
+    // test m_utf8_mem_from_utf16
+    {
+        m_utf8_conv_t conv;
+        m_char8_t dst[64];
+        uint16_t src1[] = {'a', 0xE9, 0x3042, 0xD83D, 0xDE80};
+        assert(m_utf8_size_from_utf16(src1, 5) == 10);
+        assert(m_utf8_mem_from_utf16(src1, 5, dst, 64, &conv) == true);
+        assert(conv.src_read == 5 && conv.dst_written == 10 && memcmp(dst, u8"aéあ🚀", 10) == 0);
+        assert(m_utf8_mem_from_utf16(src1, 4, dst, 64, &conv) == false); // lone high surrogate
+        assert(conv.src_read == 3 && conv.dst_written == 6 && conv.error_offset == 3);
+    }
+
+    // test m_utf8_set_simd_level
+    {
+        m_char8_t str[300];
+        uint32_t unicode[300];
+        uint16_t utf16[300];
+        m_utf8_conv_t conv;
+        m_utf8_stat_t stat;
+        m_utf8_simd_t supported = m_utf8_simd_supported();
+        assert(m_utf8_simd_level() <= supported);
+
+        // 128 bytes ASCII, a 3 bytes character across a 64 bytes block, 4 bytes characters and an error at the end
+        memset(str, 'a', 128);
+        memcpy(str + 62, u8"あ", 3);
+        for (int i = 0; i < 20; i++)
+        {
+            memcpy(str + 128 + i * 4, u8"🚀", 4);
+        }
+        memcpy(str + 208, u8"ééééééééééééééééあいうえおかきくけこ\xef\xbf\xbe", 65);
+        size_t size = 273;
+        for (int level = M_UTF8_SIMD_SCALAR; level <= M_UTF8_SIMD_AVX512; level++)
+        {
+            m_utf8_simd_t applied = m_utf8_set_simd_level((m_utf8_simd_t)level);
+            assert(applied == ((m_utf8_simd_t)level < supported ? (m_utf8_simd_t)level : supported));
+            assert(m_utf8_simd_level() == applied);
+            assert(m_utf8_mem_validate(str, size - 3) == true);
+            assert(m_utf8_mem_validate(str, size) == false);
+            assert(m_utf8_mem_display_count(str, size) == 126 + 20 + 16 + 10 + 1);
+            assert(m_utf8_mem_stat(str, size, NULL, &stat) == false);
+            assert(stat.char_count == 173 && stat.display_width == 125 + 2 + 40 + 32 + 20 + 1);
+            assert(stat.error_offset == 270);
+            assert(m_utf8_mem_to_unicode(str, size, unicode, 300, &conv) == false);
+            assert(conv.dst_written == 172 && conv.error_offset == 270 && unicode[62] == 0x3042);
+            assert(m_utf8_mem_to_utf16(str, size, utf16, 300, &conv) == false);
+            assert(conv.dst_written == 192 && conv.error_offset == 270 && utf16[126] == 0xD83D);
+        }
+        m_utf8_set_simd_level(supported);
+    }
+
+    // test m_utf8_index_build
+    {
+        m_utf8_index_t index;
+        m_char8_t str[64] = u8"aéあ🚀bcdefg";
+        size_t size = strlen(str);
+        assert(m_utf8_index_build(&index, str, size, 2) == true);
+        assert(index.char_count == 10 && index.byte_size == (int64_t)size);
+        assert(m_utf8_index_byte_offset(&index, str, 0) == 0);
+        assert(m_utf8_index_byte_offset(&index, str, 3) == 6);
+        assert(m_utf8_index_byte_offset(&index, str, 4) == 10);
+        assert(m_utf8_index_byte_offset(&index, str, 10) == (int64_t)size);
+        assert(m_utf8_index_byte_offset(&index, str, 11) == -1);
+        assert(m_utf8_index_char_index(&index, str, 7) == 3); // inside 🚀
+        assert(m_utf8_index_char_index(&index, str, (int64_t)size) == 10);
+
+        // replace "é" with "xyz"
+        memmove(str + 4, str + 3, size - 3 + 1);
+        memcpy(str + 1, "xyz", 3);
+        size += 1;
+        assert(m_utf8_index_update(&index, str, size, 1, 2, 3) == true);
+        assert(index.char_count == 12);
+        assert(m_utf8_index_byte_offset(&index, str, 4) == 4);
+        assert(m_utf8_index_byte_offset(&index, str, 6) == 11);
+        assert(m_utf8_index_char_index(&index, str, 9) == 5 && m_utf8_index_char_index(&index, str, 11) == 6);
+        assert(m_utf8_index_update(&index, str, size, 1, 100, 0) == false); // edit is out of the buffer
+        m_utf8_index_free(&index);
+    }
+    {
+        m_utf8_index_t index;
+        m_char8_t str[] = "abcdefghij";
+        size_t size = strlen(str);
+
+        // a deletion of a whole gap drops the checkpoint after it
+        assert(m_utf8_index_build(&index, str, size, 1) == true && index.point_count == 10);
+        for (int i = 0; i < 5; i++)
+        {
+            memmove(str + 2, str + 3, size - 3 + 1);
+            size--;
+            assert(m_utf8_index_update(&index, str, size, 2, 1, 0) == true);
+        }
+        assert(strcmp(str, "abhij") == 0 && index.char_count == 5 && index.point_count == 5);
+        assert(m_utf8_index_byte_offset(&index, str, 3) == 3 && m_utf8_index_char_index(&index, str, 4) == 4);
+        m_utf8_index_free(&index);
+    }
+
+    // test m_utf8_index_build_width
+    {
+        m_utf8_index_t index;
+        m_char8_t str[64] = u8"abあいcd🚀e";
+        size_t size = strlen(str);
+        assert(m_utf8_index_build_width(&index, str, size, 2, NULL) == true);
+        assert(index.char_count == 8 && index.display_width == 11);
+        assert(m_utf8_index_column(&index, str, 2) == 2);
+        assert(m_utf8_index_column(&index, str, 6) == 4); // inside い
+        assert(m_utf8_index_column(&index, str, 10) == 8);
+        assert(m_utf8_index_column(&index, str, (int64_t)size) == 11);
+        assert(m_utf8_index_column_offset(&index, str, 3) == 2); // 2nd column of あ
+        assert(m_utf8_index_column_offset(&index, str, 8) == 10);
+        assert(m_utf8_index_column_offset(&index, str, 10) == 14);
+        assert(m_utf8_index_column_offset(&index, str, 11) == (int64_t)size);
+
+        // insert "う" before "c"
+        memmove(str + 11, str + 8, size - 8 + 1);
+        memcpy(str + 8, u8"う", 3);
+        size += 3;
+        assert(m_utf8_index_update(&index, str, size, 8, 0, 3) == true);
+        assert(index.display_width == 13);
+        assert(m_utf8_index_column(&index, str, 13) == 10);
+        assert(m_utf8_index_column_offset(&index, str, 12) == 17);
+        m_utf8_index_free(&index);
+
+        assert(m_utf8_index_build(&index, str, size, 0) == true);
+        assert(m_utf8_index_column(&index, str, 0) == -1); // width is not tracked
+        m_utf8_index_free(&index);
+    }
+
+    // test m_utf8_ch_next, m_utf8_ch_prev
+    {
+        const m_char8_t *str = u8"aあ\xE3\x81" "b\xEF\xBF\xBE\x80🚀";
+        size_t size = strlen(str);
+        size_t offsets[] = {0, 1, 4, 6, 7, 10, 11, 15};
+        uint32_t unicodes[] = {'a', 0x3042, M_UTF8_REPLACEMENT_CHARACTER, 'b', M_UTF8_REPLACEMENT_CHARACTER,
+                               M_UTF8_REPLACEMENT_CHARACTER, 0x1F680};
+        bool valids[] = {true, true, false, true, false, false, true};
+        size_t offset = 0;
+        uint32_t unicode;
+        bool valid;
+        for (size_t i = 0; i < 7; i++)
+        {
+            assert(offset == offsets[i]);
+            offset += m_utf8_ch_next(str + offset, size - offset, &unicode, &valid);
+            assert(unicode == unicodes[i]);
+            assert(valid == valids[i]);
+        }
+        assert(offset == size);
+        assert(m_utf8_ch_next(str + offset, 0, &unicode, NULL) == 0);
+        for (size_t i = 7; i > 0; i--)
+        {
+            offset = m_utf8_ch_prev(str, offset);
+            assert(offset == offsets[i - 1]);
+        }
+        assert(m_utf8_ch_prev(str, 0) == 0);
+    }
+
+    // test m_utf8_mem_sanitize
+    {
+        // Unicode Table 3-8, U+FFFD for each maximal subpart
+        const m_char8_t *src = "a\xF1\x80\x80\xE1\x80\xC2" "b\x80" "c\x80\xBF" "d";
+        m_char8_t dst[64];
+        m_utf8_conv_t conv;
+        assert(m_utf8_mem_sanitize(dst, sizeof(dst), src, strlen(src), M_UTF8_SANITIZE_REPLACE, &conv) == 6);
+        assert(conv.src_read == (int64_t)strlen(src) && conv.error_offset == 1);
+        assert(conv.dst_written == 4 + 6 * 3);
+        assert(memcmp(dst, u8"a\uFFFD\uFFFD\uFFFDb\uFFFDc\uFFFD\uFFFDd", conv.dst_written) == 0);
+
+        assert(m_utf8_mem_sanitize(dst, sizeof(dst), src, strlen(src), M_UTF8_SANITIZE_DROP, &conv) == 6);
+        assert(conv.dst_written == 4 && memcmp(dst, "abcd", 4) == 0);
+
+        // noncharacter and truncated character are one subpart
+        src = u8"あ\xEF\xBF\xBE" "a\xF0\x9F\x9A";
+        assert(m_utf8_mem_sanitize(dst, sizeof(dst), src, strlen(src), M_UTF8_SANITIZE_REPLACE, &conv) == 2);
+        assert(conv.dst_written == 10 && memcmp(dst, u8"あ\uFFFDa\uFFFD", 10) == 0);
+
+        // valid is copied as is
+        src = u8"aあ🚀";
+        assert(m_utf8_mem_sanitize(dst, sizeof(dst), src, strlen(src), M_UTF8_SANITIZE_REPLACE, &conv) == 0);
+        assert(conv.dst_written == 8 && conv.error_offset == -1 && memcmp(dst, src, 8) == 0);
+
+        // dst is full on a character boundary
+        assert(m_utf8_mem_sanitize(dst, 5, src, strlen(src), M_UTF8_SANITIZE_REPLACE, &conv) == -1);
+        assert(conv.src_read == 4 && conv.dst_written == 4);
+        assert(m_utf8_mem_sanitize(dst, 3, "a\xFF", 2, M_UTF8_SANITIZE_REPLACE, &conv) == -1);
+        assert(conv.src_read == 1 && conv.dst_written == 1);
+        assert(m_utf8_mem_sanitize(dst, 1, "a\xFF", 2, M_UTF8_SANITIZE_DROP, &conv) == 1);
+        assert(conv.src_read == 2 && conv.dst_written == 1);
+    }
+
+    // test m_utf8_mem_normalize
+    {
+        m_char8_t dst[64];
+        m_utf8_conv_t conv;
+        const m_char8_t *src = u8"ポとé";
+
+        assert(m_utf8_mem_normalize(dst, sizeof(dst), src, strlen(src), M_UTF8_NORM_NFC, &conv));
+        assert(conv.src_read == (int64_t)strlen(src) && conv.error_offset == -1);
+        assert(conv.dst_written == 8 && memcmp(dst, u8"ポとé", 8) == 0);
+        assert(m_utf8_mem_normalize(dst, sizeof(dst), u8"ポとé", 8, M_UTF8_NORM_NFD, &conv));
+        assert(conv.dst_written == (int64_t)strlen(src) && memcmp(dst, src, strlen(src)) == 0);
+
+        // Hangul syllable and jamo
+        assert(m_utf8_mem_normalize(dst, sizeof(dst), u8"한", 3, M_UTF8_NORM_NFD, &conv));
+        assert(conv.dst_written == 9 && memcmp(dst, u8"한", 9) == 0);
+        assert(m_utf8_mem_normalize(dst, sizeof(dst), u8"한", 9, M_UTF8_NORM_NFC, &conv));
+        assert(conv.dst_written == 3 && memcmp(dst, u8"한", 3) == 0);
+
+        // canonical ordering, then composition
+        src = u8"ạ́";
+        assert(m_utf8_mem_normalize(dst, sizeof(dst), src, strlen(src), M_UTF8_NORM_NFC, &conv));
+        assert(conv.dst_written == 5 && memcmp(dst, u8"ạ́", 5) == 0);
+        assert(m_utf8_mem_normalize(dst, sizeof(dst), src, strlen(src), M_UTF8_NORM_NFD, &conv));
+        assert(conv.dst_written == 5 && memcmp(dst, u8"ạ́", 5) == 0);
+
+        // singleton and composition exclusion
+        assert(m_utf8_mem_normalize(dst, sizeof(dst), u8"Åक़", 6, M_UTF8_NORM_NFC, &conv));
+        assert(conv.dst_written == 8 && memcmp(dst, u8"Åक़", 8) == 0);
+
+        // stops before the invalid character
+        assert(!m_utf8_mem_normalize(dst, sizeof(dst), "e\xCC\x81\xFF", 4, M_UTF8_NORM_NFC, &conv));
+        assert(conv.src_read == 3 && conv.dst_written == 2 && conv.error_offset == 3);
+
+        // dst is full on a segment boundary
+        src = u8"abcdé";
+        assert(!m_utf8_mem_normalize(dst, 5, src, strlen(src), M_UTF8_NORM_NFC, &conv));
+        assert(conv.src_read == 4 && conv.dst_written == 4 && conv.error_offset == -1);
+        assert(!m_utf8_mem_normalize(dst, 3, u8"éé", 6, M_UTF8_NORM_NFC, &conv));
+        assert(conv.src_read == 3 && conv.dst_written == 2);
+
+        // long text is copied by the fast path
+        m_char8_t long_src[300];
+        m_char8_t long_dst[sizeof(long_src) * 3];
+        memset(long_src, 'a', sizeof(long_src));
+        memcpy(long_src + 200, u8"é", 3);
+        assert(m_utf8_mem_normalize(long_dst, sizeof(long_dst), long_src, sizeof(long_src), M_UTF8_NORM_NFC, &conv));
+        assert(conv.dst_written == (int64_t)sizeof(long_src) - 1);
+        assert(memcmp(long_dst, long_src, 200) == 0 && memcmp(long_dst + 200, u8"é", 2) == 0);
+        assert(memcmp(long_dst + 202, long_src + 203, sizeof(long_src) - 203) == 0);
+
+        // a run of precomposed characters is normalized in chunks of dst
+        m_char8_t hangul_src[200 * 3];
+        m_char8_t hangul_dst[1024];
+        size_t hangul_read = 0;
+        size_t hangul_count = 0;
+        for (size_t i = 0; i < sizeof(hangul_src); i += 3)
+            memcpy(hangul_src + i, u8"각", 3);
+        while (!m_utf8_mem_normalize(hangul_dst, sizeof(hangul_dst), hangul_src + hangul_read,
+                                     sizeof(hangul_src) - hangul_read, M_UTF8_NORM_NFD, &conv))
+        {
+            assert(conv.src_read > 0 && conv.dst_written == conv.src_read * 3 && conv.dst_written > 1000);
+            hangul_read += (size_t)conv.src_read;
+            hangul_count += (size_t)conv.src_read / 3;
+        }
+        assert(hangul_read + (size_t)conv.src_read == sizeof(hangul_src));
+        assert(hangul_count + (size_t)conv.src_read / 3 == 200 && memcmp(hangul_dst, "\xE1\x84\x80\xE1\x85\xA1\xE1\x86\xA8", 9) == 0);
+
+        // U+0F73 is a starter, but reordered with the mark before it
+        assert(m_utf8_mem_normalize(dst, sizeof(dst), "\xE0\xBD\x80\xE0\xBD\xB4\xE0\xBD\xB3", 9, M_UTF8_NORM_NFD, &conv));
+        assert(conv.dst_written == 12 && memcmp(dst, "\xE0\xBD\x80\xE0\xBD\xB1\xE0\xBD\xB2\xE0\xBD\xB4", 12) == 0);
+        assert(!m_utf8_mem_is_normalized("\xE0\xBD\x80\xE0\xBD\xB4\xE0\xBD\xB1\xE0\xBD\xB2", 12, M_UTF8_NORM_NFD));
+    }
+
+    // test m_utf8_mem_norm_quick_check, m_utf8_mem_is_normalized
+    {
+        const m_char8_t *nfc = u8"aあ한é\U0001F680";
+        const m_char8_t *nfd = u8"aあ한é\U0001F680";
+
+        assert(m_utf8_mem_norm_quick_check(nfc, strlen(nfc), M_UTF8_NORM_NFC) == (int64_t)strlen(nfc));
+        assert(m_utf8_mem_norm_quick_check(nfc, strlen(nfc), M_UTF8_NORM_NFD) == 1);
+        assert(m_utf8_mem_norm_quick_check(nfd, strlen(nfd), M_UTF8_NORM_NFD) == (int64_t)strlen(nfd));
+        assert(m_utf8_mem_norm_quick_check(nfd, strlen(nfd), M_UTF8_NORM_NFC) == 4);
+        assert(m_utf8_mem_is_normalized(nfc, strlen(nfc), M_UTF8_NORM_NFC));
+        assert(!m_utf8_mem_is_normalized(nfc, strlen(nfc), M_UTF8_NORM_NFD));
+        assert(m_utf8_mem_is_normalized(nfd, strlen(nfd), M_UTF8_NORM_NFD));
+        assert(!m_utf8_mem_is_normalized(nfd, strlen(nfd), M_UTF8_NORM_NFC));
+
+        // Maybe in quick check, but normalized
+        assert(m_utf8_mem_norm_quick_check(u8"̀́", 4, M_UTF8_NORM_NFC) == 0);
+        assert(m_utf8_mem_is_normalized(u8"̀́", 4, M_UTF8_NORM_NFC));
+        assert(m_utf8_mem_is_normalized(u8"ạ́́", 7, M_UTF8_NORM_NFD));
+        assert(!m_utf8_mem_is_normalized(u8"ạ́", 5, M_UTF8_NORM_NFD));
+        assert(!m_utf8_mem_is_normalized("a\xFF", 2, M_UTF8_NORM_NFC));
+        assert(m_utf8_mem_norm_quick_check("a\xFF", 2, M_UTF8_NORM_NFC) == 1);
+        assert(m_utf8_mem_is_normalized("", 0, M_UTF8_NORM_NFC));
+    }
+
+    // test m_utf8_mem_find, m_utf8_mem_find_all, m_utf8_mem_count
+    {
+        const m_char8_t *str = u8"GET /items あいう ERROR Error error あいう";
+        size_t size = strlen(str);
+        size_t match_bytesize;
+        int64_t offsets[4];
+
+        assert(m_utf8_mem_find(str, size, "error", 5, M_UTF8_SEARCH_EXACT, &match_bytesize) == 33);
+        assert(match_bytesize == 5);
+        assert(m_utf8_mem_find(str, size, "ERROR", 5, M_UTF8_SEARCH_IGNORE_CASE, NULL) == 21);
+        assert(m_utf8_mem_find(str, size, u8"いう", 6, M_UTF8_SEARCH_EXACT, NULL) == 14);
+        assert(m_utf8_mem_find(str, size, "warn", 4, M_UTF8_SEARCH_EXACT, &match_bytesize) == -1);
+        assert(match_bytesize == 0);
+        assert(m_utf8_mem_count(str, size, "error", 5, M_UTF8_SEARCH_IGNORE_CASE) == 3);
+        assert(m_utf8_mem_count(str, size, u8"あいう", 9, M_UTF8_SEARCH_EXACT) == 2);
+        assert(m_utf8_mem_find_all(str, size, "Error", 5, M_UTF8_SEARCH_IGNORE_CASE, offsets, 2) == 3);
+        assert(offsets[0] == 21 && offsets[1] == 27);
+
+        // a match does not start in a character, and empty or invalid pattern is not searched
+        assert(m_utf8_mem_find(u8"あ", 3, "\x81\x82", 2, M_UTF8_SEARCH_EXACT, NULL) == -1);
+        assert(m_utf8_mem_count(str, size, "", 0, M_UTF8_SEARCH_EXACT) == -1);
+        assert(m_utf8_mem_find_all(str, size, "\xFF", 1, M_UTF8_SEARCH_EXACT, NULL, 0) == -1);
+
+        // matches do not overlap
+        assert(m_utf8_mem_count("aaaa", 4, "aa", 2, M_UTF8_SEARCH_EXACT) == 2);
+        assert(m_utf8_mem_count("aAaAa", 5, "A", 1, M_UTF8_SEARCH_IGNORE_CASE) == 5);
+
+        // simple case folding of other scripts, and of the code points of other byte size
+        assert(m_utf8_unicode_fold('K') == 'k' && m_utf8_unicode_fold(0x212A) == 'k');
+        assert(m_utf8_unicode_fold(0x1E9E) == 0xDF && m_utf8_unicode_fold(0xDF) == 0xDF);
+        assert(m_utf8_unicode_fold(0x3C2) == 0x3C3 && m_utf8_unicode_fold(0x3042) == 0x3042);
+        assert(m_utf8_mem_find(u8"ΣΟΦΊΑ", 10, u8"σοφία", 10, M_UTF8_SEARCH_IGNORE_CASE, NULL) == 0);
+        assert(m_utf8_mem_find(u8"Ébène", 7, u8"éBÈNE", 7, M_UTF8_SEARCH_IGNORE_CASE, NULL) == 0);
+        assert(m_utf8_mem_find(u8"x \u212Aelvin", 10, "kelvin", 6, M_UTF8_SEARCH_IGNORE_CASE, &match_bytesize) == 2);
+        assert(match_bytesize == 8);
+        assert(m_utf8_mem_find("x Kelvin", 8, u8"\u212Aelvin", 8, M_UTF8_SEARCH_IGNORE_CASE, &match_bytesize) == 2);
+        assert(match_bytesize == 6);
+        assert(m_utf8_mem_find(u8"straße", 7, "STRASSE", 7, M_UTF8_SEARCH_IGNORE_CASE, NULL) == -1);
+
+        // invalid characters are skipped, and not matched
+        assert(m_utf8_mem_find("\xE3\x81" "a\xFF" "A", 5, "a", 1, M_UTF8_SEARCH_EXACT, NULL) == 2);
+        assert(m_utf8_mem_count("\xE3\x81" "a\xFF" "A", 5, "A", 1, M_UTF8_SEARCH_IGNORE_CASE) == 2);
+        assert(m_utf8_mem_find("\xFF", 1, u8"\uFFFD", 3, M_UTF8_SEARCH_IGNORE_CASE, NULL) == -1);
+
+        // long text is searched by blocks, long pattern is verified after the probes
+        m_char8_t text[300];
+        m_char8_t pattern[100];
+        memset(text, '-', sizeof(text));
+        memset(pattern, '-', sizeof(pattern));
+        memcpy(text + 250, "Needle", 6);
+        memcpy(pattern + sizeof(pattern) - 6, "nEEDLE", 6);
+        assert(m_utf8_mem_find(text, sizeof(text), "needle", 6, M_UTF8_SEARCH_IGNORE_CASE, NULL) == 250);
+        assert(m_utf8_mem_find(text, sizeof(text), "Needle", 6, M_UTF8_SEARCH_EXACT, NULL) == 250);
+        assert(m_utf8_mem_find(text, sizeof(text), pattern, sizeof(pattern), M_UTF8_SEARCH_IGNORE_CASE, NULL) == 156);
+        assert(m_utf8_mem_find(text, sizeof(text), pattern, sizeof(pattern), M_UTF8_SEARCH_EXACT, NULL) == -1);
+        assert(m_utf8_mem_count(text, sizeof(text), "--", 2, M_UTF8_SEARCH_EXACT) == 125 + 22);
+    }
+
+    // test m_utf8_stats_snapshot, m_utf8_stats_reset
+    {
+        m_utf8_stats_t stats;
+#if defined(M_UTF8_STATS)
+        m_char8_t *str = u8"abcéあ😀";
+        size_t size = strlen(str);
+        m_utf8_stat_t stat;
+
+        m_utf8_stats_reset();
+        assert(m_utf8_stats_snapshot(&stats) == true);
+        assert(stats.api_calls[M_UTF8_STATS_STAT] == 0 && stats.char_count[0] == 0 && stats.invalid_count == 0);
+
+        // characters by byte size, and the width table lookups of the characters which are not ASCII
+        assert(m_utf8_mem_stat(str, size, NULL, &stat) == true);
+        assert(m_utf8_stats_snapshot(&stats) == true);
+        assert(stats.api_calls[M_UTF8_STATS_STAT] == 1 && stats.api_bytes[M_UTF8_STATS_STAT] == size);
+        assert(stats.char_count[0] == 3 && stats.char_count[1] == 1 && stats.char_count[2] == 1 &&
+               stats.char_count[3] == 1);
+        assert(stats.width_lookups[0] + stats.width_lookups[2] == 1);
+        assert(stats.width_lookups[1] == 1 && stats.width_lookups[3] == 1);
+        assert(stats.invalid_count == 0);
+
+        assert(m_utf8_mem_validate("a\xFF", 2) == false);
+        assert(m_utf8_stats_snapshot(&stats) == true);
+        assert(stats.api_calls[M_UTF8_STATS_VALIDATE] == 1 && stats.api_bytes[M_UTF8_STATS_VALIDATE] == 2);
+        assert(stats.invalid_count == 1);
+
+        // the counters of the worker threads are kept after the threads exit
+        size_t big_size = 3 << 20;
+        m_char8_t *big = malloc(big_size);
+        assert(big != NULL);
+        memset(big, 'a', big_size);
+        m_utf8_stats_reset();
+        assert(m_utf8_mem_display_count_parallel(big, big_size, 3) == (int64_t)big_size);
+        assert(m_utf8_stats_snapshot(&stats) == true);
+        assert(stats.api_calls[M_UTF8_STATS_COUNT] >= 1 && stats.api_bytes[M_UTF8_STATS_COUNT] == big_size);
+        assert(stats.char_count[0] == big_size);
+        assert(m_utf8_simd_level() == M_UTF8_SIMD_SCALAR || (stats.fast_blocks > 0 && stats.slow_blocks == 0));
+        free(big);
+
+        m_utf8_stats_reset();
+        assert(m_utf8_stats_snapshot(&stats) == true);
+        assert(stats.api_calls[M_UTF8_STATS_COUNT] == 0 && stats.char_count[0] == 0 && stats.fast_blocks == 0);
+#else
+        // the library without M_UTF8_STATS does not count
+        m_utf8_stats_reset();
+        assert(m_utf8_mem_validate("a\xFF", 2) == false);
+        assert(m_utf8_stats_snapshot(&stats) == false);
+        assert(stats.api_calls[M_UTF8_STATS_VALIDATE] == 0 && stats.invalid_count == 0);
+#endif
+    }
     return 0;
-}
\ No newline at end of file
+}
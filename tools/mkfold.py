@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+"""Generate mutf8_fold_table.h, the simple case folding tables of mutf8_search.c.
+
+The data is derived from the python unicodedata module( CaseFolding.txt, status C and S):
+
+  - the folded code point is the code point plus a delta, packed into a two stage table
+    same as mutf8_width_table.h:
+
+        c + m_utf8_fold_delta[stage2[stage1[c >> SHIFT] << SHIFT | (c & MASK)]]
+
+    delta 0 is a code point which is folded to itself, most code points.
+  - the code points which are not folded to themselves, sorted by the folded code point,
+    so that every code point folded to the same one( 'k', 'K' and U+212A KELVIN SIGN) is found.
+
+str.casefold() is the full folding( status C and F). a code point is folded by it when it is one code point,
+otherwise by str.lower() when it is one code point( status S), otherwise it is not folded( status F and T only).
+
+usage: tools/mkfold.py > mutf8_fold_table.h
+"""
+
+import sys
+import unicodedata
+
+# unicode of the tables, regenerate them with a python of the same unicodedata.
+UNICODE_VERSION = '14.0.0'
+
+SHIFT = 8
+MAX_UNICODE = 0x10FFFF
+
+
+def simple_fold(c):
+    folded = chr(c).casefold()
+    if len(folded) == 1:
+        return ord(folded)
+    lower = chr(c).lower()
+    return ord(lower) if len(lower) == 1 else c
+
+
+def classify():
+    folds = {}
+    for c in range(MAX_UNICODE + 1):
+        if 0xD800 <= c < 0xE000:
+            continue
+        folded = simple_fold(c)
+        if folded != c:
+            folds[c] = folded
+    for folded in folds.values():
+        assert simple_fold(folded) == folded
+    return folds
+
+
+def build(folds):
+    deltas = [0]
+    delta_index = {0: 0}
+    values = bytearray(MAX_UNICODE + 1)
+    for c, folded in folds.items():
+        delta = folded - c
+        if delta not in delta_index:
+            delta_index[delta] = len(deltas)
+            deltas.append(delta)
+        values[c] = delta_index[delta]
+    assert len(deltas) <= 256
+
+    block_size = 1 << SHIFT
+    blocks = {}
+    stage1 = []
+    stage2 = bytearray()
+    for first in range(0, MAX_UNICODE + 1, block_size):
+        block = bytes(values[first:first + block_size])
+        if block not in blocks:
+            blocks[block] = len(blocks)
+            stage2 += block
+        stage1.append(blocks[block])
+    assert len(blocks) <= 256
+    return deltas, stage1, stage2
+
+
+def dump(name, values, per_line=16):
+    lines = ['static const uint8_t %s[%d] = {' % (name, len(values))]
+    for i in range(0, len(values), per_line):
+        lines.append('    ' + ', '.join('%d' % v for v in values[i:i + per_line]) + ',')
+    lines.append('};')
+    return '\n'.join(lines)
+
+
+def main():
+    if unicodedata.unidata_version != UNICODE_VERSION:
+        sys.exit('mkfold.py: unicodedata is unicode %s, not %s' % (unicodedata.unidata_version, UNICODE_VERSION))
+    folds = classify()
+    deltas, stage1, stage2 = build(folds)
+    unfolds = sorted((folded, c) for c, folded in folds.items())
+
+    print('/* generated by tools/mkfold.py, do not edit. */')
+    print('#ifndef MUTF8_FOLD_TABLE_H')
+    print('#define MUTF8_FOLD_TABLE_H')
+    print()
+    print('/* unicode %s */' % UNICODE_VERSION)
+    print('#define M_UTF8_FOLD_SHIFT %d' % SHIFT)
+    print('#define M_UTF8_FOLD_MASK 0x%X' % ((1 << SHIFT) - 1))
+    print()
+    print('struct m_utf8_fold_unfold')
+    print('{')
+    print('    uint32_t folded;')
+    print('    uint32_t unicode; /* a code point folded to folded */')
+    print('};')
+    print()
+    print('// clang-format off')
+    print('static const int32_t m_utf8_fold_delta[%d] = {' % len(deltas))
+    for i in range(0, len(deltas), 8):
+        print('    ' + ' '.join('%d,' % delta for delta in deltas[i:i + 8]))
+    print('};')
+    print()
+    print(dump('m_utf8_fold_stage1', stage1))
+    print()
+    print(dump('m_utf8_fold_stage2', stage2, 32))
+    print()
+    print('static const struct m_utf8_fold_unfold m_utf8_fold_unfold[%d] = {' % len(unfolds))
+    for i in range(0, len(unfolds), 4):
+        print('    ' + ' '.join('{0x%05X, 0x%05X},' % entry for entry in unfolds[i:i + 4]))
+    print('};')
+    print('// clang-format on')
+    print()
+    print('#endif /* end MUTF8_FOLD_TABLE_H */')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,197 @@
+#!/usr/bin/env python3
+"""Generate mutf8_grapheme_table.h, the grapheme cluster break property table of mutf8_grapheme.c.
+
+The properties follow UAX #29 "Grapheme_Cluster_Break" and the emoji
+"Extended_Pictographic" property. They are derived from the general categories
+of the python unicodedata module, and from the lists below for the properties
+which are not derived from the categories
+(https://www.unicode.org/Public/14.0.0/ucd/PropList.txt,
+https://www.unicode.org/Public/14.0.0/ucd/auxiliary/GraphemeBreakProperty.txt,
+https://www.unicode.org/Public/14.0.0/ucd/emoji/emoji-data.txt).
+
+The properties are packed into a two stage table same as mutf8_width_table.h:
+
+    stage2[stage1[c >> SHIFT] << SHIFT | (c & MASK)]
+
+Hangul syllables are all M_UTF8_GB_LV in the table, LVT is decided by the
+code point in mutf8_grapheme.c, so the table keeps small.
+
+usage: tools/mkgrapheme.py > mutf8_grapheme_table.h
+"""
+
+import sys
+import unicodedata
+
+# unicode of the tables, regenerate them with a python of the same unicodedata.
+UNICODE_VERSION = '14.0.0'
+
+SHIFT = 8
+MAX_UNICODE = 0x10FFFF
+
+# property ids, same order as UAX #29.
+PROPERTIES = [
+    'OTHER', 'CR', 'LF', 'CONTROL', 'EXTEND', 'ZWJ', 'REGIONAL_INDICATOR', 'PREPEND',
+    'SPACINGMARK', 'L', 'V', 'T', 'LV', 'LVT', 'EXTENDED_PICTOGRAPHIC',
+]
+P = {name: i for i, name in enumerate(PROPERTIES)}
+
+# PropList.txt "Other_Grapheme_Extend".
+OTHER_GRAPHEME_EXTEND = [
+    (0x009BE, 0x009BE), (0x009D7, 0x009D7), (0x00B3E, 0x00B3E), (0x00B57, 0x00B57),
+    (0x00BBE, 0x00BBE), (0x00BD7, 0x00BD7), (0x00CC2, 0x00CC2), (0x00CD5, 0x00CD6),
+    (0x00D3E, 0x00D3E), (0x00D57, 0x00D57), (0x00DCF, 0x00DCF), (0x00DDF, 0x00DDF),
+    (0x01B35, 0x01B35), (0x0200C, 0x0200C), (0x0302E, 0x0302F), (0x0FF9E, 0x0FF9F),
+    (0x1133E, 0x1133E), (0x11357, 0x11357), (0x114B0, 0x114B0), (0x114BD, 0x114BD),
+    (0x115AF, 0x115AF), (0x11930, 0x11930), (0x1D165, 0x1D165), (0x1D16E, 0x1D172),
+    (0xE0020, 0xE007F),
+]
+
+# GraphemeBreakProperty.txt "Prepend".
+PREPEND = [
+    (0x00600, 0x00605), (0x006DD, 0x006DD), (0x0070F, 0x0070F), (0x00890, 0x00891),
+    (0x008E2, 0x008E2), (0x00D4E, 0x00D4E), (0x110BD, 0x110BD), (0x110CD, 0x110CD),
+    (0x111C2, 0x111C3), (0x1193F, 0x1193F), (0x11941, 0x11941), (0x11A3A, 0x11A3A),
+    (0x11A84, 0x11A89), (0x11D46, 0x11D46),
+]
+
+# GraphemeBreakProperty.txt, "Mc" which are not "SpacingMark".
+NOT_SPACINGMARK = [
+    (0x0102B, 0x0102C), (0x01038, 0x01038), (0x01062, 0x01064), (0x01067, 0x0106D),
+    (0x01083, 0x01083), (0x01087, 0x0108C), (0x0108F, 0x0108F), (0x0109A, 0x0109C),
+    (0x01A61, 0x01A61), (0x01A63, 0x01A64), (0x0AA7B, 0x0AA7B), (0x0AA7D, 0x0AA7D),
+    (0x11720, 0x11721),
+]
+
+# GraphemeBreakProperty.txt, "SpacingMark" which are not "Mc".
+SPACINGMARK = [(0x00E33, 0x00E33), (0x00EB3, 0x00EB3)]
+
+# GraphemeBreakProperty.txt, unassigned "Control".
+CONTROL = [(0x02065, 0x02065), (0x0FFF0, 0x0FFF8), (0xE0000, 0xE0000), (0xE0002, 0xE001F),
+           (0xE0080, 0xE00FF), (0xE01F0, 0xE0FFF)]
+
+# GraphemeBreakProperty.txt, Hangul jamo.
+HANGUL = [
+    ('L', 0x01100, 0x0115F), ('L', 0x0A960, 0x0A97C), ('V', 0x01160, 0x011A7),
+    ('V', 0x0D7B0, 0x0D7C6), ('T', 0x011A8, 0x011FF), ('T', 0x0D7CB, 0x0D7FB),
+    ('LV', 0x0AC00, 0x0D7A3),
+]
+
+# emoji-data.txt "Extended_Pictographic".
+EXTENDED_PICTOGRAPHIC = [
+    (0x000A9, 0x000A9), (0x000AE, 0x000AE), (0x0203C, 0x0203C), (0x02049, 0x02049),
+    (0x02122, 0x02122), (0x02139, 0x02139), (0x02194, 0x02199), (0x021A9, 0x021AA),
+    (0x0231A, 0x0231B), (0x02328, 0x02328), (0x02388, 0x02388), (0x023CF, 0x023CF),
+    (0x023E9, 0x023F3), (0x023F8, 0x023FA), (0x024C2, 0x024C2), (0x025AA, 0x025AB),
+    (0x025B6, 0x025B6), (0x025C0, 0x025C0), (0x025FB, 0x025FE), (0x02600, 0x02605),
+    (0x02607, 0x02612), (0x02614, 0x02685), (0x02690, 0x02705), (0x02708, 0x02712),
+    (0x02714, 0x02714), (0x02716, 0x02716), (0x0271D, 0x0271D), (0x02721, 0x02721),
+    (0x02728, 0x02728), (0x02733, 0x02734), (0x02744, 0x02744), (0x02747, 0x02747),
+    (0x0274C, 0x0274C), (0x0274E, 0x0274E), (0x02753, 0x02755), (0x02757, 0x02757),
+    (0x02763, 0x02767), (0x02795, 0x02797), (0x027A1, 0x027A1), (0x027B0, 0x027B0),
+    (0x027BF, 0x027BF), (0x02934, 0x02935), (0x02B05, 0x02B07), (0x02B1B, 0x02B1C),
+    (0x02B50, 0x02B50), (0x02B55, 0x02B55), (0x03030, 0x03030), (0x0303D, 0x0303D),
+    (0x03297, 0x03297), (0x03299, 0x03299), (0x1F000, 0x1F0FF), (0x1F10D, 0x1F10F),
+    (0x1F12F, 0x1F12F), (0x1F16C, 0x1F171), (0x1F17E, 0x1F17F), (0x1F18E, 0x1F18E),
+    (0x1F191, 0x1F19A), (0x1F1AD, 0x1F1E5), (0x1F201, 0x1F20F), (0x1F21A, 0x1F21A),
+    (0x1F22F, 0x1F22F), (0x1F232, 0x1F23A), (0x1F23C, 0x1F23F), (0x1F249, 0x1F3FA),
+    (0x1F400, 0x1F53D), (0x1F546, 0x1F64F), (0x1F680, 0x1F6FF), (0x1F774, 0x1F77F),
+    (0x1F7D5, 0x1F7FF), (0x1F80C, 0x1F80F), (0x1F848, 0x1F84F), (0x1F85A, 0x1F85F),
+    (0x1F888, 0x1F88F), (0x1F8AE, 0x1F8FF), (0x1F90C, 0x1F93A), (0x1F93C, 0x1F945),
+    (0x1F947, 0x1FAFF), (0x1FC00, 0x1FFFD),
+]
+
+
+def in_ranges(ranges):
+    table = bytearray(MAX_UNICODE + 1)
+    for first, last in ranges:
+        table[first:last + 1] = b'\1' * (last - first + 1)
+    return table
+
+
+def classify():
+    other_extend = in_ranges(OTHER_GRAPHEME_EXTEND)
+    prepend = in_ranges(PREPEND)
+    not_spacingmark = in_ranges(NOT_SPACINGMARK)
+    spacingmark = in_ranges(SPACINGMARK)
+    control = in_ranges(CONTROL)
+    pictographic = in_ranges(EXTENDED_PICTOGRAPHIC)
+
+    properties = bytearray(MAX_UNICODE + 1)
+    for c in range(MAX_UNICODE + 1):
+        category = unicodedata.category(chr(c))
+        if c == 0x0D:
+            p = 'CR'
+        elif c == 0x0A:
+            p = 'LF'
+        elif c == 0x200D:
+            p = 'ZWJ'
+        elif prepend[c]:
+            p = 'PREPEND'
+        elif category in ('Mn', 'Me') or other_extend[c] or 0x1F3FB <= c <= 0x1F3FF:
+            p = 'EXTEND'
+        elif category in ('Cc', 'Cf', 'Zl', 'Zp', 'Cs') or control[c]:
+            p = 'CONTROL'
+        elif 0x1F1E6 <= c <= 0x1F1FF:
+            p = 'REGIONAL_INDICATOR'
+        elif (category == 'Mc' and not not_spacingmark[c]) or spacingmark[c]:
+            p = 'SPACINGMARK'
+        elif pictographic[c]:
+            p = 'EXTENDED_PICTOGRAPHIC'
+        else:
+            p = 'OTHER'
+        properties[c] = P[p]
+    for name, first, last in HANGUL:
+        properties[first:last + 1] = bytes([P[name]]) * (last - first + 1)
+    return properties
+
+
+def build(properties):
+    block_size = 1 << SHIFT
+    blocks = {}
+    stage1 = []
+    stage2 = bytearray()
+    for first in range(0, MAX_UNICODE + 1, block_size):
+        block = bytes(properties[first:first + block_size])
+        if block not in blocks:
+            blocks[block] = len(blocks)
+            stage2 += block
+        stage1.append(blocks[block])
+    assert len(blocks) <= 256
+    return stage1, stage2
+
+
+def dump(name, values, per_line=16):
+    lines = ['static const uint8_t %s[%d] = {' % (name, len(values))]
+    for i in range(0, len(values), per_line):
+        lines.append('    ' + ', '.join('%d' % v for v in values[i:i + per_line]) + ',')
+    lines.append('};')
+    return '\n'.join(lines)
+
+
+def main():
+    if unicodedata.unidata_version != UNICODE_VERSION:
+        sys.exit('mkgrapheme.py: unicodedata is unicode %s, not %s' % (unicodedata.unidata_version, UNICODE_VERSION))
+    stage1, stage2 = build(classify())
+    print('/* generated by tools/mkgrapheme.py, do not edit. */')
+    print('#ifndef MUTF8_GRAPHEME_TABLE_H')
+    print('#define MUTF8_GRAPHEME_TABLE_H')
+    print()
+    print('/* unicode %s */' % UNICODE_VERSION)
+    print('#define M_UTF8_GB_SHIFT %d' % SHIFT)
+    print('#define M_UTF8_GB_MASK 0x%X' % ((1 << SHIFT) - 1))
+    print()
+    for i, name in enumerate(PROPERTIES):
+        print('#define M_UTF8_GB_%s %d' % (name, i))
+    print('#define M_UTF8_GB_PROPERTY_SIZE %d' % len(PROPERTIES))
+    print()
+    print('// clang-format off')
+    print(dump('m_utf8_grapheme_stage1', stage1))
+    print()
+    print(dump('m_utf8_grapheme_stage2', stage2, 32))
+    print('// clang-format on')
+    print()
+    print('#endif /* end MUTF8_GRAPHEME_TABLE_H */')
+
+
+if __name__ == '__main__':
+    main()
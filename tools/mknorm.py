@@ -0,0 +1,305 @@
+#!/usr/bin/env python3
+"""Generate mutf8_norm_table.h, the canonical normalization tables of mutf8_norm.c.
+
+The data is derived from the python unicodedata module( UAX #15, NFC and NFD):
+
+  - property of each code point, packed into a two stage table same as mutf8_width_table.h:
+
+        m_utf8_norm_property[stage2[stage1[c >> SHIFT] << SHIFT | (c & MASK)]]
+
+    property 0 is a starter which is NFC_QC=Yes and NFD_QC=Yes, most code points.
+    the others have the canonical combining class and the quick check flags.
+  - full canonical decomposition of each code point, sorted by code point.
+  - primary composites, sorted by the pair of code points.
+
+  - the first two bytes of the characters which are not a starter of Yes, a bitmap for each form:
+
+        bit of lead << 6 | (second & 0x3F)
+
+    a bit is for a code point of two bytes, 64 code points of three bytes and 4096 code points of four bytes.
+    the bits of ascii and continuation leads are 0, so a block of bytes is tested without decoding.
+  - the same pairs as 8 boxes of nibbles for a SIMD shuffle, for each form:
+
+        nibbles[0][lead >> 4] & nibbles[1][lead & 0xF] & nibbles[2][second >> 4] & nibbles[3][second & 0xF]
+
+    is not 0 for every pair of the bitmap. the boxes are merged greedily,
+    so that the pairs of common scripts( COMMON) are seldom in a box.
+
+Hangul syllables are decomposed and composed by the code point in mutf8_norm.c,
+so they are not in the decomposition and composition tables.
+
+usage: tools/mknorm.py > mutf8_norm_table.h
+"""
+
+import sys
+import unicodedata
+
+# unicode of the tables, regenerate them with a python of the same unicodedata.
+UNICODE_VERSION = '14.0.0'
+
+SHIFT = 8
+MAX_UNICODE = 0x10FFFF
+
+S_BASE, L_BASE, V_BASE, T_BASE = 0xAC00, 0x1100, 0x1161, 0x11A7
+L_COUNT, V_COUNT, T_COUNT = 19, 21, 28
+S_COUNT = L_COUNT * V_COUNT * T_COUNT
+
+# quick check flags of m_utf8_norm_property.
+FLAGS = ['NFD_NO', 'NFC_NO', 'NFC_MAYBE']
+F = {name: 1 << i for i, name in enumerate(FLAGS)}
+
+
+def is_hangul_syllable(c):
+    return S_BASE <= c < S_BASE + S_COUNT
+
+
+def canonical_mapping(c):
+    """raw canonical decomposition mapping, None when none."""
+    decomposition = unicodedata.decomposition(chr(c))
+    if not decomposition or decomposition.startswith('<'):
+        return None
+    return [int(x, 16) for x in decomposition.split()]
+
+
+def classify():
+    compositions = {}
+    second = set(range(V_BASE, V_BASE + V_COUNT)) | set(range(T_BASE + 1, T_BASE + T_COUNT))
+    decompositions = {}
+    for c in range(MAX_UNICODE + 1):
+        if 0xD800 <= c <= 0xDFFF or is_hangul_syllable(c):
+            continue
+        mapping = canonical_mapping(c)
+        if mapping is None:
+            continue
+        decompositions[c] = [ord(x) for x in unicodedata.normalize('NFD', chr(c))]
+        # primary composite, not excluded from the composition.
+        if len(mapping) == 2 and unicodedata.normalize('NFC', chr(c)) == chr(c):
+            compositions[(mapping[0], mapping[1])] = c
+            second.add(mapping[1])
+
+    properties = {}
+    for c in range(MAX_UNICODE + 1):
+        if 0xD800 <= c <= 0xDFFF:
+            continue
+        ccc = unicodedata.combining(chr(c))
+        flags = 0
+        if c in decompositions or is_hangul_syllable(c):
+            flags |= F['NFD_NO']
+        if unicodedata.normalize('NFC', chr(c)) != chr(c):
+            flags |= F['NFC_NO']
+        elif c in second:
+            flags |= F['NFC_MAYBE']
+        if ccc != 0 or flags != 0:
+            properties[c] = (ccc, flags)
+    return properties, decompositions, compositions
+
+
+def build(properties):
+    records = [(0, 0)]
+    record_index = {(0, 0): 0}
+    values = bytearray(MAX_UNICODE + 1)
+    for c, record in properties.items():
+        if record not in record_index:
+            record_index[record] = len(records)
+            records.append(record)
+        values[c] = record_index[record]
+    assert len(records) <= 256
+
+    block_size = 1 << SHIFT
+    blocks = {}
+    stage1 = []
+    stage2 = bytearray()
+    for first in range(0, MAX_UNICODE + 1, block_size):
+        block = bytes(values[first:first + block_size])
+        if block not in blocks:
+            blocks[block] = len(blocks)
+            stage2 += block
+        stage1.append(blocks[block])
+    assert len(blocks) <= 256
+    return records, stage1, stage2
+
+
+def build_pairs(properties, no_mask):
+    bits = [0] * (256 * 64 // 32)
+    for c, (ccc, flags) in properties.items():
+        if c < 0x80 or (ccc == 0 and (flags & no_mask) == 0):
+            continue
+        encoded = chr(c).encode('utf-8')
+        index = encoded[0] << 6 | (encoded[1] & 0x3F)
+        bits[index >> 5] |= 1 << (index & 31)
+    return bits
+
+
+def dump_pairs(name, bits):
+    lines = ['static const uint32_t %s[%d] = {' % (name, len(bits))]
+    for i in range(0, len(bits), 8):
+        lines.append('    ' + ' '.join('0x%08X,' % v for v in bits[i:i + 8]))
+    lines.append('};')
+    return '\n'.join(lines)
+
+
+# code points of common text, a pair of these is expensive in a box.
+COMMON = [(0x00A0, 0x024F), (0x0370, 0x04FF), (0x1E00, 0x1EFF), (0x2000, 0x206F), (0x3000, 0x30FF),
+          (0x4E00, 0x9FFF), (0xAC00, 0xD7A3), (0xFF00, 0xFFEF), (0x1F300, 0x1FAFF)]
+
+
+def pair_weights():
+    """weight of each pair( lead, second), 1 + 100 for each common code point of the pair."""
+    weights = {}
+    for c in range(0x80, MAX_UNICODE + 1):
+        if 0xD800 <= c <= 0xDFFF:
+            continue
+        encoded = chr(c).encode('utf-8')
+        pair = (encoded[0], encoded[1])
+        common = any(first <= c <= last for first, last in COMMON)
+        weights[pair] = weights.get(pair, 1) + (100 if common else 0)
+    return weights
+
+
+def build_nibbles(bits, weights, box_count=8):
+    """cover the pairs of bits with box_count boxes of nibble sets, and return the 4 x 16 tables."""
+    pairs = set()
+    for index in range(len(bits) * 32):
+        if bits[index >> 5] >> (index & 31) & 1:
+            pairs.add((index >> 6, 0x80 | (index & 0x3F)))
+    # a box is 4 bitmasks of the nibbles, and the cost is the weight of its pairs not in bits.
+    safe = [((1 << (lead >> 4)), (1 << (lead & 0xF)), (1 << (second >> 4)), (1 << (second & 0xF)), weight)
+            for (lead, second), weight in weights.items() if (lead, second) not in pairs]
+
+    def cost(box):
+        return sum(weight for a, b, c, d, weight in safe
+                   if box[0] & a and box[1] & b and box[2] & c and box[3] & d)
+
+    def merge(first, second):
+        return tuple(a | b for a, b in zip(first, second))
+
+    # start from the rows of a lead and the high nibble of the second byte.
+    rows = {}
+    for lead, second in pairs:
+        row = rows.setdefault((lead, second >> 4), [1 << (lead >> 4), 1 << (lead & 0xF), 1 << (second >> 4), 0])
+        row[3] |= 1 << (second & 0xF)
+    boxes = {tuple(row): cost(tuple(row)) for row in rows.values()}
+    increases = {}
+    while len(boxes) > box_count:
+        items = sorted(boxes)
+        for i, first in enumerate(items):
+            for second in items[i + 1:]:
+                if (first, second) not in increases:
+                    increases[(first, second)] = cost(merge(first, second)) - boxes[first] - boxes[second]
+        first, second = min(increases, key=lambda key: (increases[key], key))
+        merged = merge(first, second)
+        del boxes[first], boxes[second]
+        increases = {key: value for key, value in increases.items() if first not in key and second not in key}
+        boxes[merged] = cost(merged)
+
+    tables = [[0] * 16 for _ in range(4)]
+    for bit, box in enumerate(sorted(boxes)):
+        for table, nibbles in zip(tables, box):
+            for nibble in range(16):
+                if nibbles >> nibble & 1:
+                    table[nibble] |= 1 << bit
+    for lead, second in pairs:
+        assert tables[0][lead >> 4] & tables[1][lead & 0xF] & tables[2][second >> 4] & tables[3][second & 0xF]
+    return tables
+
+
+def dump_nibbles(name, tables):
+    lines = ['static const uint8_t %s[4][16] = {' % name]
+    for table in tables:
+        lines.append('    {' + ', '.join('0x%02X' % v for v in table) + '},')
+    lines.append('};')
+    return '\n'.join(lines)
+
+
+def dump(name, values, per_line=16):
+    lines = ['static const uint8_t %s[%d] = {' % (name, len(values))]
+    for i in range(0, len(values), per_line):
+        lines.append('    ' + ', '.join('%d' % v for v in values[i:i + per_line]) + ',')
+    lines.append('};')
+    return '\n'.join(lines)
+
+
+def main():
+    if unicodedata.unidata_version != UNICODE_VERSION:
+        sys.exit('mknorm.py: unicodedata is unicode %s, not %s' % (unicodedata.unidata_version, UNICODE_VERSION))
+    properties, decompositions, compositions = classify()
+    records, stage1, stage2 = build(properties)
+
+    pool = []
+    entries = []
+    for c in sorted(decompositions):
+        entries.append((c, len(pool), len(decompositions[c])))
+        pool += decompositions[c]
+    assert len(pool) < 0x10000 and max(size for _, _, size in entries) <= 4
+
+    print('/* generated by tools/mknorm.py, do not edit. */')
+    print('#ifndef MUTF8_NORM_TABLE_H')
+    print('#define MUTF8_NORM_TABLE_H')
+    print()
+    print('/* unicode %s */' % UNICODE_VERSION)
+    print('#define M_UTF8_NORM_SHIFT %d' % SHIFT)
+    print('#define M_UTF8_NORM_MASK 0x%X' % ((1 << SHIFT) - 1))
+    print()
+    for name in FLAGS:
+        print('#define M_UTF8_NORM_%s 0x%02X' % (name, F[name]))
+    print()
+    print('struct m_utf8_norm_property')
+    print('{')
+    print('    uint8_t ccc;   /* canonical combining class */')
+    print('    uint8_t flags; /* M_UTF8_NORM_NFD_NO, M_UTF8_NORM_NFC_NO and M_UTF8_NORM_NFC_MAYBE */')
+    print('};')
+    print()
+    print('struct m_utf8_norm_decomposition')
+    print('{')
+    print('    uint32_t unicode;')
+    print('    uint16_t offset; /* offset in m_utf8_norm_decomposition_pool */')
+    print('    uint16_t size;   /* code point count( 1 to 4) */')
+    print('};')
+    print()
+    print('struct m_utf8_norm_composition')
+    print('{')
+    print('    uint32_t first;')
+    print('    uint32_t second;')
+    print('    uint32_t composite;')
+    print('};')
+    print()
+    print('// clang-format off')
+    print('static const struct m_utf8_norm_property m_utf8_norm_property[%d] = {' % len(records))
+    for i in range(0, len(records), 8):
+        print('    ' + ' '.join('{%d, 0x%X},' % record for record in records[i:i + 8]))
+    print('};')
+    print()
+    print(dump('m_utf8_norm_stage1', stage1))
+    print()
+    print(dump('m_utf8_norm_stage2', stage2, 32))
+    print()
+    weights = pair_weights()
+    for form, no_mask in (('nfc', F['NFC_NO'] | F['NFC_MAYBE']), ('nfd', F['NFD_NO'])):
+        bits = build_pairs(properties, no_mask)
+        print(dump_pairs('m_utf8_norm_%s_pairs' % form, bits))
+        print()
+        print(dump_nibbles('m_utf8_norm_%s_nibbles' % form, build_nibbles(bits, weights)))
+        print()
+    print('static const struct m_utf8_norm_decomposition m_utf8_norm_decomposition[%d] = {' % len(entries))
+    for i in range(0, len(entries), 4):
+        print('    ' + ' '.join('{0x%05X, %d, %d},' % entry for entry in entries[i:i + 4]))
+    print('};')
+    print()
+    print('static const uint32_t m_utf8_norm_decomposition_pool[%d] = {' % len(pool))
+    for i in range(0, len(pool), 8):
+        print('    ' + ' '.join('0x%05X,' % c for c in pool[i:i + 8]))
+    print('};')
+    print()
+    pairs = sorted(compositions.items())
+    print('static const struct m_utf8_norm_composition m_utf8_norm_composition[%d] = {' % len(pairs))
+    for i in range(0, len(pairs), 3):
+        print('    ' + ' '.join('{0x%05X, 0x%05X, 0x%05X},' % (first, second, composite)
+                                for (first, second), composite in pairs[i:i + 3]))
+    print('};')
+    print('// clang-format on')
+    print()
+    print('#endif /* end MUTF8_NORM_TABLE_H */')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,193 @@
+#!/usr/bin/env python3
+"""Generate mutf8_width_table.h, the display width lookup table of mutf8.c.
+
+The range tables below are the source of the table. They come from uemacs
+(https://github.com/cxxxr/uemacs/blob/master/utf8.c, "te eastasian_full[]"
+and "te eastasian_ambiguous[]") and from the emoji list
+(http://unicode.org/emoji/charts/emoji-list.html).
+
+Every code point gets a width class, and the classes are packed into a two
+stage table indexed by the code point bits:
+
+    stage2[stage1[c >> SHIFT] << SHIFT | (c & MASK)]
+
+usage: tools/mkwidth.py > mutf8_width_table.h
+"""
+
+SHIFT = 8
+MAX_UNICODE = 0x10FFFF
+
+# class ids. when the ranges overlap, FULL wins, then EMOJI, then AMBIGUOUS:
+# an emoji in the ambiguous ranges( U+1F18E, U+1F191..U+1F19A) follows the emoji width.
+NARROW = 0
+FULL = 1
+AMBIGUOUS = 2
+EMOJI = 3
+
+# author: cxxxr, base var is "te eastasian_full[]".
+EASTASIAN_FULL = [
+    (0x01100, 0x0115f), (0x02329, 0x0232a), (0x02e80, 0x02e99), (0x02e9b, 0x02ef3),
+    (0x02f00, 0x02fd5), (0x02ff0, 0x02ffb), (0x03000, 0x0303e), (0x03041, 0x03096),
+    (0x03099, 0x030ff), (0x03105, 0x0312d), (0x03131, 0x0318e), (0x03190, 0x031ba),
+    (0x031c0, 0x031e3), (0x031f0, 0x0321e), (0x03220, 0x03247), (0x03250, 0x032fe),
+    (0x03300, 0x04dbf), (0x04e00, 0x0a48c), (0x0a490, 0x0a4c6), (0x0a960, 0x0a97c),
+    (0x0ac00, 0x0d7a3), (0x0f900, 0x0faff), (0x0fe10, 0x0fe19), (0x0fe30, 0x0fe52),
+    (0x0fe54, 0x0fe66), (0x0fe68, 0x0fe6b), (0x0ff01, 0x0ff60), (0x0ffe0, 0x0ffe6),
+    (0x1b000, 0x1b001), (0x1f200, 0x1f202), (0x1f210, 0x1f23a), (0x1f240, 0x1f248),
+    (0x1f250, 0x1f251), (0x20000, 0x2fffd), (0x30000, 0x3fffd),
+]
+
+# author: cxxxr, base var is "te eastasian_ambiguous[]".
+EASTASIAN_AMBIGUOUS = [
+    (0x000a1, 0x000a1), (0x000a4, 0x000a4), (0x000a7, 0x000a8), (0x000aa, 0x000aa),
+    (0x000ad, 0x000ae), (0x000b0, 0x000b4), (0x000b6, 0x000ba), (0x000bc, 0x000bf),
+    (0x000c6, 0x000c6), (0x000d0, 0x000d0), (0x000d7, 0x000d8), (0x000de, 0x000e1),
+    (0x000e6, 0x000e6), (0x000e8, 0x000ea), (0x000ec, 0x000ed), (0x000f0, 0x000f0),
+    (0x000f2, 0x000f3), (0x000f7, 0x000fa), (0x000fc, 0x000fc), (0x000fe, 0x000fe),
+    (0x00101, 0x00101), (0x00111, 0x00111), (0x00113, 0x00113), (0x0011b, 0x0011b),
+    (0x00126, 0x00127), (0x0012b, 0x0012b), (0x00131, 0x00133), (0x00138, 0x00138),
+    (0x0013f, 0x00142), (0x00144, 0x00144), (0x00148, 0x0014b), (0x0014d, 0x0014d),
+    (0x00152, 0x00153), (0x00166, 0x00167), (0x0016b, 0x0016b), (0x001ce, 0x001ce),
+    (0x001d0, 0x001d0), (0x001d2, 0x001d2), (0x001d4, 0x001d4), (0x001d6, 0x001d6),
+    (0x001d8, 0x001d8), (0x001da, 0x001da), (0x001dc, 0x001dc), (0x00251, 0x00251),
+    (0x00261, 0x00261), (0x002c4, 0x002c4), (0x002c7, 0x002c7), (0x002c9, 0x002cb),
+    (0x002cd, 0x002cd), (0x002d0, 0x002d0), (0x002d8, 0x002db), (0x002dd, 0x002dd),
+    (0x002df, 0x002df), (0x00300, 0x0036f), (0x00391, 0x003a1), (0x003a3, 0x003a9),
+    (0x003b1, 0x003c1), (0x003c3, 0x003c9), (0x00401, 0x00401), (0x00410, 0x0044f),
+    (0x00451, 0x00451), (0x02010, 0x02010), (0x02013, 0x02016), (0x02018, 0x02019),
+    (0x0201c, 0x0201d), (0x02020, 0x02022), (0x02024, 0x02027), (0x02030, 0x02030),
+    (0x02032, 0x02033), (0x02035, 0x02035), (0x0203b, 0x0203b), (0x0203e, 0x0203e),
+    (0x02074, 0x02074), (0x0207f, 0x0207f), (0x02081, 0x02084), (0x020ac, 0x020ac),
+    (0x02103, 0x02103), (0x02105, 0x02105), (0x02109, 0x02109), (0x02113, 0x02113),
+    (0x02116, 0x02116), (0x02121, 0x02122), (0x02126, 0x02126), (0x0212b, 0x0212b),
+    (0x02153, 0x02154), (0x0215b, 0x0215e), (0x02160, 0x0216b), (0x02170, 0x02179),
+    (0x02189, 0x02189), (0x02190, 0x02199), (0x021b8, 0x021b9), (0x021d2, 0x021d2),
+    (0x021d4, 0x021d4), (0x021e7, 0x021e7), (0x02200, 0x02200), (0x02202, 0x02203),
+    (0x02207, 0x02208), (0x0220b, 0x0220b), (0x0220f, 0x0220f), (0x02211, 0x02211),
+    (0x02215, 0x02215), (0x0221a, 0x0221a), (0x0221d, 0x02220), (0x02223, 0x02223),
+    (0x02225, 0x02225), (0x02227, 0x0222c), (0x0222e, 0x0222e), (0x02234, 0x02237),
+    (0x0223c, 0x0223d), (0x02248, 0x02248), (0x0224c, 0x0224c), (0x02252, 0x02252),
+    (0x02260, 0x02261), (0x02264, 0x02267), (0x0226a, 0x0226b), (0x0226e, 0x0226f),
+    (0x02282, 0x02283), (0x02286, 0x02287), (0x02295, 0x02295), (0x02299, 0x02299),
+    (0x022a5, 0x022a5), (0x022bf, 0x022bf), (0x02312, 0x02312), (0x02460, 0x024e9),
+    (0x024eb, 0x0254b), (0x02550, 0x02573), (0x02580, 0x0258f), (0x02592, 0x02595),
+    (0x025a0, 0x025a1), (0x025a3, 0x025a9), (0x025b2, 0x025b3), (0x025b6, 0x025b7),
+    (0x025bc, 0x025bd), (0x025c0, 0x025c1), (0x025c6, 0x025c8), (0x025cb, 0x025cb),
+    (0x025ce, 0x025d1), (0x025e2, 0x025e5), (0x025ef, 0x025ef), (0x02605, 0x02606),
+    (0x02609, 0x02609), (0x0260e, 0x0260f), (0x02614, 0x02615), (0x0261c, 0x0261c),
+    (0x0261e, 0x0261e), (0x02640, 0x02640), (0x02642, 0x02642), (0x02660, 0x02661),
+    (0x02663, 0x02665), (0x02667, 0x0266a), (0x0266c, 0x0266d), (0x0266f, 0x0266f),
+    (0x0269e, 0x0269f), (0x026be, 0x026bf), (0x026c4, 0x026cd), (0x026cf, 0x026e1),
+    (0x026e3, 0x026e3), (0x026e8, 0x026ff), (0x0273d, 0x0273d), (0x02757, 0x02757),
+    (0x02776, 0x0277f), (0x02b55, 0x02b59), (0x03248, 0x0324f), (0x0e000, 0x0f8ff),
+    (0x0fe00, 0x0fe0f), (0x0fffd, 0x0fffd), (0x1f100, 0x1f10a), (0x1f110, 0x1f12d),
+    (0x1f130, 0x1f169), (0x1f170, 0x1f19a), (0xe0100, 0xe01ef), (0xf0000, 0xffffd),
+    (0x100000, 0x10fffd),
+]
+
+# author: FUNABARA Masao, see http://unicode.org/emoji/charts/emoji-list.html
+EMOJI_CJK = [
+    (0x1f004, 0x1f004), (0x1f0cf, 0x1f0cf), (0x1f170, 0x1f171), (0x1f17e, 0x1f17e),
+    (0x1f17f, 0x1f17f), (0x1f18e, 0x1f18e), (0x1f191, 0x1f19a), (0x1f201, 0x1f202),
+    (0x1f21a, 0x1f21a), (0x1f22f, 0x1f22f), (0x1f232, 0x1f23a), (0x1f250, 0x1f251),
+    (0x1f300, 0x1f320), (0x1f321, 0x1f321), (0x1f324, 0x1f32c), (0x1f32d, 0x1f32f),
+    (0x1f330, 0x1f335), (0x1f336, 0x1f336), (0x1f337, 0x1f37c), (0x1f37d, 0x1f37d),
+    (0x1f37e, 0x1f37f), (0x1f380, 0x1f393), (0x1f396, 0x1f397), (0x1f399, 0x1f39b),
+    (0x1f39e, 0x1f39f), (0x1f3a0, 0x1f3c4), (0x1f3c5, 0x1f3c5), (0x1f3c6, 0x1f3ca),
+    (0x1f3cb, 0x1f3ce), (0x1f3cf, 0x1f3d3), (0x1f3d4, 0x1f3df), (0x1f3e0, 0x1f3f0),
+    (0x1f3f3, 0x1f3f5), (0x1f3f7, 0x1f3f7), (0x1f3f8, 0x1f3ff), (0x1f400, 0x1f43e),
+    (0x1f43f, 0x1f43f), (0x1f440, 0x1f440), (0x1f441, 0x1f441), (0x1f442, 0x1f4f7),
+    (0x1f4f8, 0x1f4f8), (0x1f4f9, 0x1f4fc), (0x1f4fd, 0x1f4fd), (0x1f4ff, 0x1f4ff),
+    (0x1f500, 0x1f53d), (0x1f549, 0x1f54a), (0x1f54b, 0x1f54e), (0x1f550, 0x1f567),
+    (0x1f56f, 0x1f570), (0x1f573, 0x1f579), (0x1f57a, 0x1f57a), (0x1f587, 0x1f587),
+    (0x1f58a, 0x1f58d), (0x1f590, 0x1f590), (0x1f595, 0x1f596), (0x1f5a4, 0x1f5a4),
+    (0x1f5a5, 0x1f5a5), (0x1f5a8, 0x1f5a8), (0x1f5b1, 0x1f5b2), (0x1f5bc, 0x1f5bc),
+    (0x1f5c2, 0x1f5c4), (0x1f5d1, 0x1f5d3), (0x1f5dc, 0x1f5de), (0x1f5e1, 0x1f5e1),
+    (0x1f5e3, 0x1f5e3), (0x1f5e8, 0x1f5e8), (0x1f5ef, 0x1f5ef), (0x1f5f3, 0x1f5f3),
+    (0x1f5fa, 0x1f5fa), (0x1f5fb, 0x1f5ff), (0x1f600, 0x1f600), (0x1f601, 0x1f610),
+    (0x1f611, 0x1f611), (0x1f612, 0x1f614), (0x1f615, 0x1f615), (0x1f616, 0x1f616),
+    (0x1f617, 0x1f617), (0x1f618, 0x1f618), (0x1f619, 0x1f619), (0x1f61a, 0x1f61a),
+    (0x1f61b, 0x1f61b), (0x1f61c, 0x1f61e), (0x1f61f, 0x1f61f), (0x1f620, 0x1f625),
+    (0x1f626, 0x1f627), (0x1f628, 0x1f62b), (0x1f62c, 0x1f62c), (0x1f62d, 0x1f62d),
+    (0x1f62e, 0x1f62f), (0x1f630, 0x1f633), (0x1f634, 0x1f634), (0x1f635, 0x1f640),
+    (0x1f641, 0x1f642), (0x1f643, 0x1f644), (0x1f645, 0x1f64f), (0x1f680, 0x1f6c5),
+    (0x1f6cb, 0x1f6cf), (0x1f6d0, 0x1f6d0), (0x1f6d1, 0x1f6d2), (0x1f6e0, 0x1f6e5),
+    (0x1f6e9, 0x1f6e9), (0x1f6eb, 0x1f6ec), (0x1f6f0, 0x1f6f0), (0x1f6f3, 0x1f6f3),
+    (0x1f6f4, 0x1f6f6), (0x1f6f7, 0x1f6f7), (0x1f6f9, 0x1f6f9), (0x1f910, 0x1f918),
+    (0x1f919, 0x1f91e), (0x1f91f, 0x1f91f), (0x1f920, 0x1f927), (0x1f928, 0x1f92f),
+    (0x1f930, 0x1f930), (0x1f931, 0x1f932), (0x1f933, 0x1f93a), (0x1f93c, 0x1f93e),
+    (0x1f940, 0x1f945), (0x1f947, 0x1f94b), (0x1f94c, 0x1f94c), (0x1f94d, 0x1f94f),
+    (0x1f950, 0x1f95e), (0x1f95f, 0x1f96b), (0x1f96c, 0x1f970), (0x1f973, 0x1f976),
+    (0x1f97a, 0x1f97a), (0x1f97c, 0x1f97f), (0x1f980, 0x1f984), (0x1f985, 0x1f991),
+    (0x1f992, 0x1f997), (0x1f998, 0x1f9a2), (0x1f9b0, 0x1f9b9), (0x1f9c0, 0x1f9c0),
+    (0x1f9c1, 0x1f9c2), (0x1f9d0, 0x1f9e6), (0x1f9e7, 0x1f9ff),
+]
+
+
+def classify():
+    classes = bytearray(MAX_UNICODE + 1)
+    # a later table overwrites an earlier one.
+    for table, class_id in ((EASTASIAN_AMBIGUOUS, AMBIGUOUS),
+                            (EMOJI_CJK, EMOJI),
+                            (EASTASIAN_FULL, FULL)):
+        for first, last in table:
+            classes[first:last + 1] = bytes([class_id]) * (last - first + 1)
+    return classes
+
+
+def build(classes):
+    block_size = 1 << SHIFT
+    blocks = {}
+    stage1 = []
+    stage2 = bytearray()
+    for first in range(0, MAX_UNICODE + 1, block_size):
+        block = bytes(classes[first:first + block_size])
+        if block not in blocks:
+            blocks[block] = len(blocks)
+            stage2 += block
+        stage1.append(blocks[block])
+    assert len(blocks) <= 256
+    return stage1, stage2
+
+
+def dump(name, values, per_line=16):
+    lines = ['M_UTF8_WIDTH_TABLE_CONST uint8_t %s[%d] = {' % (name, len(values))]
+    for i in range(0, len(values), per_line):
+        lines.append('    ' + ', '.join('%d' % v for v in values[i:i + per_line]) + ',')
+    lines.append('};')
+    return '\n'.join(lines)
+
+
+def main():
+    stage1, stage2 = build(classify())
+    print('/* generated by tools/mkwidth.py, do not edit. */')
+    print('#ifndef MUTF8_WIDTH_TABLE_H')
+    print('#define MUTF8_WIDTH_TABLE_H')
+    print()
+    print('#define M_UTF8_WIDTH_SHIFT %d' % SHIFT)
+    print('#define M_UTF8_WIDTH_MASK 0x%X' % ((1 << SHIFT) - 1))
+    print()
+    print('#define M_UTF8_WIDTH_NARROW %d' % NARROW)
+    print('#define M_UTF8_WIDTH_FULL %d' % FULL)
+    print('#define M_UTF8_WIDTH_AMBIGUOUS %d' % AMBIGUOUS)
+    print('#define M_UTF8_WIDTH_EMOJI %d' % EMOJI)
+    print('#define M_UTF8_WIDTH_CLASS_SIZE 4')
+    print()
+    print('/* constexpr in C++, so mutf8.hpp can read the tables at compile time. */')
+    print('#if defined(__cplusplus)')
+    print('#define M_UTF8_WIDTH_TABLE_CONST static constexpr')
+    print('#else')
+    print('#define M_UTF8_WIDTH_TABLE_CONST static const')
+    print('#endif')
+    print()
+    print('// clang-format off')
+    print(dump('m_utf8_width_stage1', stage1))
+    print()
+    print(dump('m_utf8_width_stage2', stage2, 32))
+    print('// clang-format on')
+    print()
+    print('#endif /* end MUTF8_WIDTH_TABLE_H */')
+
+
+if __name__ == '__main__':
+    main()